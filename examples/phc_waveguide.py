@@ -16,12 +16,10 @@ from gmes import *
 
 space = Cartesian(size=(16,8,0), resolution=20)
 geom_list = [DefaultMedium(material=Dielectric())]
-geom_list.extend([Cylinder(material=Dielectric(8.9),
-                           radius=0.38,
-                           center=(x,y,0))
-                  for x in xrange(-8, 9) 
-                  for y in xrange(-4, 5)
-                  if y != 0])
+geom_list.append(Lattice(Cylinder(material=Dielectric(8.9), radius=0.38),
+                         basis=((1,0,0), (0,1,0)),
+                         size=(16,8,0),
+                         removed=[(x,0) for x in xrange(-8, 9)]))
 geom_list.append(Shell(material=Cpml()))
 src_list = [PointSource(src_time=Continuous(freq=0.43),
                         component=Ez,
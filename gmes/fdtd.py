@@ -3,7 +3,10 @@
 
 from __future__ import division
 
+import os
 from sys import stderr
+from hashlib import sha1
+from cPickle import dumps, HIGHEST_PROTOCOL
 
 try:
     import psyco
@@ -13,23 +16,57 @@ except ImportError:
     pass
 
 from copy import deepcopy
-from math import sqrt
+from math import sqrt, ceil
 from cmath import exp as cexp
-from numpy import ndindex, arange, inf, array
+from numpy import ndindex, arange, inf, array, empty
 from datetime import datetime, timedelta
+from time import time
+from multiprocessing.pool import ThreadPool
 
 import numpy as np
 
 # GMES modules
-from geometry import GeomBoxTree, in_range, DefaultMedium
+from geometry import GeomBoxTree, in_range, DefaultMedium, CellCost
 from file_io import Probe
 #from file_io import write_hdf5, snapshot
 from show import ShowLine, ShowPlane, Snapshot
 from material import Dummy
+from pw_material import StepperReal, StepperCmplx
+from pw_material import StepperRealSingle, StepperCmplxSingle
+from pw_material import HaloReal, HaloCmplx, HaloRealSingle, HaloCmplxSingle
+from pw_source import PointSourceElectric, PointSourceMagnetic
 from pygeom import GeomBox
 from constant import *
 
 
+# format of the cached material ids, which is hashed into their key
+_material_cache_format = 1
+
+# native stepping loops by (cmplx, single) of the fields
+_stepper = {(False, False): StepperReal, (True, False): StepperCmplx,
+            (False, True): StepperRealSingle, (True, True): StepperCmplxSingle}
+
+# halo planes by (cmplx, single) of the fields
+_halo = {(False, False): HaloReal, (True, False): HaloCmplx,
+         (False, True): HaloRealSingle, (True, True): HaloCmplxSingle}
+
+# component numbers of the native stepping loop
+_compnt_idx = {Ex: 0, Ey: 1, Ez: 2, Hx: 3, Hy: 4, Hz: 5}
+
+# axes of the halo planes of each component, in the order of the 
+# talk_with_*_neighbors methods
+_halo_axes = {Ex: (1, 2), Ey: (2, 0), Ez: (0, 1),
+              Hx: (1, 2), Hy: (2, 0), Hz: (0, 1)}
+
+# field components read by the update of each component
+_in_compnt = {Ex: (Hz, Hy), Ey: (Hx, Hz), Ez: (Hy, Hx),
+              Hx: (Ez, Ey), Hy: (Ex, Ez), Hz: (Ey, Ex)}
+
+# maximum number of time steps of a native stepping loop call, which 
+# bounds the length of the source waveforms
+_max_native_steps = 4096
+
+
 class TimeStep(object):
     """Store the current time-step and time.
     
@@ -67,6 +104,9 @@ class FDTD(object):
     space -- geometry.Cartesian instance
     cmplx -- Boolean of whether field is complex. Determined by the 
         space.period.
+    single -- Boolean of whether field has single precision.
+    compnt_pool -- pool of the worker threads updating the field 
+        components, or None
     dr -- space differentials: dx, dy, dz
     dt -- time-step size
     courant_ratio -- the ratio of dt to Courant stability bound
@@ -78,10 +118,18 @@ class FDTD(object):
     hx, hy, hz -- arrays for the magnetic fields
     worker -- list of the update methods
     chatter -- list of the syncronizaion methods
+    rebalance_interval -- the number of time steps between the checks of
+        the load balance of the nodes, or None
+    rebalance_threshold -- the ratio of the longest update time of the 
+        nodes to their mean which triggers the rebalance
+    material_cache -- directory of the cached material ids, or None
 
     """
     def __init__(self, space=None, geom_list=None, src_list=None,
-                 courant_ratio=.99, dt=None, bloch=None, verbose=True):
+                 courant_ratio=.99, dt=None, bloch=None, single=False,
+                 compnt_threads=False, rebalance_interval=None,
+                 rebalance_threshold=1.2, material_cache=None, 
+                 verbose=True):
         """Constructor.
         
         Keyword arguments:
@@ -96,6 +144,23 @@ class FDTD(object):
         dt -- time-step size. If None is given, dt is calculated using space 
             differentials and courant_ratio. (default None)
         bloch -- Bloch wave vector (default None)
+        single -- whether the fields are stored and updated in single 
+            precision, i.e. float32 or complex64 (default False)
+        compnt_threads -- whether the electric field components, and then
+            the magnetic field components, are updated concurrently on 
+            worker threads (default False)
+        rebalance_interval -- the number of time steps between the checks
+            of the update times of the nodes. If the imbalance exceeds 
+            rebalance_threshold, the node boundaries move. None disables
+            the checks. See rebalance. (default None)
+        rebalance_threshold -- the ratio of the longest update time of 
+            the nodes to their mean which triggers the rebalance
+            (default 1.2)
+        material_cache -- directory in which the material ids of the
+            mesh points are kept for the later runs with the same
+            geometry, space, dt, and node decomposition. Those runs 
+            memory-map the ids instead of mapping the materials. 
+            None disables the cache. (default None)
         verbose -- whether it prints the details (default True)
 
         """
@@ -117,6 +182,15 @@ class FDTD(object):
 
         self.verbose = bool(verbose)
 
+        self.single = bool(single)
+
+        # The updates release the GIL, so that the components of a 
+        # field run in parallel. They depend only on the other field.
+        if compnt_threads:
+            self.compnt_pool = ThreadPool(3)
+        else:
+            self.compnt_pool = None
+
         self.space = space
                 
         self._fig_id = int(self.space.my_id)
@@ -166,6 +240,16 @@ class FDTD(object):
 
         if self.verbose:
             print 'done.'
+
+        if self.space.cost_aware and self.space.numprocs > 1:
+            if self.verbose:
+                print 'Balancing the nodes by the cell costs...',
+
+            self.space.balance(self._cell_cost())
+
+            if self.verbose:
+                print 'done.'
+                print 'node boundaries:', self.space.bounds
             
         if self.verbose:
             print 'The geometric tree follows...'
@@ -215,6 +299,18 @@ class FDTD(object):
                 so.display_info()
 
         self.pw_material = {}
+        self.halo = {}
+        self.overlap = False
+
+        if rebalance_interval is None or self.space.numprocs == 1:
+            self.rebalance_interval = None
+        else:
+            self.rebalance_interval = int(rebalance_interval)
+        self.rebalance_threshold = float(rebalance_threshold)
+        self.material_cache = material_cache
+        self._update_time = 0.0
+        self._balance_steps = 0
+        self._cost = None
 
     def init(self):
         """Initialize sources.
@@ -225,16 +321,8 @@ class FDTD(object):
         if self.verbose:
             print 'Allocating memory for the electromagnetic fields...',
             
-        # storage for the electromagnetic field 
-        self.ex = self.space.get_ex_storage(self.e_field_compnt, self.cmplx)
-        self.ey = self.space.get_ey_storage(self.e_field_compnt, self.cmplx)
-        self.ez = self.space.get_ez_storage(self.e_field_compnt, self.cmplx)
-        self.hx = self.space.get_hx_storage(self.h_field_compnt, self.cmplx)
-        self.hy = self.space.get_hy_storage(self.h_field_compnt, self.cmplx)
-        self.hz = self.space.get_hz_storage(self.h_field_compnt, self.cmplx)
-        
-        self.field = {Ex: self.ex, Ey: self.ey, Ez: self.ez,
-                      Hx: self.hx, Hy: self.hy, Hz: self.hz}
+        self._init_field()
+        self.init_halo()
 
         if self.verbose:
             print 'done.'
@@ -248,6 +336,13 @@ class FDTD(object):
             print 'This will take some times...'
 
         self.init_material()
+        self.bind_material()
+
+        # The halo exchange between nodes overlaps the update of the
+        # interior cells.
+        self.overlap = self.space.numprocs > 1
+        if self.overlap:
+            self.split_material()
         
         if self.verbose:
             print 'Mapping the pointwise source...',
@@ -259,6 +354,27 @@ class FDTD(object):
         et = datetime.now()
         print 'Elapsed time:', (et - st)
         
+    def _init_field(self):
+        """Allocate the field arrays of this node.
+
+        """
+        # storage for the electromagnetic field 
+        self.ex = self.space.get_ex_storage(self.e_field_compnt,
+                                            self.cmplx, self.single)
+        self.ey = self.space.get_ey_storage(self.e_field_compnt,
+                                            self.cmplx, self.single)
+        self.ez = self.space.get_ez_storage(self.e_field_compnt,
+                                            self.cmplx, self.single)
+        self.hx = self.space.get_hx_storage(self.h_field_compnt,
+                                            self.cmplx, self.single)
+        self.hy = self.space.get_hy_storage(self.h_field_compnt,
+                                            self.cmplx, self.single)
+        self.hz = self.space.get_hz_storage(self.h_field_compnt,
+                                            self.cmplx, self.single)
+        
+        self.field = {Ex: self.ex, Ey: self.ey, Ez: self.ez,
+                      Hx: self.hx, Hy: self.hy, Hz: self.hz}
+
     def _print_pw_obj(self, pw_obj):
         """Print information of the piecewise material and source.
 
@@ -331,8 +447,245 @@ class FDTD(object):
         newcopy.hz = np.array(self.hz)
         
         newcopy.time_step = deepcopy(self.time_step)
+        newcopy.bind_material()
         return newcopy
     	
+    def _cell_cost(self):
+        """Return the update cost of the cells of the whole space.
+
+        The cost of a cell is the cost attribute of the material at its
+        center, relative to a non-dispersive dielectric. A material 
+        without it costs one. Every node rasterizes an even slab of 
+        the space along the x-axis, so the cost is never made whole on
+        a node.
+
+        """
+        space = self.space
+        comm = space.cart_comm
+        geom_list = self.geom_tree.root.geom_list
+        mat_cost = array([getattr(g.material, 'cost', 1) for g in geom_list],
+                         np.double)
+
+        size = space.whole_field_size
+        axes = [(arange(size[i]) + .5) * space.dr[i] - space.half_size[i]
+                for i in xrange(3)]
+        x = space._even_bounds(size[0], comm.Get_size())
+        x0, x1 = x[comm.rank], x[comm.rank + 1]
+        runs = self.geom_tree.rasterize(axes[0][x0:x1], axes[1], axes[2])
+        runs[:, 0] += x0
+
+        return CellCost(size, runs[:, :4], mat_cost[runs[:, 4]], comm)
+
+    def _map_material(self, shape, comp, on_bndry, getter):
+        """Map the materials onto the mesh points of a field component.
+
+        The mesh points are grouped by their material ids, and each 
+        group is attached to a pw material in one batch. Return the pw
+        materials keyed by their type. Without the material cache, the
+        ids are made and grouped a slab of the mesh points at a time,
+        so that no id grid of the whole component is kept.
+        
+        Arguments:
+            shape -- shape of the field component
+            comp -- the field component
+            on_bndry -- whether the given indices, an N x 3 array, are 
+                not updated
+            getter -- name of the get_pw_material method of the component
+        
+        """
+        if self.material_cache is None or self._material_key is None:
+            table = []
+            slabs = self._material_id_slabs(shape, comp, on_bndry, table)
+        else:
+            ids, table = self._cached_material_ids(shape, comp, on_bndry)
+            slabs = (np.asarray(ids[i]).ravel() for i in xrange(shape[0]))
+
+        geom_list = self.geom_tree.root.geom_list
+        slab = np.indices((1,) + tuple(shape[1:]), np.intc).reshape(3, -1).T
+
+        groups = {}
+        keys = []
+        for i, slab_ids in enumerate(slabs):
+            indices = slab + array((i, 0, 0), np.intc)
+            coords = self.space.indices_to_space(comp, indices)
+
+            # the ids in the order of first appearance
+            uniq, first = np.unique(slab_ids, return_index=True)
+            for c in uniq[np.argsort(first)]:
+                member = slab_ids == c
+                obj, under, bndry = table[c]
+                mat_obj = geom_list[obj].material
+                if under < 0:
+                    underneath = None
+                else:
+                    underneath = geom_list[under].material
+
+                if bndry:
+                    key = (Dummy, mat_obj.eps_inf, mat_obj.mu_inf, 
+                           id(underneath))
+                else:
+                    key = (id(mat_obj), id(underneath))
+                    
+                if not groups.has_key(key):
+                    if bndry:
+                        mat_obj = Dummy(mat_obj.eps_inf, mat_obj.mu_inf)
+                    groups[key] = (mat_obj, underneath, [], [])
+                    keys.append(key)
+                groups[key][2].append(indices[member])
+                groups[key][3].append(coords[member])
+            
+        pw_material = {}
+        for key in keys:
+            mat_obj, underneath, indices, coords = groups.pop(key)
+            pw_obj = getattr(mat_obj, getter)(np.concatenate(indices), 
+                                              np.concatenate(coords), 
+                                              underneath, 
+                                              self.cmplx, self.single)
+            
+            if pw_material.has_key(type(pw_obj)):
+                pw_material[type(pw_obj)].merge(pw_obj)
+            else:
+                pw_material[type(pw_obj)] = pw_obj
+                
+        return pw_material
+
+    def _material_id_slabs(self, shape, comp, on_bndry, table):
+        """Generate the material ids of the mesh points of a field 
+        component, a slab of the mesh points at a time.
+
+        The materials are found by the rows of the mesh points with 
+        GeomBoxTree.rasterize, and expanded for a slab at a time. An 
+        id stands for an (object, underneath object, boundary) of the 
+        mesh points, which is its row of table. The underneath object 
+        is -1 for none. The rows of the new ids of a slab are appended
+        to table before the slab is generated.
+
+        Arguments:
+            shape -- shape of the field component
+            comp -- the field component
+            on_bndry -- whether the given indices, an N x 3 array, are 
+                not updated
+            table -- list of the rows of the ids found so far
+
+        """
+        geom_list = self.geom_tree.root.geom_list
+        slab = np.indices((1,) + tuple(shape[1:]), np.intc).reshape(3, -1).T
+
+        # The coordinates of the mesh points along each axis.
+        axes = []
+        for i in xrange(3):
+            axis_idx = np.zeros((shape[i], 3), np.intc)
+            axis_idx[:, i] = arange(shape[i])
+            axes.append(self.space.indices_to_space(comp, axis_idx)[:, i])
+        runs = self.geom_tree.rasterize(*axes)
+        slab_end = np.searchsorted(runs[:, 0], arange(shape[0] + 1))
+
+        # Code the (object, underneath object, boundary) of each mesh 
+        # point by one integer, and number the codes as they appear.
+        obj_num = len(geom_list) + 1
+        id_of = {}
+        for i in xrange(shape[0]):
+            indices = slab + array((i, 0, 0), np.intc)
+            slab_runs = runs[slab_end[i]:slab_end[i + 1]]
+            length = slab_runs[:, 3] - slab_runs[:, 2]
+            obj = np.repeat(slab_runs[:, 4].astype(np.int64), length)
+            under = np.repeat(slab_runs[:, 5], length)
+            bndry = on_bndry(indices)
+            code = (obj * obj_num + under + 1) * 2 + bndry
+            uniq, inverse = np.unique(code, return_inverse=True)
+            slab_ids = []
+            for c in uniq.tolist():
+                if not id_of.has_key(c):
+                    id_of[c] = len(table)
+                    table.append((c // 2 // obj_num, c // 2 % obj_num - 1, 
+                                  c % 2))
+                slab_ids.append(id_of[c])
+            yield array(slab_ids, np.intc)[inverse]
+
+    def _material_ids(self, shape, comp, on_bndry):
+        """Return the material ids of _material_id_slabs as a grid of 
+        the mesh points, and the table of the ids as an array.
+
+        The grid takes the smallest unsigned type which holds the ids,
+        and is widened only when the ids outgrow it.
+
+        """
+        table = []
+        ids = np.empty(shape, np.uint8)
+        slabs = self._material_id_slabs(shape, comp, on_bndry, table)
+        for i, slab_ids in enumerate(slabs):
+            id_type = np.min_scalar_type(max(len(table) - 1, 0))
+            if not np.can_cast(id_type, ids.dtype):
+                ids = ids.astype(id_type)
+            ids[i] = slab_ids.reshape(shape[1:])
+
+        return ids, array(table, np.intc).reshape(-1, 3)
+
+    def _material_cache_key(self):
+        """Return the hash of what the material ids depend on, or None 
+        if the geometry list can not be pickled.
+
+        """
+        space = self.space
+        try:
+            state = dumps((_material_cache_format, self.geom_list, 
+                           space.res.tolist(), space.half_size.tolist(), 
+                           self.time_step.dt, space.numprocs, 
+                           space.bounds), HIGHEST_PROTOCOL)
+        except Exception, e:
+            print >>stderr, 'Cannot hash the geometry list:', e
+            return None
+
+        return sha1(state).hexdigest()
+
+    def _cached_material_ids(self, shape, comp, on_bndry):
+        """Return the material ids of _material_ids from the cache 
+        directory, or map them and keep them there.
+
+        A field component of a node has two files named by the key of 
+        the mapping: the ids, which are memory-mapped, and the table.
+
+        """
+        prefix = os.path.join(self.material_cache, '%s-%d-%s' % 
+                              (self._material_key, self.space.my_id, 
+                               comp.__name__))
+        ids_file, table_file = prefix + '.npy', prefix + '-table.npy'
+
+        if os.path.exists(ids_file):
+            try:
+                ids = np.load(ids_file, mmap_mode='r')
+                table = np.load(table_file)
+                if ids.shape == tuple(shape):
+                    return ids, table
+            except (IOError, ValueError), e:
+                print >>stderr, 'Cannot read the material cache:', e
+
+        ids, table = self._material_ids(shape, comp, on_bndry)
+
+        # The files are renamed into place after they are written, so
+        # that a run never reads a partial file. The ids go last since
+        # they flag the complete pair.
+        try:
+            if not os.path.isdir(self.material_cache):
+                try:
+                    os.makedirs(self.material_cache)
+                except OSError:
+                    # made by another node in the meantime
+                    if not os.path.isdir(self.material_cache):
+                        raise
+            for name, a in ((table_file, table), (ids_file, ids)):
+                tmp = '%s.%d.tmp' % (name, os.getpid())
+                f = open(tmp, 'wb')
+                try:
+                    np.save(f, a)
+                finally:
+                    f.close()
+                os.rename(tmp, name)
+        except (IOError, OSError), e:
+            print >>stderr, 'Cannot write the material cache:', e
+
+        return ids, table
+
     def init_material_ex(self):
         """Set up the update mechanism for Ex field.
         
@@ -340,19 +693,13 @@ class FDTD(object):
         at self.pw_material[Ex].
         
         """
-        self.pw_material[Ex] = {}
         shape = self.ex.shape
-        for idx in ndindex(shape):
-            spc = self.space.ex_index_to_space(*idx)
-            mat_obj, underneath = self.geom_tree.material_of_point(spc)
-            if idx[1] == shape[1] - 1 or idx[2] == shape[2] - 1:
-                mat_obj = Dummy(mat_obj.eps_inf, mat_obj.mu_inf)
-            pw_obj = mat_obj.get_pw_material_ex(idx, spc, underneath, self.cmplx)
-            
-            if self.pw_material[Ex].has_key(type(pw_obj)):
-                self.pw_material[Ex][type(pw_obj)].merge(pw_obj)
-            else:
-                self.pw_material[Ex][type(pw_obj)] = pw_obj
+        def on_bndry(idx):
+            return (idx[:, 1] == shape[1] - 1) | (idx[:, 2] == shape[2] - 1)
+        
+        self.pw_material[Ex] = \
+            self._map_material(shape, Ex,
+                               on_bndry, 'get_pw_material_ex')
 
     def init_material_ey(self):
         """Set up the update mechanism for Ey field.
@@ -361,19 +708,13 @@ class FDTD(object):
         at self.pw_material[Ey].
         
         """
-        self.pw_material[Ey] = {}
         shape = self.ey.shape
-        for idx in ndindex(shape):
-            spc = self.space.ey_index_to_space(*idx)
-            mat_obj, underneath = self.geom_tree.material_of_point(spc)
-            if idx[2] == shape[2] - 1 or idx[0] == shape[0] - 1:
-                mat_obj = Dummy(mat_obj.eps_inf, mat_obj.mu_inf)
-            pw_obj = mat_obj.get_pw_material_ey(idx, spc, underneath, self.cmplx)
-
-            if self.pw_material[Ey].has_key(type(pw_obj)):
-                self.pw_material[Ey][type(pw_obj)].merge(pw_obj)
-            else:
-                self.pw_material[Ey][type(pw_obj)] = pw_obj
+        def on_bndry(idx):
+            return (idx[:, 2] == shape[2] - 1) | (idx[:, 0] == shape[0] - 1)
+        
+        self.pw_material[Ey] = \
+            self._map_material(shape, Ey,
+                               on_bndry, 'get_pw_material_ey')
 
     def init_material_ez(self):
         """Set up the update mechanism for Ez field.
@@ -382,19 +723,13 @@ class FDTD(object):
         at self.pw_material[Ez].
         
         """
-        self.pw_material[Ez] = {}
         shape = self.ez.shape
-        for idx in ndindex(shape):
-            spc = self.space.ez_index_to_space(*idx)
-            mat_obj, underneath = self.geom_tree.material_of_point(spc)
-            if idx[0] == shape[0] - 1 or idx[1] == shape[1] - 1:
-                mat_obj = Dummy(mat_obj.eps_inf, mat_obj.mu_inf)
-            pw_obj = mat_obj.get_pw_material_ez(idx, spc, underneath, self.cmplx)
-
-            if self.pw_material[Ez].has_key(type(pw_obj)):
-                self.pw_material[Ez][type(pw_obj)].merge(pw_obj)
-            else:
-                self.pw_material[Ez][type(pw_obj)] = pw_obj
+        def on_bndry(idx):
+            return (idx[:, 0] == shape[0] - 1) | (idx[:, 1] == shape[1] - 1)
+        
+        self.pw_material[Ez] = \
+            self._map_material(shape, Ez,
+                               on_bndry, 'get_pw_material_ez')
 
     def init_material_hx(self):
         """Set up the update mechanism for Hx field.
@@ -403,19 +738,13 @@ class FDTD(object):
         at self.pw_material[Hx].
         
         """
-        self.pw_material[Hx] = {}
         shape = self.hx.shape
-        for idx in ndindex(shape):
-            spc = self.space.hx_index_to_space(*idx)
-            mat_obj, underneath = self.geom_tree.material_of_point(spc)
-            if idx[1] == 0 or idx[2] == 0:
-                mat_obj = Dummy(mat_obj.eps_inf, mat_obj.mu_inf)
-            pw_obj = mat_obj.get_pw_material_hx(idx, spc, underneath, self.cmplx)
-
-            if self.pw_material[Hx].has_key(type(pw_obj)):
-                self.pw_material[Hx][type(pw_obj)].merge(pw_obj)
-            else:
-                self.pw_material[Hx][type(pw_obj)] = pw_obj
+        def on_bndry(idx):
+            return (idx[:, 1] == 0) | (idx[:, 2] == 0)
+        
+        self.pw_material[Hx] = \
+            self._map_material(shape, Hx,
+                               on_bndry, 'get_pw_material_hx')
 
     def init_material_hy(self):
         """Set up the update mechanism for Hy field.
@@ -424,19 +753,13 @@ class FDTD(object):
         at self.pw_material[Hy].
         
         """
-        self.pw_material[Hy] = {}
         shape = self.hy.shape
-        for idx in ndindex(shape):
-            spc = self.space.hy_index_to_space(*idx)
-            mat_obj, underneath = self.geom_tree.material_of_point(spc)
-            if idx[2] == 0 or idx[0] == 0:
-                mat_obj = Dummy(mat_obj.eps_inf, mat_obj.mu_inf)
-            pw_obj = mat_obj.get_pw_material_hy(idx, spc, underneath, self.cmplx)
-
-            if self.pw_material[Hy].has_key(type(pw_obj)):
-                self.pw_material[Hy][type(pw_obj)].merge(pw_obj)
-            else:
-                self.pw_material[Hy][type(pw_obj)] = pw_obj
+        def on_bndry(idx):
+            return (idx[:, 2] == 0) | (idx[:, 0] == 0)
+        
+        self.pw_material[Hy] = \
+            self._map_material(shape, Hy,
+                               on_bndry, 'get_pw_material_hy')
 
     def init_material_hz(self):
         """Set up the update mechanism for Hz field.
@@ -445,21 +768,18 @@ class FDTD(object):
         at self.pw_material[Hz].
         
         """
-        self.pw_material[Hz] = {}
         shape = self.hz.shape
-        for idx in ndindex(shape):
-            spc = self.space.hz_index_to_space(*idx)
-            mat_obj, underneath = self.geom_tree.material_of_point(spc)
-            if idx[0] == 0 or idx[1] == 0:
-                mat_obj = Dummy(mat_obj.eps_inf, mat_obj.mu_inf)
-            pw_obj = mat_obj.get_pw_material_hz(idx, spc, underneath, self.cmplx)
-
-            if self.pw_material[Hz].has_key(type(pw_obj)):
-                self.pw_material[Hz][type(pw_obj)].merge(pw_obj)
-            else:
-                self.pw_material[Hz][type(pw_obj)] = pw_obj
+        def on_bndry(idx):
+            return (idx[:, 0] == 0) | (idx[:, 1] == 0)
+        
+        self.pw_material[Hz] = \
+            self._map_material(shape, Hz,
+                               on_bndry, 'get_pw_material_hz')
 
     def init_material(self):
+        if self.material_cache is not None:
+            self._material_key = self._material_cache_key()
+
         init_mat_func = {Ex: self.init_material_ex,
                          Ey: self.init_material_ey,
                          Ez: self.init_material_ez,
@@ -483,6 +803,48 @@ class FDTD(object):
             if self.verbose:
                 self._print_pw_obj(self.pw_material[comp])
 
+    def bind_material(self):
+        """Bind the pw materials to the field arrays of their update.
+
+        The bound arrays are passed to the extension once, so that the
+        update of each time step does not convert them again.
+
+        """
+        self._update_args = \
+            {Ex: (self.ex, self.hz, self.hy, self.dy, self.dz),
+             Ey: (self.ey, self.hx, self.hz, self.dz, self.dx),
+             Ez: (self.ez, self.hy, self.hx, self.dx, self.dy),
+             Hx: (self.hx, self.ez, self.ey, self.dy, self.dz),
+             Hy: (self.hy, self.ex, self.ez, self.dz, self.dx),
+             Hz: (self.hz, self.ey, self.ex, self.dx, self.dy)}
+
+        for comp in self.pw_material:
+            args = self._update_args[comp] + (self.time_step.dt,)
+            for pw_obj in self.pw_material[comp].itervalues():
+                pw_obj.bind(*args)
+
+    def split_material(self):
+        """Split the cells of the pw materials into the interior and the
+        boundary shell.
+
+        The shell is one cell deep at both ends of every axis along which
+        a field read by the update has a halo plane. The interior cells 
+        thus read no halo plane.
+
+        """
+        for comp in self.pw_material:
+            lo = [0, 0, 0]
+            hi = list(self.field[comp].shape)
+            for in_comp in _in_compnt[comp]:
+                in_shape = self.field[in_comp].shape
+                for axis in (h[0] for h in self.halo.get(in_comp, ())):
+                    lo[axis] = 1
+                    hi[axis] = min(hi[axis], in_shape[axis] - 1)
+
+            lo, hi = array(lo, np.intc), array(hi, np.intc)
+            for pw_obj in self.pw_material[comp].itervalues():
+                pw_obj.split(lo, hi)
+
     def init_source_ex(self):
         self.pw_source[Ex] = {}
         for so in self.src_list:
@@ -646,8 +1008,7 @@ class FDTD(object):
 
     def update_ex(self):
         for pw_obj in self.pw_material[Ex].itervalues():
-            pw_obj.update_all(self.ex, self.hz, self.hy, self.dy, self.dz, 
-                              self.time_step.dt, self.time_step.n)
+            pw_obj.update_bound(self.time_step.n)
 
         for pw_obj in self.pw_source[Ex].itervalues():
             pw_obj.update_all(self.ex, self.hz, self.hy, self.dy, self.dz, 
@@ -655,8 +1016,7 @@ class FDTD(object):
         
     def update_ey(self):
         for pw_obj in self.pw_material[Ey].itervalues():
-            pw_obj.update_all(self.ey, self.hx, self.hz, self.dz, self.dx,
-                              self.time_step.dt, self.time_step.n)
+            pw_obj.update_bound(self.time_step.n)
 		
         for pw_obj in self.pw_source[Ey].itervalues():
             pw_obj.update_all(self.ey, self.hx, self.hz, self.dz, self.dx,
@@ -664,8 +1024,7 @@ class FDTD(object):
 
     def update_ez(self):
         for pw_obj in self.pw_material[Ez].itervalues():
-            pw_obj.update_all(self.ez, self.hy, self.hx, self.dx, self.dy,
-                              self.time_step.dt, self.time_step.n)
+            pw_obj.update_bound(self.time_step.n)
 
         for pw_obj in self.pw_source[Ez].itervalues():
             pw_obj.update_all(self.ez, self.hy, self.hx, self.dx, self.dy,
@@ -673,8 +1032,7 @@ class FDTD(object):
         
     def update_hx(self):
         for pw_obj in self.pw_material[Hx].itervalues():
-            pw_obj.update_all(self.hx, self.ez, self.ey, self.dy, self.dz, 
-                              self.time_step.dt, self.time_step.n)
+            pw_obj.update_bound(self.time_step.n)
 
         for pw_obj in self.pw_source[Hx].itervalues():
             pw_obj.update_all(self.hx, self.ez, self.ey, self.dy, self.dz, 
@@ -682,8 +1040,7 @@ class FDTD(object):
 		
     def update_hy(self):
         for pw_obj in self.pw_material[Hy].itervalues():
-            pw_obj.update_all(self.hy, self.ex, self.ez, self.dz, self.dx,
-                              self.time_step.dt, self.time_step.n)
+            pw_obj.update_bound(self.time_step.n)
 
         for pw_obj in self.pw_source[Hy].itervalues():
             pw_obj.update_all(self.hy, self.ex, self.ez, self.dz, self.dx,
@@ -691,297 +1048,198 @@ class FDTD(object):
 		
     def update_hz(self):
         for pw_obj in self.pw_material[Hz].itervalues():
-            pw_obj.update_all(self.hz, self.ey, self.ex, self.dx, self.dy, 
-                              self.time_step.dt, self.time_step.n)
+            pw_obj.update_bound(self.time_step.n)
 
         for pw_obj in self.pw_source[Hz].itervalues():
             pw_obj.update_all(self.hz, self.ey, self.ex, self.dx, self.dy, 
                               self.time_step.dt, self.time_step.n)
 
+    def init_halo(self):
+        """Prepare the halo exchange of the field components.
+
+        Each halo plane gets a Halo object with its Bloch phase, and the
+        contiguous send and receive buffers of the plane. The electric
+        fields receive from the +axis direction and the magnetic fields
+        from the -axis direction.
+
+        """
+        idx_to_spc = {Ex: self.space.ex_index_to_space,
+                      Ey: self.space.ey_index_to_space,
+                      Ez: self.space.ez_index_to_space,
+                      Hx: self.space.hx_index_to_space,
+                      Hy: self.space.hy_index_to_space,
+                      Hz: self.space.hz_index_to_space}
+
+        comm = self.space.cart_comm
+        for comp in self.e_field_compnt + self.h_field_compnt:
+            self.halo[comp] = []
+            field = self.field[comp]
+            for axis in _halo_axes[comp]:
+                last = [0, 0, 0]
+                last[axis] = field.shape[axis] - 1
+
+                if comp in self.e_field_compnt:
+                    src, dest = comm.Shift(axis, -1)
+                    from_idx, to_idx = (0, 0, 0), last
+                else:
+                    src, dest = comm.Shift(axis, 1)
+                    from_idx, to_idx = last, (0, 0, 0)
+                if dest == -1 or src == -1:
+                    continue
+
+                # The coordinate of the plane sent by the neighbor is 
+                # exchanged once, here.
+                if self.cmplx:
+                    src_spc = idx_to_spc[comp](*from_idx)[axis]
+                    src_spc = comm.sendrecv(src_spc, dest, comp.tag,
+                                            None, src, comp.tag)
+                    dest_spc = idx_to_spc[comp](*to_idx)[axis]
+                    phase_shift = cexp(1j * self.bloch[axis] * 
+                                       (dest_spc - src_spc))
+                else:
+                    phase_shift = 1
+                
+                halo = _halo[self.cmplx, self.single](axis, from_idx[axis],
+                                                      to_idx[axis], 
+                                                      phase_shift)
+                plane = list(field.shape)
+                del plane[axis]
+                sendbuf = np.empty(plane[0] * plane[1], field.dtype)
+                recvbuf = np.empty_like(sendbuf)
+                self.halo[comp].append((axis, halo, src, dest, 
+                                        sendbuf, recvbuf))
+
+    def _talk_with_neighbors(self, comp):
+        """Synchronize the halo planes of comp.
+
+        The planes are packed into contiguous buffers and sent through
+        the buffer interface of MPI4Python.
+
+        """
+        field = self.field[comp]
+        for axis, halo, src, dest, sendbuf, recvbuf in self.halo[comp]:
+            halo.pack(field, sendbuf)
+            self.space.cart_comm.Sendrecv(sendbuf, dest, comp.tag,
+                                          recvbuf, src, comp.tag)
+            halo.unpack(field, recvbuf)
+
+    def _post_halo(self, comp):
+        """Start the exchange of the halo planes of comp.
+
+        Return the pending exchanges for self._finish_halo().
+
+        """
+        field = self.field[comp]
+        comm = self.space.cart_comm
+        pending = []
+        for axis, halo, src, dest, sendbuf, recvbuf in self.halo[comp]:
+            halo.pack(field, sendbuf)
+            pending.append((comm.Irecv(recvbuf, src, comp.tag),
+                            comm.Isend(sendbuf, dest, comp.tag),
+                            halo, recvbuf))
+        return pending
+
+    def _finish_halo(self, comp, pending):
+        """Wait for the exchanges of self._post_halo() and unpack the
+        received halo planes of comp.
+
+        """
+        field = self.field[comp]
+        for recv, send, halo, recvbuf in pending:
+            recv.Wait()
+            send.Wait()
+            halo.unpack(field, recvbuf)
+
     def talk_with_ex_neighbors(self):
         """Synchronize ex data.
         
-        This method uses the object serialization interface of MPI4Python.
-        
         """
-        # Send ex field data to -y direction and receive from +y direction.
-        src, dest = self.space.cart_comm.Shift(1, -1)
-        if dest == -1 or src == -1:
-            return
+        self._talk_with_neighbors(Ex)
 
-        if self.cmplx:
-            dest_spc = self.space.ex_index_to_space(0, self.ex.shape[1] - 1, 0)[1]
-        
-            src_spc = self.space.ex_index_to_space(0, 0, 0)[1]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Ex.tag,
-                                                    None, src, Ex.tag)
-            
-            phase_shift = cexp(1j * self.bloch[1] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.ex[:, -1, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.ex[:, 0, :], dest, Ex.tag,
-                                      None, src, Ex.tag)
-        
-        # Send ex field data to -z direction and receive from +z direction.
-        src, dest = self.space.cart_comm.Shift(2, -1)
-        if dest == -1 or src == -1:
-            return
-        
-        if self.cmplx:
-            dest_spc = self.space.ex_index_to_space(0, 0, self.ex.shape[2] - 1)[2]
-        
-            src_spc = self.space.ex_index_to_space(0, 0, 0)[2]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Ex.tag,
-                                                    None, src, Ex.tag)
-        
-            phase_shift = cexp(1j * self.bloch[2] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.ex[:, :, -1] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.ex[:, :, 0], dest, Ex.tag,
-                                      None, src, Ex.tag)
-        
     def talk_with_ey_neighbors(self):
         """Synchronize ey data.
         
-        This method uses the object serialization interface of MPI4Python.
-        
         """
-        # Send ey field data to -z direction and receive from +z direction.
-        src, dest = self.space.cart_comm.Shift(2, -1)
-        if dest == -1 or src == -1:
-            return
-        
-        if self.cmplx:
-            dest_spc = self.space.ey_index_to_space(0, 0, self.ey.shape[2] - 1)[2]
-        
-            src_spc = self.space.ey_index_to_space(0, 0, 0)[2]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Ey.tag,
-                                                    None, src, Ey.tag) 
-        
-            phase_shift = cexp(1j * self.bloch[2] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-            
-        self.ey[:, :, -1] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.ey[:, :, 0], dest, Ey.tag,
-                                      None, src, Ey.tag)
-        
-        # Send ey field data to -x direction and receive from +x direction.
-        src, dest = self.space.cart_comm.Shift(0, -1)
-        if dest == -1 or src == -1:
-            return
+        self._talk_with_neighbors(Ey)
 
-        if self.cmplx:
-            dest_spc = self.space.ey_index_to_space(self.ey.shape[0] - 1, 0, 0)[0]
-        
-            src_spc = self.space.ey_index_to_space(0, 0, 0)[0]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Ey.tag,
-                                                    None, src, Ey.tag)
-            
-            phase_shift = cexp(1j * self.bloch[0] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-            
-        self.ey[-1, :, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.ey[0, :, :], dest, Ey.tag,
-                                      None, src, Ey.tag)
-        
     def talk_with_ez_neighbors(self):
         """Synchronize ez data.
         
-        This method uses the object serialization interface of MPI4Python.
-        
         """
-        # Send ez field data to -x direction and receive from +x direction.
-        src, dest = self.space.cart_comm.Shift(0, -1)
-        if dest == -1 or src == -1:
-            return
-        
-        if self.cmplx:
-            dest_spc = self.space.ez_index_to_space(self.ez.shape[0] - 1, 0, 0)[0]
-        
-            src_spc = self.space.ez_index_to_space(0, 0, 0)[0]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Ez.tag,
-                                                    None, src, Ez.tag) 
-            
-            phase_shift = cexp(1j * self.bloch[0] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.ez[-1, :, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.ez[0, :, :], dest, Ez.tag,
-                                      None, src, Ez.tag)
-        
-        # Send ez field data to -y direction and receive from +y direction.
-        src, dest = self.space.cart_comm.Shift(1, -1)
-        if dest == -1 or src == -1:
-            return
+        self._talk_with_neighbors(Ez)
 
-        if self.cmplx:
-            dest_spc = self.space.ez_index_to_space(0, self.ez.shape[1] - 1, 0)[1]
-        
-            src_spc = self.space.ez_index_to_space(0, 0, 0)[1]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Ez.tag,
-                                                    None, src, Ez.tag) 
-            
-            phase_shift = cexp(1j * self.bloch[1] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-
-        self.ez[:, -1, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.ez[:, 0, :], dest, Ez.tag,
-                                      None, src, Ez.tag)
-        
     def talk_with_hx_neighbors(self):
         """Synchronize hx data.
         
-        This method uses the object serialization interface of MPI4Python.
-        
         """
-        # Send hx field data to +y direction and receive from -y direction.
-        src, dest = self.space.cart_comm.Shift(1, 1)
-        if dest == -1 or src == -1:
-            return
+        self._talk_with_neighbors(Hx)
 
-        if self.cmplx:
-            dest_spc = self.space.hx_index_to_space(0, 0, 0)[1]
-        
-            src_spc = self.space.hx_index_to_space(0, self.hx.shape[1] - 1, 0)[1]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Hx.tag,
-                                                    None, src, Hx.tag)
-        
-            phase_shift = cexp(1j * self.bloch[1] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.hx[:, 0, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.hx[:, -1, :], dest, Hx.tag,
-                                      None, src, Hx.tag)
-            
-        # Send hx field data to +z direction and receive from -z direction.    
-        src, dest = self.space.cart_comm.Shift(2, 1)
-        if dest == -1 or src == -1:
-            return
-        
-        if self.cmplx:
-            dest_spc = self.space.hx_index_to_space(0, 0, 0)[2]
-        
-            src_spc = self.space.hx_index_to_space(0, 0, self.hx.shape[2] - 1)[2]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Hx.tag,
-                                                    None, src, Hx.tag)
-        
-            phase_shift = cexp(1j * self.bloch[2] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.hx[:, :, 0] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.hx[:, :, -1], dest, Hx.tag,
-                                      None, src, Hx.tag)
-            
     def talk_with_hy_neighbors(self):
         """Synchronize hy data.
         
-        This method uses the object serialization interface of MPI4Python.
-        
         """
-        # Send hy field data to +z direction and receive from -z direction.
-        src, dest = self.space.cart_comm.Shift(2, 1)
-        if dest == -1 or src == -1:
-            return
-        
-        if self.cmplx:
-            dest_spc = self.space.hy_index_to_space(0, 0, 0)[2]
-        
-            src_spc = self.space.hy_index_to_space(0, 0, self.hy.shape[2] - 1)[2]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Hy.tag,
-                                                    None, src, Hy.tag)
-        
-            phase_shift = cexp(1j * self.bloch[2] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.hy[:, :, 0] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.hy[:, :, -1], dest, Hy.tag,
-                                      None, src, Hy.tag)
-            
-        # Send hy field data to +x direction and receive from -x direction.
-        src, dest = self.space.cart_comm.Shift(0, 1)
-        if dest == -1 or src == -1:
-            return
-        
-        if self.cmplx:
-            dest_spc = self.space.hy_index_to_space(0, 0, 0)[0]
-        
-            src_spc = self.space.hy_index_to_space(self.hy.shape[0] - 1, 0, 0)[0]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Hy.tag,
-                                                    None, src, Hy.tag)
-        
-            phase_shift = cexp(1j * self.bloch[0] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.hy[0, :, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.hy[-1, :, :], dest, Hy.tag,
-                                      None, src, Hy.tag)
-            
+        self._talk_with_neighbors(Hy)
+
     def talk_with_hz_neighbors(self):
         """Synchronize hz data.
         
-        This method uses the object serialization interface of MPI4Python.
-        
         """
-        # Send hz field data to +x direction and receive from -x direction.
-        src, dest = self.space.cart_comm.Shift(0, 1)
-        if dest == -1 or src == -1:
-            return
-        
-        if self.cmplx:
-            dest_spc = self.space.hz_index_to_space(0, 0, 0)[0]
-        
-            src_spc = self.space.hz_index_to_space(self.hz.shape[0] - 1, 0, 0)[0]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Hz.tag,
-                                                    None, src, Hz.tag)
+        self._talk_with_neighbors(Hz)
         
-            phase_shift = cexp(1j * self.bloch[0] * (dest_spc - src_spc))
+    def _update_compnt(self, compnt, update=None):
+        """Update the field components in compnt.
+
+        update(comp) updates a component, self._updater by default.
+
+        """
+        if update is None:
+            update = lambda comp: self._updater[comp]()
+
+        start = time()
+        if self.compnt_pool is None:
+            for comp in compnt:
+                update(comp)
         else:
-            phase_shift = 1
-        
-        self.hz[0, :, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.hz[-1, :, :], dest, Hz.tag,
-                                      None, src, Hz.tag)
-            
-        # Send hz field data to +y direction and receive from -y direction.
-        src, dest = self.space.cart_comm.Shift(1, 1)
-        if dest == -1 or src == -1:
+            self.compnt_pool.map(update, compnt)
+        self._update_time += time() - start
+
+    def _update_interior(self, comp):
+        for pw_obj in self.pw_material[comp].itervalues():
+            pw_obj.update_interior(self.time_step.n)
+
+    def _update_shell(self, comp):
+        for pw_obj in self.pw_material[comp].itervalues():
+            pw_obj.update_shell(self.time_step.n)
+
+        args = self._update_args[comp] + (self.time_step.dt, 
+                                          self.time_step.n)
+        for pw_obj in self.pw_source[comp].itervalues():
+            pw_obj.update_all(*args)
+
+    def _talk_and_update(self, talk_compnt, update_compnt):
+        """Exchange the halo planes of talk_compnt and update the
+        components in update_compnt.
+
+        With self.overlap, the interior cells are updated while the
+        halo planes are on the way.
+
+        """
+        if not self.overlap:
+            for comp in talk_compnt:
+                self._chatter[comp]()
+            self._update_compnt(update_compnt)
             return
-        
-        if self.cmplx:
-            dest_spc = self.space.hz_index_to_space(0, 0, 0)[1]
-        
-            src_spc = self.space.hz_index_to_space(0, self.hz.shape[1] - 1, 0)[1]
-            src_spc = self.space.cart_comm.sendrecv(src_spc, dest, Hz.tag,
-                                                    None, src, Hz.tag)
-        
-            phase_shift = cexp(1j * self.bloch[1] * (dest_spc - src_spc))
-        else:
-            phase_shift = 1
-        
-        self.hz[:, 0, :] = phase_shift * \
-        self.space.cart_comm.sendrecv(self.hz[:, -1, :], dest, Hz.tag,
-                                      None, src, Hz.tag)
-        
+
+        pending = [(comp, self._post_halo(comp)) for comp in talk_compnt]
+        self._update_compnt(update_compnt, self._update_interior)
+        for comp, exchanges in pending:
+            self._finish_halo(comp, exchanges)
+        self._update_compnt(update_compnt, self._update_shell)
+
     def step(self):
         self.time_step.half_step_up()
 
-        for comp in self.h_field_compnt:
-            self._chatter[comp]()
-            
-        for comp in self.e_field_compnt:
-            self._updater[comp]()
+        self._talk_and_update(self.h_field_compnt, self.e_field_compnt)
 
         for probe in self.e_recorder:
             probe.write(self.time_step.n)
@@ -990,15 +1248,296 @@ class FDTD(object):
 
         self._step_aux_fdtd()
 
-        for comp in self.e_field_compnt:
-            self._chatter[comp]()
-        
-        for comp in self.h_field_compnt:
-            self._updater[comp]()
+        self._talk_and_update(self.e_field_compnt, self.h_field_compnt)
 
         for probe in self.h_recorder:
             probe.write(self.time_step.n)
 
+        if self.rebalance_interval is not None:
+            self._balance_steps += 1
+            if self._balance_steps >= self.rebalance_interval:
+                self._balance_steps = 0
+                self.rebalance()
+
+    def _owned_box(self, comp, bounds, coords):
+        """Return the global index ranges of the mesh points of comp 
+        updated by the node at coords, when the nodes are split at 
+        bounds.
+
+        The halo planes of the electric fields are at the top of their
+        arrays and those of the magnetic fields at the bottom, so the
+        ranges of the magnetic fields are one point up along their halo
+        axes.
+
+        """
+        lo = [bounds[i][coords[i]] for i in xrange(3)]
+        hi = [bounds[i][coords[i] + 1] for i in xrange(3)]
+        if comp in self.h_field_compnt:
+            for axis in _halo_axes[comp]:
+                lo[axis] += 1
+                hi[axis] += 1
+        return lo, hi
+
+    def rebalance(self):
+        """Move the node boundaries by the measured update times.
+
+        The update times of the nodes since the last call are gathered.
+        If the longest exceeds rebalance_threshold times their mean, the
+        update cost of the cells of each node is scaled by its measured
+        time over its predicted cost, and the nodes are split again by 
+        the scaled cost with the node topology kept. The fields and the
+        state of the pw materials, e.g. the auxiliary fields of the 
+        dispersive materials, move to their new nodes, and the rest is 
+        mapped again. The scaled cost, which holds the cells of the 
+        slab of this node only, is kept for the next call.
+
+        The probes keep the indices and the field arrays of their nodes,
+        so a run with probes is not rebalanced: the first call warns 
+        and turns off the later checks.
+
+        """
+        space = self.space
+        comm = space.cart_comm
+        elapsed, self._update_time = self._update_time, 0.0
+
+        times = array(comm.allgather(elapsed))
+        probes = comm.allgather(bool(self.e_recorder or self.h_recorder))
+        if any(probes):
+            if space.my_id == 0:
+                print >>stderr, 'Rebalance is disabled with the probes.'
+            self.rebalance_interval = None
+            return
+
+        if times.max() <= self.rebalance_threshold * times.mean():
+            return
+
+        if self._cost is None:
+            self._cost = self._cell_cost()
+        cost = self._cost
+
+        coords = [tuple(comm.Get_coords(r)) for r in xrange(comm.size)]
+        old_bounds = space.bounds
+        predicted = cost.block_sums(old_bounds)
+        factor = np.ones(predicted.shape)
+        for r in xrange(comm.size):
+            if predicted[coords[r]] > 0 and times[r] > 0:
+                factor[coords[r]] = times[r] / predicted[coords[r]]
+        cost.scale(old_bounds, factor)
+
+        dims = comm.topo[0]
+        new_bounds = space.balanced_bounds(dims, cost)
+        if all(np.all(o == n) for o, n in zip(old_bounds, new_bounds)):
+            return
+
+        if self.verbose:
+            print 'Rebalancing the nodes...',
+
+        self._migrate(new_bounds, coords)
+
+        if self.verbose:
+            print 'done.'
+            print 'node boundaries:', space.bounds
+
+    def _migrate(self, new_bounds, coords):
+        """Split the nodes at new_bounds.
+
+        The fields and the state of the pw materials move to their new
+        nodes, and the rest is mapped again.
+
+        Keyword arguments:
+        new_bounds -- the node boundaries along each axis
+        coords -- the coordinates of every node in the communicator
+
+        """
+        space = self.space
+        outgoing = self._pack_migration(space.bounds, new_bounds, coords)
+        incoming = space.cart_comm.alltoall(outgoing)
+
+        space.bounds = new_bounds
+        space._set_my_field()
+
+        verbose, self.verbose = self.verbose, False
+        self._init_field()
+        for pieces, states in incoming:
+            for comp, lo, values in pieces:
+                start = array(lo) - space.my_field_offset
+                box = tuple(slice(start[i], start[i] + values.shape[i])
+                            for i in xrange(3))
+                self.field[comp][box] = values
+
+        self.init_halo()
+        self.init_material()
+        self.bind_material()
+        if self.overlap:
+            self.split_material()
+        self.init_source()
+        self.verbose = verbose
+
+        for pieces, states in incoming:
+            for comp, name, indices, state, sizes in states:
+                indices = array(indices - space.my_field_offset, np.intc)
+                for pw_type, pw_obj in self.pw_material[comp].iteritems():
+                    if pw_type.__name__ == name:
+                        pw_obj.set_state(indices, state, sizes)
+
+    def _pack_migration(self, old_bounds, new_bounds, coords):
+        """Return the field pieces and the pw material states of this 
+        node to send to each node by the rebalance.
+
+        The piece of a node is the part of the fields this node updates
+        which the node updates after the rebalance. The pieces and the
+        states are in the global indices. Each state goes with the 
+        sizes of its per-cell arrays, which differ between the nodes 
+        when their merged materials differ in the number of poles.
+
+        """
+        space = self.space
+        my_coords = space.my_cart_idx
+        offset = space.my_field_offset
+        compnt = self.e_field_compnt + self.h_field_compnt
+
+        states = []
+        for comp in compnt:
+            for pw_type, pw_obj in self.pw_material[comp].iteritems():
+                state_size = pw_obj.state_size()
+                if state_size == 0:
+                    continue
+                indices = empty((pw_obj.idx_size(), 3), np.intc)
+                pw_obj.get_indices(indices)
+                state = empty((len(indices), state_size), np.double)
+                pw_obj.get_state(indices, state)
+                sizes = pw_obj.get_state_sizes(pw_obj.state_arrays())
+                states.append((comp, pw_type.__name__, 
+                               indices + offset, state, sizes))
+
+        outgoing = []
+        for r in xrange(len(coords)):
+            pieces = []
+            moving = []
+            for comp in compnt:
+                old_lo, old_hi = self._owned_box(comp, old_bounds, my_coords)
+                new_lo, new_hi = self._owned_box(comp, new_bounds, coords[r])
+                lo = np.maximum(old_lo, new_lo)
+                hi = np.minimum(old_hi, new_hi)
+                if np.any(lo >= hi):
+                    continue
+
+                box = tuple(slice(lo[i] - offset[i], hi[i] - offset[i])
+                            for i in xrange(3))
+                pieces.append((comp, lo, self.field[comp][box].copy()))
+
+                for s_comp, name, indices, state, sizes in states:
+                    if s_comp is not comp:
+                        continue
+                    inside = np.all((indices >= lo) & (indices < hi), 1)
+                    if inside.any():
+                        moving.append((comp, name, indices[inside], 
+                                       state[inside], sizes))
+            outgoing.append((pieces, moving))
+
+        return outgoing
+
+    def _get_stepper(self, steps):
+        """Return a native stepping loop for the next steps time steps.
+
+        Return None if these steps need Python on the way, i.e. for the 
+        probes, for the sources other than point sources, for a point 
+        source recording its waveform, or for the exchange of the fields 
+        between MPI nodes.
+
+        """
+        if self.space.numprocs > 1 or self.e_recorder or self.h_recorder:
+            return None
+
+        if any(hasattr(so, 'aux_fdtd') for so in self.src_list):
+            return None
+
+        compnt = self.e_field_compnt + self.h_field_compnt
+
+        point_src = []
+        for comp in compnt:
+            for pw_src in self.pw_source[comp].itervalues():
+                if not isinstance(pw_src, (PointSourceElectric, 
+                                           PointSourceMagnetic)):
+                    return None
+                for idx, param in pw_src._param.iteritems():
+                    if param.f:
+                        return None
+                    point_src.append((comp, idx, param))
+
+        stepper = _stepper[self.cmplx, self.single]()
+        stepper.set_fields(self.ex, self.ey, self.ez, 
+                           self.hx, self.hy, self.hz)
+        stepper.set_space(self.dx, self.dy, self.dz, self.time_step.dt)
+
+        for comp in compnt:
+            for pw_obj in self.pw_material[comp].itervalues():
+                stepper.attach_material(_compnt_idx[comp], pw_obj)
+            self._attach_halo(stepper, comp)
+
+        # The waveforms of the point sources at the time steps to run.
+        dt = self.time_step.dt
+        for comp, idx, param in point_src:
+            if comp in self.e_field_compnt:
+                n = self.time_step.n + 0.5
+                field, current, inf_param = Electric, ElectricCurrent, param.eps_inf
+            else:
+                n = self.time_step.n + 1
+                field, current, inf_param = Magnetic, MagneticCurrent, param.mu_inf
+
+            if issubclass(param.comp, field):
+                is_current = False
+            elif issubclass(param.comp, current):
+                is_current = True
+            else:
+                continue
+
+            values = [param.amp * param.src_time.oscillator(dt * (n + i))
+                      for i in xrange(steps)]
+            stepper.attach_source(_compnt_idx[comp], array(idx, np.intc), 
+                                  array(values, self.field[comp].dtype), 
+                                  is_current, inf_param)
+
+        return stepper
+
+    def _attach_halo(self, stepper, comp):
+        """Attach the halo planes of comp to stepper.
+
+        This method assumes a single node, on which the neighbors are 
+        the node itself across the periodic boundaries.
+
+        """
+        for halo in self.halo[comp]:
+            stepper.attach_halo(_compnt_idx[comp], halo[1])
+
+    def _native_steps(self, n, modulus):
+        """Return the number of time steps to n or to the next print at
+        every modulus steps, whichever comes first.
+
+        """
+        steps = min(ceil(n - self.time_step.n), _max_native_steps)
+        if modulus < inf:
+            steps = min(steps, modulus - self.time_step.n % modulus)
+        return max(int(steps), 1)
+
+    def step_n(self, steps):
+        """Run steps time steps.
+
+        The time steps run in one call of the native stepping loop with
+        the GIL released, unless they need Python on the way. Then they 
+        fall back to self.step().
+
+        """
+        stepper = self._get_stepper(steps)
+        if stepper is None:
+            for i in xrange(steps):
+                self.step()
+        else:
+            n = stepper.step_until_n(self.time_step.n, 
+                                     self.time_step.n + steps)
+            self.time_step.n = n
+            self.time_step.t = n * self.time_step.dt
+
     def step_while_zero(self, component, point, modulus=inf):
         """Run self.step() while the field value at the given point is 0.
         
@@ -1028,7 +1567,21 @@ class FDTD(object):
             
         flag = True
         while flag:
-            self.step()
+            stepper = None
+            if self.space.my_id == hot_node:
+                steps = self._native_steps(inf, modulus)
+                stepper = self._get_stepper(steps)
+
+            if stepper is None:
+                self.step()
+            else:
+                n = stepper.step_while_zero(self.time_step.n, 
+                                            self.time_step.n + steps,
+                                            _compnt_idx[component],
+                                            *map(int, idx))
+                self.time_step.n = n
+                self.time_step.t = n * self.time_step.dt
+
             if self.time_step.n % modulus == 0:
                 print 'n:', self.time_step.n, 't:', self.time_step.t
             if self.space.my_id == hot_node and self.field[component][idx] != 0:
@@ -1051,7 +1604,7 @@ class FDTD(object):
             print 'Estimated time of completion:', timedelta(seconds=estimated_t)
         
         while self.time_step.n < n:
-            self.step()
+            self.step_n(self._native_steps(n, modulus))
             if self.time_step.n % modulus == 0:
                 print 'n:', self.time_step.n, 't:', self.time_step.t
 
@@ -3,7 +3,9 @@
 
 # This code is based on libctl 3.0.2.
 
+from os.path import expanduser, join, exists
 from sys import stderr
+from time import time
 
 try:
     import psyco
@@ -15,13 +17,86 @@ except ImportError:
 from copy import deepcopy
 
 import numpy as np
-from numpy import empty, zeros, inf, dot, array
+from numpy import empty, zeros, inf, dot, array, arange, ndindex
 
 # GMES modules
 import constant as const
 from pygeom import *
 
 
+# cache of the measured network load ratios, see Cartesian.calibrate
+CALIBRATION_FILE = join(expanduser('~'), '.gmes_calibration')
+
+
+def _time_cell_update(size=32, repeat=5):
+    """Return the time to update a cell of a non-dispersive dielectric.
+
+    """
+    from material import Dielectric
+
+    idx = array(list(ndindex(size, size, size)), np.intc)
+    pw_obj = Dielectric().get_pw_material_ex(idx, zeros((len(idx), 3)))
+    ex = zeros((size + 1,) * 3)
+    hz = np.random.random_sample(ex.shape)
+    hy = np.random.random_sample(ex.shape)
+
+    best = inf
+    for r in xrange(repeat):
+        start = time()
+        pw_obj.update_all(ex, hz, hy, 1, 1, 1, 0)
+        best = min(best, time() - start)
+
+    return best / len(idx)
+
+
+def _time_halo_byte(comm, size=1 << 16, repeat=5):
+    """Return the time to exchange a byte of a halo plane.
+
+    Every node sends to the next node and receives from the previous 
+    one at the same time, as in a halo exchange.
+
+    """
+    sendbuf = np.random.random_sample(size)
+    recvbuf = empty(size)
+    dest = (comm.rank + 1) % comm.size
+    src = (comm.rank - 1) % comm.size
+
+    best = inf
+    for r in xrange(repeat):
+        comm.Barrier()
+        start = time()
+        comm.Sendrecv(sendbuf, dest, 0, recvbuf, src, 0)
+        best = min(best, time() - start)
+
+    return best / sendbuf.nbytes
+
+
+def _read_calibration(cache):
+    """Return the cached ratios keyed by the node sets.
+
+    """
+    ratio = {}
+    if exists(cache):
+        for line in open(cache):
+            key, sep, value = line.rstrip('\n').rpartition('\t')
+            if sep:
+                ratio[key] = float(value)
+
+    return ratio
+
+
+def _write_calibration(cache, key, value):
+    ratio = _read_calibration(cache)
+    ratio[key] = value
+    try:
+        f = open(cache, 'w')
+        for k in sorted(ratio):
+            f.write('%s\t%r\n' % (k, ratio[k]))
+        f.close()
+    except IOError:
+        stderr.write('Could not write the calibration cache %s.\n' % cache)
+
+
 class AuxiCartComm(object):
     """Auxiliary MPI Cartesian communicator for the absence of MPI implementation.
     
@@ -94,6 +169,16 @@ class AuxiCartComm(object):
             return None
         else:
             return sendbuf
+
+    def Sendrecv(self, sendbuf, dest=0, sendtag=0,
+                 recvbuf=None, source=0, recvtag=0, status=None):
+        """Mimic Sendrecv method.
+        
+        Copy sendbuf into recvbuf. The other arguments are ignored.
+        
+        """
+        if dest != -1 and source != -1:
+            recvbuf[...] = sendbuf
         
     def reduce(self, value, root=0, op=None):
         """Mimic reduce method.
@@ -107,6 +192,113 @@ class AuxiCartComm(object):
         """
         return obj
 
+    def allreduce(self, value, op=None):
+        """Mimic allreduce method.
+        
+        """
+        return value
+
+    def allgather(self, value):
+        """Mimic allgather method.
+        
+        """
+        return [value]
+
+    def alltoall(self, sendobj):
+        """Mimic alltoall method.
+        
+        """
+        return list(sendobj)
+
+
+class CellCost(object):
+    """Update cost of the cells of the whole space.
+
+    The cost is kept as the runs of cells along the z-axis, each with 
+    the cost of one of its cells. Every node keeps the runs of its own 
+    part of the space only, and the sums over the whole space are 
+    reduced over the nodes.
+
+    Attributes:
+    shape -- the shape of the whole space, i.e. whole_field_size
+    runs -- an R x 4 array of the runs (i, j, k_start, k_end) in the 
+        global indices, k_end exclusive
+    value -- the cost of a cell of each run
+    comm -- MPI communicator of the nodes
+
+    """
+    def __init__(self, shape, runs, value, comm=None):
+        self.shape = tuple(shape)
+        self.runs = array(runs, np.int).reshape(-1, 4)
+        self.value = array(value, np.double).reshape(-1)
+        if comm is None:
+            comm = AuxiCartComm()
+        self.comm = comm
+
+    def profile(self, axis):
+        """Return the cost summed over the other two axes.
+
+        """
+        size = self.shape[axis]
+        i, j, k0, k1 = self.runs.T
+        if axis == 2:
+            diff = (np.bincount(k0, self.value, size + 1) - 
+                    np.bincount(k1, self.value, size + 1))
+            local = np.cumsum(diff)[:-1]
+        else:
+            local = np.bincount(self.runs[:, axis], 
+                                self.value * (k1 - k0), size)
+
+        return self.comm.allreduce(local)
+
+    def block_sums(self, bounds):
+        """Return the cost summed over each block of the split at 
+        bounds.
+
+        Keyword arguments:
+        bounds -- the block boundaries along each axis
+
+        """
+        dims = tuple(len(b) - 1 for b in bounds)
+        i, j, k0, k1 = self.runs.T
+        flat = ((np.searchsorted(bounds[0], i, 'right') - 1) * dims[1] + 
+                np.searchsorted(bounds[1], j, 'right') - 1)
+
+        local = zeros(dims, np.double)
+        for c in xrange(dims[2]):
+            lo, hi = bounds[2][c], bounds[2][c + 1]
+            overlap = np.maximum(np.minimum(k1, hi) - np.maximum(k0, lo), 0)
+            local[:, :, c] = np.bincount(flat, self.value * overlap, 
+                                         dims[0] * dims[1]).reshape(dims[:2])
+
+        return self.comm.allreduce(local)
+
+    def scale(self, bounds, factor):
+        """Multiply the cost of the cells of each block of the split at
+        bounds by the factor of the block.
+
+        Keyword arguments:
+        bounds -- the block boundaries along each axis
+        factor -- an array of the shape of the blocks
+
+        """
+        i, j, k0, k1 = self.runs.T
+        bi = np.searchsorted(bounds[0], i, 'right') - 1
+        bj = np.searchsorted(bounds[1], j, 'right') - 1
+
+        runs, value = [], []
+        for c in xrange(len(bounds[2]) - 1):
+            lo = np.maximum(k0, bounds[2][c])
+            hi = np.minimum(k1, bounds[2][c + 1])
+            inside = lo < hi
+            runs.append(np.column_stack((i[inside], j[inside], 
+                                         lo[inside], hi[inside])))
+            value.append(self.value[inside] * 
+                         factor[bi[inside], bj[inside], c])
+
+        self.runs = np.concatenate(runs).reshape(-1, 4)
+        self.value = np.concatenate(value)
+
 
 class Cartesian(object):
     """Define the calculation space with Cartesian coordinates.
@@ -126,9 +318,14 @@ class Cartesian(object):
         the electromagnetic field except the communication buffers
     my_field_size -- the specific array size for the each component of
         the electromagnetic field of this node except the communication buffers
+    net_cpu_ratio -- network load ratio compared to CPU, see load_metric
+    bounds -- the global indices of the node boundaries along each axis
+    my_field_offset -- the global index of the first mesh point of this node
+    cost_aware -- whether the nodes are balanced by the cell costs
             
     """
-    def __init__(self, size, resolution=15, parallel=False):
+    def __init__(self, size, resolution=15, parallel=False, cost_aware=False,
+                 calibrate=False):
         """Constructor
 
         Keyword arguments:
@@ -136,6 +333,12 @@ class Cartesian(object):
         resolution -- number of sections of one unit. scalar or 3-tuple
             (default 15)
         parallel -- whether space be divided into segments (default False)    
+        cost_aware -- whether FDTD rebalances the segments by the update 
+            costs of the materials at the cells. The segments then differ 
+            in size. (default False)
+        calibrate -- whether the network load ratio compared to CPU is
+            measured on the nodes instead of the default 1000. See 
+            calibrate. (default False)
 
         """
         try:
@@ -159,26 +362,86 @@ class Cartesian(object):
         self.my_id = 0
         self.numprocs = 1
         self.cart_comm = AuxiCartComm((1,1,1), (1,1,1))
+        self.net_cpu_ratio = 1000
         try:
             if parallel:
                 from mpi4py import MPI
                 self.my_id = MPI.COMM_WORLD.rank
                 self.numprocs = MPI.COMM_WORLD.size
+                if calibrate and self.numprocs > 1:
+                    self.net_cpu_ratio = self.calibrate(MPI.COMM_WORLD)
                 self.cart_comm = MPI.COMM_WORLD.Create_cart(self.find_best_deploy(), (1, 1, 1))
         except ImportError:
             pass
 
-        self.my_cart_idx = self.cart_comm.topo[2]
-        
+        self.cost_aware = bool(cost_aware)
+
         # Usually the my_field_size is general_field_size,
         # except the last node in each dimension.
         self.general_field_size = \
             self.whole_field_size / self.cart_comm.topo[0]
+
+        dims = self.cart_comm.topo[0]
+        self.bounds = tuple(self._even_bounds(self.whole_field_size[i], dims[i])
+                            for i in xrange(3))
+        self._set_my_field()
+
+    def _even_bounds(self, size, parts):
+        """Return the node boundaries of the even split of size mesh 
+        points, in which the last node takes the remainder.
+        
+        """
+        general = size // parts
+        return array([general * c for c in xrange(parts)] + [size], np.int)
+
+    def _set_my_field(self):
+        """Set the fields of this node from self.bounds.
+
+        """
+        self.my_cart_idx = self.cart_comm.topo[2]
         
         # my_field_size may be different than general_field_size at the last 
-        # node in each dimension.
+        # node in each dimension, or at every node if the nodes are 
+        # balanced by the cell costs.
         self.my_field_size = self.get_my_field_size()
+        self.my_field_offset = array([self.bounds[i][self.my_cart_idx[i]] 
+                                      for i in xrange(3)], np.int)
     
+    def calibrate(self, comm, cache=CALIBRATION_FILE):
+        """Return the network load ratio compared to CPU of the nodes.
+
+        The ratio is the time to exchange the halo data of a cell over 
+        the time to update a cell, both measured on every node of comm
+        and taken at the slowest one. The ratio is cached in the file 
+        cache by the number of nodes and their names, so the later 
+        runs on the same nodes skip the measurement.
+
+        Keyword arguments:
+        comm -- MPI communicator of the nodes
+        cache -- file name of the cache (default CALIBRATION_FILE)
+
+        """
+        from mpi4py import MPI
+
+        hosts = sorted(set(comm.allgather(MPI.Get_processor_name())))
+        key = '%d %s' % (comm.size, ','.join(hosts))
+
+        ratio = None
+        if comm.rank == 0:
+            ratio = _read_calibration(cache).get(key)
+        ratio = comm.bcast(ratio, 0)
+        if ratio is not None:
+            return ratio
+
+        cell_time = comm.allreduce(_time_cell_update(), op=MPI.MAX)
+        byte_time = comm.allreduce(_time_halo_byte(comm), op=MPI.MAX)
+        ratio = byte_time * np.dtype(np.double).itemsize / cell_time
+
+        if comm.rank == 0:
+            _write_calibration(cache, key, ratio)
+
+        return ratio
+
     def bcast(self, obj=None, root=None):
         """Same with the Broadcast but, it handles for unknown root among 
         the nodes.
@@ -201,28 +464,24 @@ class Cartesian(object):
         """Return the field size of this node.
         
         This method depends on 
-        self.general_field_size
-        self.whole_field_size
+        self.bounds
         self.my_cart_idx
             
         """
         field_size = empty(3, np.int)
-        dims = self.cart_comm.topo[0]
-
         for i in xrange(3):
-            # At the last node of that dimension.
-            if self.my_cart_idx[i] == dims[i] - 1:
-                field_size[i] = \
-                self.whole_field_size[i] - (self.my_cart_idx[i] * 
-                                            self.general_field_size[i])
-            else:
-                field_size[i] = self.general_field_size[i]
+            c = self.my_cart_idx[i]
+            field_size[i] = self.bounds[i][c + 1] - self.bounds[i][c]
         
         return field_size
     
-    def find_best_deploy(self):
+    def find_best_deploy(self, cost=None):
         """Return the minimum load deploy of the nodes.
         
+        Keyword arguments:
+        cost -- update cost of the cells, a CellCost. See load_metric.
+            (default None)
+
         This method depends on
         self.numprocs
             
@@ -237,43 +496,106 @@ class Cartesian(object):
                     break
                 n = self.numprocs / (l * m)
                 if self.numprocs % n == 0:
-                        tmp_load = self.load_metric(l, m, n)
+                        tmp_load = self.load_metric(l, m, n, cost)
                         if tmp_load < min_load:
                             best_partition = l, m, n
                             min_load = tmp_load
 
         return best_partition
 
-    def load_metric(self, l, m, n):
+    def load_metric(self, l, m, n, cost=None):
         """Estimate the load on a node.
     
         Keyword arguments:
         l, m, n -- the number of node in each direction
+        cost -- update cost of the cells, a CellCost. If given, the 
+            CPU load is that of the most loaded node of the split by 
+            balanced_bounds. Otherwise every cell costs one. 
+            (default None)
         
         This method depends on
         self.whole_field_size
+        self.net_cpu_ratio
         
         """
+        if cost is not None:
+            bounds = self.balanced_bounds((l, m, n), cost)
+            cpu_load = cost.block_sums(bounds).max()
+
         l, m, n = float(l), float(m), float(n)
         
         # network load ratio compared to CPU
-        R = 1000
+        R = self.net_cpu_ratio
         
-        cpu_load = (self.whole_field_size[0] * self.whole_field_size[1] * 
-                    self.whole_field_size[2]) / (l * m * n)
+        if cost is None:
+            cpu_load = (self.whole_field_size[0] * self.whole_field_size[1] * 
+                        self.whole_field_size[2]) / (l * m * n)
         net_load = 4 * R * (self.whole_field_size[0] / l * self.whole_field_size[1] / m + 
                             self.whole_field_size[1] / m * self.whole_field_size[2] / n + 
                             self.whole_field_size[2] / n * self.whole_field_size[0] / l)
         
         return cpu_load + net_load
 
-    def _get_em_field_storage(self, shape, cmplx):
-        if cmplx:
+    def balanced_bounds(self, dims, cost):
+        """Return the node boundaries along each axis that split cost 
+        evenly.
+
+        The boundaries along an axis split the cost summed over the 
+        other two axes into dims[axis] slabs of about the same cost.
+        Every slab keeps at least one mesh point.
+
+        Keyword arguments:
+        dims -- the number of node in each direction
+        cost -- update cost of the cells, a CellCost
+
+        """
+        bounds = []
+        for i in xrange(3):
+            parts = dims[i]
+            size = self.whole_field_size[i]
+            profile = np.cumsum(cost.profile(i), dtype=np.double)
+            target = profile[-1] * arange(1, parts) / parts
+            b = np.concatenate(([0], np.searchsorted(profile, target) + 1, 
+                                [size]))
+            for c in xrange(1, parts):
+                b[c] = max(b[c], b[c - 1] + 1)
+            for c in xrange(parts - 1, 0, -1):
+                b[c] = min(b[c], b[c + 1] - 1)
+            bounds.append(array(b, np.int))
+
+        return tuple(bounds)
+
+    def balance(self, cost):
+        """Redeploy the nodes by the update cost of the cells.
+
+        The node topology is chosen again, and the nodes take 
+        non-uniform segments of about the same cost. Call this before
+        any field storage is allocated.
+
+        Keyword arguments:
+        cost -- update cost of the cells, a CellCost
+
+        """
+        if self.numprocs == 1:
+            return
+
+        from mpi4py import MPI
+        dims = self.find_best_deploy(cost)
+        self.cart_comm = MPI.COMM_WORLD.Create_cart(dims, (1, 1, 1))
+        self.bounds = self.balanced_bounds(dims, cost)
+        self._set_my_field()
+
+    def _get_em_field_storage(self, shape, cmplx, single):
+        if cmplx and single:
+            return zeros(shape, np.complex64)
+        elif cmplx:
             return zeros(shape, complex)
+        elif single:
+            return zeros(shape, np.float32)
         else:
             return zeros(shape, np.double)
 
-    def get_ex_storage(self, field_compnt, cmplx=False):
+    def get_ex_storage(self, field_compnt, cmplx=False, single=False):
         """Return an initialized array for Ex field component.
         
         """
@@ -283,9 +605,9 @@ class Cartesian(object):
         else:
             shape = (1, 1, 1)
         
-        return self._get_em_field_storage(shape, cmplx)
+        return self._get_em_field_storage(shape, cmplx, single)
         
-    def get_ey_storage(self, field_compnt, cmplx=False):
+    def get_ey_storage(self, field_compnt, cmplx=False, single=False):
         """Return an initialized array for Ey field component.
         
         """
@@ -295,9 +617,9 @@ class Cartesian(object):
         else:
             shape = (1, 1, 1)
         
-        return self._get_em_field_storage(shape, cmplx)
+        return self._get_em_field_storage(shape, cmplx, single)
 
-    def get_ez_storage(self, field_compnt, cmplx=False):
+    def get_ez_storage(self, field_compnt, cmplx=False, single=False):
         """Return an initialized array for Ez field component.
         
         """
@@ -307,9 +629,9 @@ class Cartesian(object):
         else:
             shape = (1, 1, 1)
 
-        return self._get_em_field_storage(shape, cmplx)
+        return self._get_em_field_storage(shape, cmplx, single)
         
-    def get_hx_storage(self, field_compnt, cmplx=False):
+    def get_hx_storage(self, field_compnt, cmplx=False, single=False):
         """Return an initialized array for Hx field component.
         
         """
@@ -319,9 +641,9 @@ class Cartesian(object):
         else:
             shape = (1, 1, 1)
 
-        return self._get_em_field_storage(shape, cmplx)
+        return self._get_em_field_storage(shape, cmplx, single)
         
-    def get_hy_storage(self, field_compnt, cmplx=False):  
+    def get_hy_storage(self, field_compnt, cmplx=False, single=False):  
         """Return an initialized array for Hy field component.
         
         """
@@ -331,9 +653,9 @@ class Cartesian(object):
         else:
             shape = (1, 1, 1)
         
-        return self._get_em_field_storage(shape, cmplx)
+        return self._get_em_field_storage(shape, cmplx, single)
         
-    def get_hz_storage(self, field_compnt, cmplx=False):
+    def get_hz_storage(self, field_compnt, cmplx=False, single=False):
         """Return an initialized array for Hz field component.
         
         """
@@ -343,7 +665,27 @@ class Cartesian(object):
         else:
             shape = (1, 1, 1)
         
-        return self._get_em_field_storage(shape, cmplx)
+        return self._get_em_field_storage(shape, cmplx, single)
+
+    def indices_to_space(self, comp, indices):
+        """Return space coordinates of the given indices.
+
+        This method returns the (global) space coordinates, an N x 3 
+        array, of the given (local) indices of comp mesh points, an 
+        N x 3 array. It is the batch version of ex_index_to_space, ...,
+        hz_index_to_space.
+
+        Keyword arguments:
+        comp -- field component
+        indices -- array indices
+
+        """
+        shift = {const.Ex: (.5, 0, 0), const.Ey: (0, .5, 0), 
+                 const.Ez: (0, 0, .5), const.Hx: (0, -.5, -.5), 
+                 const.Hy: (-.5, 0, -.5), const.Hz: (-.5, -.5, 0)}
+
+        global_idx = np.asarray(indices) + self.my_field_offset
+        return (global_idx + array(shift[comp])) * self.dr - self.half_size
 
     def ex_index_to_space(self, i, j, k):
         """Return space coordinate of the given index.
@@ -356,7 +698,7 @@ class Cartesian(object):
         
         """
         idx = array((i, j, k), np.int)  
-        global_idx = idx + self.general_field_size * self.my_cart_idx
+        global_idx = idx + self.my_field_offset
         
         spc_0 = (global_idx[0] + .5) * self.dr[0] - self.half_size[0]
         spc_1 = global_idx[1] * self.dr[1] - self.half_size[1]
@@ -387,8 +729,7 @@ class Cartesian(object):
             if self.whole_field_size[i] == 1:
                 idx[i] = 0
             else:
-                idx[i] = global_idx[i] - (self.my_cart_idx[i] * 
-                                          self.general_field_size[i])
+                idx[i] = global_idx[i] - self.my_field_offset[i]
                   
         return tuple(idx)
     
@@ -415,8 +756,7 @@ class Cartesian(object):
             if self.whole_field_size[i] == 1:
                 idx[i] = 0
             else:
-                idx[i] = global_idx[i] - (self.my_cart_idx[i] * 
-                                          self.general_field_size[i])
+                idx[i] = global_idx[i] - self.my_field_offset[i]
                   
         return tuple(idx)
     
@@ -432,7 +772,7 @@ class Cartesian(object):
         """
         idx = array((i,j,k), np.int)
             
-        global_idx = idx + self.general_field_size * self.my_cart_idx
+        global_idx = idx + self.my_field_offset
         
         coords_0 = global_idx[0] * self.dr[0] - self.half_size[0]
         coords_1 = (global_idx[1] + .5) * self.dr[1] - self.half_size[1]
@@ -463,8 +803,7 @@ class Cartesian(object):
             if self.whole_field_size[i] == 1:
                 idx[i] = 0
             else:
-                idx[i] = global_idx[i] - (self.my_cart_idx[i] * 
-                                          self.general_field_size[i])
+                idx[i] = global_idx[i] - self.my_field_offset[i]
                   
         return tuple(idx)
         
@@ -491,8 +830,7 @@ class Cartesian(object):
             if self.whole_field_size[i] == 1:
                 idx[i] = 0
             else:
-                idx[i] = global_idx[i] - (self.my_cart_idx[i] * 
-                                          self.general_field_size[i])
+                idx[i] = global_idx[i] - self.my_field_offset[i]
                   
         return tuple(idx)
     
@@ -508,7 +846,7 @@ class Cartesian(object):
         """
         idx = array((i, j, k), np.int)
             
-        global_idx = idx + self.general_field_size * self.my_cart_idx
+        global_idx = idx + self.my_field_offset
         
         coords_0 = global_idx[0] * self.dr[0] - self.half_size[0]
         coords_1 = global_idx[1] * self.dr[1] - self.half_size[1]
@@ -539,8 +877,7 @@ class Cartesian(object):
             if self.whole_field_size[i] == 1:
                 idx[i] = 0
             else:
-                idx[i] = global_idx[i] - (self.my_cart_idx[i] * 
-                                          self.general_field_size[i])
+                idx[i] = global_idx[i] - self.my_field_offset[i]
                     
         return tuple(idx)
         
@@ -567,8 +904,7 @@ class Cartesian(object):
             if self.whole_field_size[i] == 1:
                 idx[i] = 0
             else:
-                idx[i] = global_idx[i] - (self.my_cart_idx[i] * 
-                                          self.general_field_size[i])
+                idx[i] = global_idx[i] - self.my_field_offset[i]
                     
         return tuple(idx)
 
@@ -584,7 +920,7 @@ class Cartesian(object):
         """
         idx = array((i, j, k), np.int)
             
-        global_idx = idx + self.general_field_size * self.my_cart_idx
+        global_idx = idx + self.my_field_offset
         
         coords_0 = global_idx[0] * self.dr[0] - self.half_size[0]
         coords_1 = (global_idx[1] - .5) * self.dr[1] - self.half_size[1]
@@ -610,7 +946,7 @@ class Cartesian(object):
         global_idx[1] = (coords[1] + self.half_size[1]) / self.dr[1] + .5
         global_idx[2] = (coords[2] + self.half_size[2]) / self.dr[2] + .5
 
-        idx = global_idx - self.my_cart_idx * self.general_field_size
+        idx = global_idx - self.my_field_offset
         if self.whole_field_size[0] == 1:
             idx[0] = 0
         if self.whole_field_size[1] == 1:
@@ -638,7 +974,7 @@ class Cartesian(object):
         global_idx[1] = (coords[1] + self.half_size[1]) / self.dr[1] + 1
         global_idx[2] = (coords[2] + self.half_size[2]) / self.dr[2] + 1
 
-        idx = global_idx - self.my_cart_idx * self.general_field_size
+        idx = global_idx - self.my_field_offset
         if self.whole_field_size[0] == 1:
             idx[0] = 0
         if self.whole_field_size[1] == 1:
@@ -660,7 +996,7 @@ class Cartesian(object):
         """
         idx = array((i,j,k), np.int)
             
-        global_idx = idx + self.general_field_size * self.my_cart_idx
+        global_idx = idx + self.my_field_offset
         
         coords_0 = (global_idx[0] - .5) * self.dr[0] - self.half_size[0]
         coords_1 = global_idx[1] * self.dr[1] - self.half_size[1]
@@ -686,7 +1022,7 @@ class Cartesian(object):
         global_idx[1] = (coords[1] + self.half_size[1]) / self.dr[1]
         global_idx[2] = (coords[2] + self.half_size[2]) / self.dr[2] + .5
 
-        idx = global_idx - self.my_cart_idx * self.general_field_size
+        idx = global_idx - self.my_field_offset
         if self.whole_field_size[0] == 1:
             idx[0] = 1
         if self.whole_field_size[1] == 1:
@@ -714,7 +1050,7 @@ class Cartesian(object):
         global_idx[1] = (coords[1] + self.half_size[1]) / self.dr[1] + .5
         global_idx[2] = (coords[2] + self.half_size[2]) / self.dr[2] + 1
 
-        idx = global_idx - self.my_cart_idx * self.general_field_size
+        idx = global_idx - self.my_field_offset
         if self.whole_field_size[0] == 1:
             idx[0] = 1
         if self.whole_field_size[1] == 1:
@@ -736,7 +1072,7 @@ class Cartesian(object):
         """
         idx = array((i,j,k), np.int)
             
-        global_idx = idx + self.general_field_size * self.my_cart_idx
+        global_idx = idx + self.my_field_offset
         
         coords_0 = (global_idx[0] - .5) * self.dr[0] - self.half_size[0]
         coords_1 = (global_idx[1] - .5) * self.dr[1] - self.half_size[1]
@@ -762,7 +1098,7 @@ class Cartesian(object):
         global_idx[1] = (coords[1] + self.half_size[1]) / self.dr[1] + .5
         global_idx[2] = (coords[2] + self.half_size[2]) / self.dr[2]
 
-        idx = global_idx - self.my_cart_idx * self.general_field_size
+        idx = global_idx - self.my_field_offset
         if self.whole_field_size[0] == 1:
             idx[0] = 1
         if self.whole_field_size[1] == 1:
@@ -790,7 +1126,7 @@ class Cartesian(object):
         global_idx[1] = (coords[1] + self.half_size[1]) / self.dr[1] + 1
         global_idx[2] = (coords[2] + self.half_size[2]) / self.dr[2] + .5
 
-        idx = global_idx - self.my_cart_idx * self.general_field_size
+        idx = global_idx - self.my_field_offset
         if self.whole_field_size[0] == 1:
             idx[0] = 1
         if self.whole_field_size[1] == 1:
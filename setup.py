@@ -23,6 +23,8 @@ base = getcwd() + '/'
 pw_src_lst = glob('src/pw_*.cc')
 pw_src_lst.extend(glob('src/pw_*.i'))
 pw_dep_lst = glob('src/pw_*.hh')
+pw_dep_lst.append('src/storage.hh')
+pw_dep_lst.append('src/simd.hh')
 
 # pw_material module
 pw_material = Extension(name = 'gmes._pw_material',
@@ -31,7 +33,8 @@ pw_material = Extension(name = 'gmes._pw_material',
                         include_dirs = [numpy_include],
                         swig_opts = ['-c++', '-outdir', 'gmes'],
                         language = 'c++',
-                        extra_compile_args=['-std=c++0x'])
+                        extra_compile_args=['-std=c++0x', '-fopenmp'],
+                        extra_link_args=['-fopenmp'])
 
 # constant module
 constant = Extension(name = 'gmes._constant',
@@ -45,7 +48,9 @@ constant = Extension(name = 'gmes._constant',
 # pygeom module
 pygeom = Extension(name = 'gmes.pygeom',
                    sources = ['src/pygeom.pyx'],
-                   include_dirs = [numpy_include])
+                   include_dirs = [numpy_include],
+                   extra_compile_args=['-fopenmp'],
+                   extra_link_args=['-fopenmp'])
 
 # material module
 material = Extension(name = 'gmes.material',
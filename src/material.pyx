@@ -24,10 +24,39 @@ from pw_material import *
 from constant import c0
 
 
+def _points(coords):
+    """Return coords as a sequence of points.
+
+    coords is either a single point or a sequence of them.
+
+    """
+    coords = array(coords, np.double)
+    return coords.reshape(-1, coords.shape[-1])
+
+
+def _attach(pw_obj, idx, pw_param, coeffs=None):
+    """Attach the mesh points at idx to pw_obj.
+
+    idx is either a single array index or an N x 3 array of them. All
+    the points share pw_param, while coeffs, if given, holds one row
+    of position dependent coefficients per point.
+
+    """
+    indices = array(idx, np.intc).reshape(-1, 3)
+    if coeffs is None:
+        pw_obj.attach_many(indices, pw_param)
+    else:
+        pw_obj.attach_many(indices, pw_param, array(coeffs, np.double))
+
+
 class Dummy(Material):
     """A dummy material type which dosen't update the field component.
     
     """
+    # update cost of a cell relative to Dielectric, by which FDTD
+    # balances the nodes
+    cost = 0
+
     def __init__(self, eps_inf=1, mu_inf=1):
         Material.__init__(self, eps_inf, mu_inf)
         
@@ -43,10 +72,17 @@ class Dummy(Material):
         print "frequency independent permittivity:", self.eps_inf,
         print "frequency independent permeability:", self.mu_inf
         
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DummyExCmplxSingle()
+            pw_param = DummyElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DummyExCmplx()
             pw_param = DummyElectricParamCmplx()
+        elif single:
+            pw_obj = DummyExRealSingle()
+            pw_param = DummyElectricParamRealSingle()
         else:
             pw_obj = DummyExReal()
             pw_param = DummyElectricParamReal()
@@ -56,13 +92,20 @@ class Dummy(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DummyEyCmplxSingle()
+            pw_param = DummyElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DummyEyCmplx()
             pw_param = DummyElectricParamCmplx()
+        elif single:
+            pw_obj = DummyEyRealSingle()
+            pw_param = DummyElectricParamRealSingle()
         else:
             pw_obj = DummyEyReal()
             pw_param = DummyElectricParamReal()
@@ -72,13 +115,20 @@ class Dummy(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DummyEzCmplxSingle()
+            pw_param = DummyElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DummyEzCmplx()
             pw_param = DummyElectricParamCmplx()
+        elif single:
+            pw_obj = DummyEzRealSingle()
+            pw_param = DummyElectricParamRealSingle()
         else:
             pw_obj = DummyEzReal()
             pw_param = DummyElectricParamReal()
@@ -88,13 +138,20 @@ class Dummy(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DummyHxCmplxSingle()
+            pw_param = DummyMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DummyHxCmplx()
             pw_param = DummyMagneticParamCmplx()
+        elif single:
+            pw_obj = DummyHxRealSingle()
+            pw_param = DummyMagneticParamRealSingle()
         else:
             pw_obj = DummyHxReal()
             pw_param = DummyMagneticParamReal()
@@ -104,13 +161,20 @@ class Dummy(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DummyHyCmplxSingle()
+            pw_param = DummyMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DummyHyCmplx()
             pw_param = DummyMagneticParamCmplx()
+        elif single:
+            pw_obj = DummyHyRealSingle()
+            pw_param = DummyMagneticParamRealSingle()
         else:
             pw_obj = DummyHyReal()
             pw_param = DummyMagneticParamReal()
@@ -120,13 +184,20 @@ class Dummy(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DummyHzCmplxSingle()
+            pw_param = DummyMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DummyHzCmplx()
             pw_param = DummyMagneticParamCmplx()
+        elif single:
+            pw_obj = DummyHzRealSingle()
+            pw_param = DummyMagneticParamRealSingle()
         else:
             pw_obj = DummyHzReal()
             pw_param = DummyMagneticParamReal()
@@ -136,7 +207,7 @@ class Dummy(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
 
@@ -144,6 +215,8 @@ class Const(Material):
     """A material type which sets the field to the given value.
     
     """
+    cost = 1
+
     def __init__(self, value=0, eps_inf=1, mu_inf=1):
         """Arguments:
             value -- field value
@@ -180,10 +253,17 @@ class Const(Material):
         print "frequency independent permittivity:", self.eps_inf,
         print "frequency independent permeability:", self.mu_inf
         
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = ConstExCmplxSingle()
+            pw_param = ConstElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = ConstExCmplx()
             pw_param = ConstElectricParamCmplx()
+        elif single:
+            pw_obj = ConstExRealSingle()
+            pw_param = ConstElectricParamRealSingle()
         else:
             pw_obj = ConstExReal()
             pw_param = ConstElectricParamReal()
@@ -194,13 +274,20 @@ class Const(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = ConstEyCmplxSingle()
+            pw_param = ConstElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = ConstEyCmplx()
             pw_param = ConstElectricParamCmplx()
+        elif single:
+            pw_obj = ConstEyRealSingle()
+            pw_param = ConstElectricParamRealSingle()
         else:
             pw_obj = ConstEyReal()
             pw_param = ConstElectricParamReal()
@@ -211,13 +298,20 @@ class Const(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = ConstEzCmplxSingle()
+            pw_param = ConstElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = ConstEzCmplx()
             pw_param = ConstElectricParamCmplx()
+        elif single:
+            pw_obj = ConstEzRealSingle()
+            pw_param = ConstElectricParamRealSingle()
         else:
             pw_obj = ConstEzReal()
             pw_param = ConstElectricParamReal()
@@ -228,13 +322,20 @@ class Const(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = ConstHxCmplxSingle()
+            pw_param = ConstMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = ConstHxCmplx()
             pw_param = ConstMagneticParamCmplx()
+        elif single:
+            pw_obj = ConstHxRealSingle()
+            pw_param = ConstMagneticParamRealSingle()
         else:
             pw_obj = ConstHxReal()
             pw_param = ConstMagneticParamReal()
@@ -245,13 +346,20 @@ class Const(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = ConstHyCmplxSingle()
+            pw_param = ConstMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = ConstHyCmplx()
             pw_param = ConstMagneticParamCmplx()
+        elif single:
+            pw_obj = ConstHyRealSingle()
+            pw_param = ConstMagneticParamRealSingle()
         else:
             pw_obj = ConstHyReal()
             pw_param = ConstMagneticParamReal()
@@ -262,13 +370,20 @@ class Const(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = ConstHzCmplxSingle()
+            pw_param = ConstMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = ConstHzCmplx()
             pw_param = ConstMagneticParamCmplx()
+        elif single:
+            pw_obj = ConstHzRealSingle()
+            pw_param = ConstMagneticParamRealSingle()
         else:
             pw_obj = ConstHzReal()
             pw_param = ConstMagneticParamReal()
@@ -279,7 +394,7 @@ class Const(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
 
@@ -287,6 +402,8 @@ class Dielectric(Material):
     """Representation of non-dispersive isotropic dielectric medium.
         
     """
+    cost = 1
+
     def __init__(self, eps_inf=1, mu_inf=1):
         """Arguments:
             eps_inf -- frequency independent permittivity
@@ -307,12 +424,19 @@ class Dielectric(Material):
         print "frequency independent permittivity:", self.eps_inf,
         print "frequency independent permeability:", self.mu_inf
 
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
-            pw_obj = DielectricExCmplx()
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DielectricGridExCmplxSingle()
+            pw_param = DielectricElectricParamCmplxSingle()
+        elif cmplx:
+            pw_obj = DielectricGridExCmplx()
             pw_param = DielectricElectricParamCmplx()
+        elif single:
+            pw_obj = DielectricGridExRealSingle()
+            pw_param = DielectricElectricParamRealSingle()
         else:
-            pw_obj = DielectricExReal()
+            pw_obj = DielectricGridExReal()
             pw_param = DielectricElectricParamReal()
 
         if underneath is None:
@@ -320,15 +444,22 @@ class Dielectric(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
-            pw_obj = DielectricEyCmplx()
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DielectricGridEyCmplxSingle()
+            pw_param = DielectricElectricParamCmplxSingle()
+        elif cmplx:
+            pw_obj = DielectricGridEyCmplx()
             pw_param = DielectricElectricParamCmplx()
+        elif single:
+            pw_obj = DielectricGridEyRealSingle()
+            pw_param = DielectricElectricParamRealSingle()
         else:
-            pw_obj = DielectricEyReal()
+            pw_obj = DielectricGridEyReal()
             pw_param = DielectricElectricParamReal()
 
         if underneath is None:
@@ -336,15 +467,22 @@ class Dielectric(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
-            pw_obj = DielectricEzCmplx()
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DielectricGridEzCmplxSingle()
+            pw_param = DielectricElectricParamCmplxSingle()
+        elif cmplx:
+            pw_obj = DielectricGridEzCmplx()
             pw_param = DielectricElectricParamCmplx()
+        elif single:
+            pw_obj = DielectricGridEzRealSingle()
+            pw_param = DielectricElectricParamRealSingle()
         else:
-            pw_obj = DielectricEzReal()
+            pw_obj = DielectricGridEzReal()
             pw_param = DielectricElectricParamReal()
 
         if underneath is None:
@@ -352,15 +490,22 @@ class Dielectric(Material):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
-            pw_obj = DielectricHxCmplx()
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DielectricGridHxCmplxSingle()
+            pw_param = DielectricMagneticParamCmplxSingle()
+        elif cmplx:
+            pw_obj = DielectricGridHxCmplx()
             pw_param = DielectricMagneticParamCmplx()
+        elif single:
+            pw_obj = DielectricGridHxRealSingle()
+            pw_param = DielectricMagneticParamRealSingle()
         else:
-            pw_obj = DielectricHxReal()
+            pw_obj = DielectricGridHxReal()
             pw_param = DielectricMagneticParamReal()
             
         if underneath is None:
@@ -368,15 +513,22 @@ class Dielectric(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
-            pw_obj = DielectricHyCmplx()
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DielectricGridHyCmplxSingle()
+            pw_param = DielectricMagneticParamCmplxSingle()
+        elif cmplx:
+            pw_obj = DielectricGridHyCmplx()
             pw_param = DielectricMagneticParamCmplx()
+        elif single:
+            pw_obj = DielectricGridHyRealSingle()
+            pw_param = DielectricMagneticParamRealSingle()
         else:
-            pw_obj = DielectricHyReal()
+            pw_obj = DielectricGridHyReal()
             pw_param = DielectricMagneticParamReal()
             
         if underneath is None:
@@ -384,15 +536,22 @@ class Dielectric(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
-            pw_obj = DielectricHzCmplx()
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DielectricGridHzCmplxSingle()
+            pw_param = DielectricMagneticParamCmplxSingle()
+        elif cmplx:
+            pw_obj = DielectricGridHzCmplx()
             pw_param = DielectricMagneticParamCmplx()
+        elif single:
+            pw_obj = DielectricGridHzRealSingle()
+            pw_param = DielectricMagneticParamRealSingle()
         else:
-            pw_obj = DielectricHzReal()
+            pw_obj = DielectricGridHzReal()
             pw_param = DielectricMagneticParamReal()
             
         if underneath is None:
@@ -400,7 +559,7 @@ class Dielectric(Material):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
 
@@ -531,6 +690,8 @@ class Upml(Pml):
         sigma_max_ratio -- the ratio between sigma_max and sigma_opt. default 0.745
 
     """    
+    cost = 6
+
     def __init__(self, eps_inf=1, mu_inf=1, m=3.6, kappa_max=4.6, sigma_max_ratio=.745):
         Pml.__init__(self, eps_inf, mu_inf)
 
@@ -602,10 +763,17 @@ class Upml(Pml):
             - self.sigma(w, component) * self.dt
         return numerator
     
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = UpmlExCmplxSingle()
+            pw_param = UpmlElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = UpmlExCmplx()
             pw_param = UpmlElectricParamCmplx()
+        elif single:
+            pw_obj = UpmlExRealSingle()
+            pw_param = UpmlElectricParamRealSingle()
         else:
             pw_obj = UpmlExReal()
             pw_param = UpmlElectricParamReal()
@@ -615,20 +783,24 @@ class Upml(Pml):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_param.c1 = self.c1(coords[1], 1)
-        pw_param.c2 = self.c2(coords[1], 1)
-        pw_param.c3 = self.c3(coords[2], 2)
-        pw_param.c4 = self.c4(coords[2], 2)
-        pw_param.c5 = self.c5(coords[0], 0)
-        pw_param.c6 = self.c6(coords[0], 0)
-        
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.c1(pt[1], 1), self.c2(pt[1], 1),
+                   self.c3(pt[2], 2), self.c4(pt[2], 2),
+                   self.c5(pt[0], 0), self.c6(pt[0], 0))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = UpmlEyCmplxSingle()
+            pw_param = UpmlElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = UpmlEyCmplx()
             pw_param = UpmlElectricParamCmplx()
+        elif single:
+            pw_obj = UpmlEyRealSingle()
+            pw_param = UpmlElectricParamRealSingle()
         else:
             pw_obj = UpmlEyReal()
             pw_param = UpmlElectricParamReal()
@@ -638,20 +810,24 @@ class Upml(Pml):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_param.c1 = self.c1(coords[2], 2)
-        pw_param.c2 = self.c2(coords[2], 2)
-        pw_param.c3 = self.c3(coords[0], 0)
-        pw_param.c4 = self.c4(coords[0], 0)
-        pw_param.c5 = self.c5(coords[1], 1)
-        pw_param.c6 = self.c6(coords[1], 1)
-        
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.c1(pt[2], 2), self.c2(pt[2], 2),
+                   self.c3(pt[0], 0), self.c4(pt[0], 0),
+                   self.c5(pt[1], 1), self.c6(pt[1], 1))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = UpmlEzCmplxSingle()
+            pw_param = UpmlElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = UpmlEzCmplx()
             pw_param = UpmlElectricParamCmplx()
+        elif single:
+            pw_obj = UpmlEzRealSingle()
+            pw_param = UpmlElectricParamRealSingle()
         else:
             pw_obj = UpmlEzReal()
             pw_param = UpmlElectricParamReal()
@@ -661,20 +837,24 @@ class Upml(Pml):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_param.c1 = self.c1(coords[0], 0)
-        pw_param.c2 = self.c2(coords[0], 0)
-        pw_param.c3 = self.c3(coords[1], 1)
-        pw_param.c4 = self.c4(coords[1], 1)
-        pw_param.c5 = self.c5(coords[2], 2)
-        pw_param.c6 = self.c6(coords[2], 2)
-
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.c1(pt[0], 0), self.c2(pt[0], 0),
+                   self.c3(pt[1], 1), self.c4(pt[1], 1),
+                   self.c5(pt[2], 2), self.c6(pt[2], 2))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = UpmlHxCmplxSingle()
+            pw_param = UpmlMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = UpmlHxCmplx()
             pw_param = UpmlMagneticParamCmplx()
+        elif single:
+            pw_obj = UpmlHxRealSingle()
+            pw_param = UpmlMagneticParamRealSingle()
         else:
             pw_obj = UpmlHxReal()
             pw_param = UpmlMagneticParamReal()
@@ -684,20 +864,24 @@ class Upml(Pml):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_param.c1 = self.c1(coords[1], 1)
-        pw_param.c2 = self.c2(coords[1], 1)
-        pw_param.c3 = self.c3(coords[2], 2)
-        pw_param.c4 = self.c4(coords[2], 2)
-        pw_param.c5 = self.c5(coords[0], 0)
-        pw_param.c6 = self.c6(coords[0], 0)
-        
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.c1(pt[1], 1), self.c2(pt[1], 1),
+                   self.c3(pt[2], 2), self.c4(pt[2], 2),
+                   self.c5(pt[0], 0), self.c6(pt[0], 0))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = UpmlHyCmplxSingle()
+            pw_param = UpmlMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = UpmlHyCmplx()
             pw_param = UpmlMagneticParamCmplx()
+        elif single:
+            pw_obj = UpmlHyRealSingle()
+            pw_param = UpmlMagneticParamRealSingle()
         else:
             pw_obj = UpmlHyReal()
             pw_param = UpmlMagneticParamReal()
@@ -707,20 +891,24 @@ class Upml(Pml):
         else:
             pw_param.mu_inf = underneath.mu_inf
             
-        pw_param.c1 = self.c1(coords[2], 2)
-        pw_param.c2 = self.c2(coords[2], 2)
-        pw_param.c3 = self.c3(coords[0], 0)
-        pw_param.c4 = self.c4(coords[0], 0)
-        pw_param.c5 = self.c5(coords[1], 1)
-        pw_param.c6 = self.c6(coords[1], 1)
-        
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.c1(pt[2], 2), self.c2(pt[2], 2),
+                   self.c3(pt[0], 0), self.c4(pt[0], 0),
+                   self.c5(pt[1], 1), self.c6(pt[1], 1))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = UpmlHzCmplxSingle()
+            pw_param = UpmlMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = UpmlHzCmplx()
             pw_param = UpmlMagneticParamCmplx()
+        elif single:
+            pw_obj = UpmlHzRealSingle()
+            pw_param = UpmlMagneticParamRealSingle()
         else:
             pw_obj = UpmlHzReal()
             pw_param = UpmlMagneticParamReal()
@@ -730,14 +918,11 @@ class Upml(Pml):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_param.c1 = self.c1(coords[0], 0)
-        pw_param.c2 = self.c2(coords[0], 0)
-        pw_param.c3 = self.c3(coords[1], 1)
-        pw_param.c4 = self.c4(coords[1], 1)
-        pw_param.c5 = self.c5(coords[2], 2)
-        pw_param.c6 = self.c6(coords[2], 2)
-        
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.c1(pt[0], 0), self.c2(pt[0], 0),
+                   self.c3(pt[1], 1), self.c4(pt[1], 1),
+                   self.c5(pt[2], 2), self.c6(pt[2], 2))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
     
@@ -760,6 +945,8 @@ class Cpml(Pml):
         sigma_max_ratio -- default 0.65
     
     """
+    cost = 5
+
     def __init__(self, eps_inf=1, mu_inf=1, m=3.4, kappa_max=1, m_a=4.8, a_max=0.8, sigma_max_ratio=0.65):
         Pml.__init__(self, eps_inf, mu_inf)
 
@@ -829,10 +1016,17 @@ class Cpml(Pml):
         else:
             return 0
     
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = CpmlExCmplxSingle()
+            pw_param = CpmlElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = CpmlExCmplx()
             pw_param = CpmlElectricParamCmplx()
+        elif single:
+            pw_obj = CpmlExRealSingle()
+            pw_param = CpmlElectricParamRealSingle()
         else:
             pw_obj = CpmlExReal()
             pw_param = CpmlElectricParamReal()
@@ -842,20 +1036,24 @@ class Cpml(Pml):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_param.b1 = self.b(coords[1], 1)
-        pw_param.b2 = self.b(coords[2], 2)
-        pw_param.c1 = self.c(coords[1], 1)
-        pw_param.c2 = self.c(coords[2], 2)
-        pw_param.kappa1 = self.kappa(coords[1], 1)
-        pw_param.kappa2 = self.kappa(coords[2], 2)
-
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.b(pt[1], 1), self.b(pt[2], 2),
+                   self.c(pt[1], 1), self.c(pt[2], 2),
+                   self.kappa(pt[1], 1), self.kappa(pt[2], 2))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = CpmlEyCmplxSingle()
+            pw_param = CpmlElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = CpmlEyCmplx()
             pw_param = CpmlElectricParamCmplx()
+        elif single:
+            pw_obj = CpmlEyRealSingle()
+            pw_param = CpmlElectricParamRealSingle()
         else:
             pw_obj = CpmlEyReal()
             pw_param = CpmlElectricParamReal()
@@ -865,20 +1063,24 @@ class Cpml(Pml):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_param.b1 = self.b(coords[2], 2)
-        pw_param.b2 = self.b(coords[0], 0)
-        pw_param.c1 = self.c(coords[2], 2)
-        pw_param.c2 = self.c(coords[0], 0)
-        pw_param.kappa1 = self.kappa(coords[2], 2)
-        pw_param.kappa2 = self.kappa(coords[0], 0)
-        
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.b(pt[2], 2), self.b(pt[0], 0),
+                   self.c(pt[2], 2), self.c(pt[0], 0),
+                   self.kappa(pt[2], 2), self.kappa(pt[0], 0))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = CpmlEzCmplxSingle()
+            pw_param = CpmlElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = CpmlEzCmplx()
             pw_param = CpmlElectricParamCmplx()
+        elif single:
+            pw_obj = CpmlEzRealSingle()
+            pw_param = CpmlElectricParamRealSingle()
         else:
             pw_obj = CpmlEzReal()
             pw_param = CpmlElectricParamReal()
@@ -888,19 +1090,24 @@ class Cpml(Pml):
         else:
             pw_param.eps_inf = underneath.eps_inf
         
-        pw_param.b1 = self.b(coords[0], 0)
-        pw_param.b2 = self.b(coords[1], 1)
-        pw_param.c1 = self.c(coords[0], 0)
-        pw_param.c2 = self.c(coords[1], 1)
-        pw_param.kappa1 = self.kappa(coords[0], 0)
-        pw_param.kappa2 = self.kappa(coords[1], 1)
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.b(pt[0], 0), self.b(pt[1], 1),
+                   self.c(pt[0], 0), self.c(pt[1], 1),
+                   self.kappa(pt[0], 0), self.kappa(pt[1], 1))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = CpmlHxCmplxSingle()
+            pw_param = CpmlMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = CpmlHxCmplx()
             pw_param = CpmlMagneticParamCmplx()
+        elif single:
+            pw_obj = CpmlHxRealSingle()
+            pw_param = CpmlMagneticParamRealSingle()
         else:
             pw_obj = CpmlHxReal()
             pw_param = CpmlMagneticParamReal()
@@ -910,19 +1117,24 @@ class Cpml(Pml):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_param.b1 = self.b(coords[1], 1)
-        pw_param.b2 = self.b(coords[2], 2)
-        pw_param.c1 = self.c(coords[1], 1)
-        pw_param.c2 = self.c(coords[2], 2)
-        pw_param.kappa1 = self.kappa(coords[1], 1)
-        pw_param.kappa2 = self.kappa(coords[2], 2)
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.b(pt[1], 1), self.b(pt[2], 2),
+                   self.c(pt[1], 1), self.c(pt[2], 2),
+                   self.kappa(pt[1], 1), self.kappa(pt[2], 2))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = CpmlHyCmplxSingle()
+            pw_param = CpmlMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = CpmlHyCmplx()
             pw_param = CpmlMagneticParamCmplx()
+        elif single:
+            pw_obj = CpmlHyRealSingle()
+            pw_param = CpmlMagneticParamRealSingle()
         else:
             pw_obj = CpmlHyReal()
             pw_param = CpmlMagneticParamReal()
@@ -932,19 +1144,24 @@ class Cpml(Pml):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_param.b1 = self.b(coords[2], 2)
-        pw_param.b2 = self.b(coords[0], 0)
-        pw_param.c1 = self.c(coords[2], 2)
-        pw_param.c2 = self.c(coords[0], 0)
-        pw_param.kappa1 = self.kappa(coords[2], 2)
-        pw_param.kappa2 = self.kappa(coords[0], 0)
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.b(pt[2], 2), self.b(pt[0], 0),
+                   self.c(pt[2], 2), self.c(pt[0], 0),
+                   self.kappa(pt[2], 2), self.kappa(pt[0], 0))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
     
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = CpmlHzCmplxSingle()
+            pw_param = CpmlMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = CpmlHzCmplx()
             pw_param = CpmlMagneticParamCmplx()
+        elif single:
+            pw_obj = CpmlHzRealSingle()
+            pw_param = CpmlMagneticParamRealSingle()
         else:
             pw_obj = CpmlHzReal()
             pw_param = CpmlMagneticParamReal()
@@ -954,13 +1171,11 @@ class Cpml(Pml):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_param.b1 = self.b(coords[0], 0)
-        pw_param.b2 = self.b(coords[1], 1)
-        pw_param.c1 = self.c(coords[0], 0)
-        pw_param.c2 = self.c(coords[1], 1)
-        pw_param.kappa1 = self.kappa(coords[0], 0)
-        pw_param.kappa2 = self.kappa(coords[1], 1)
-        pw_obj.attach(idx, pw_param)
+        coeffs = [(self.b(pt[0], 0), self.b(pt[1], 1),
+                   self.c(pt[0], 0), self.c(pt[1], 1),
+                   self.kappa(pt[0], 0), self.kappa(pt[1], 1))
+                  for pt in _points(coords)]
+        _attach(pw_obj, idx, pw_param, coeffs)
         return pw_obj
         
 
@@ -1037,6 +1252,8 @@ class CriticalPoint(object):
         
 
 class DcpAde(Dielectric):
+    cost = 10
+
     def __init__(self, eps_inf=1, mu_inf=1, sigma=0, dps=(), cps=()):
         """
         eps_inf: The (frequency-independent) relative permittivity. Default is 1.
@@ -1131,10 +1348,17 @@ class DcpAde(Dielectric):
         for i in self.cps:
             i.display_info(indent+4)
         
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpAdeExCmplxSingle()
+            pw_param = DcpAdeElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpAdeExCmplx()
             pw_param = DcpAdeElectricParamCmplx()
+        elif single:
+            pw_obj = DcpAdeExRealSingle()
+            pw_param = DcpAdeElectricParamRealSingle()
         else:
             pw_obj = DcpAdeExReal()
             pw_param = DcpAdeElectricParamReal()
@@ -1146,13 +1370,20 @@ class DcpAde(Dielectric):
         
         pw_param.set(self.a, self.b, self.c)
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpAdeEyCmplxSingle()
+            pw_param = DcpAdeElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpAdeEyCmplx()
             pw_param = DcpAdeElectricParamCmplx()
+        elif single:
+            pw_obj = DcpAdeEyRealSingle()
+            pw_param = DcpAdeElectricParamRealSingle()
         else:
             pw_obj = DcpAdeEyReal()
             pw_param = DcpAdeElectricParamReal()
@@ -1164,13 +1395,20 @@ class DcpAde(Dielectric):
         
         pw_param.set(self.a, self.b, self.c)
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpAdeEzCmplxSingle()
+            pw_param = DcpAdeElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpAdeEzCmplx()
             pw_param = DcpAdeElectricParamCmplx()
+        elif single:
+            pw_obj = DcpAdeEzRealSingle()
+            pw_param = DcpAdeElectricParamRealSingle()
         else:
             pw_obj = DcpAdeEzReal()
             pw_param = DcpAdeElectricParamReal()
@@ -1182,13 +1420,20 @@ class DcpAde(Dielectric):
         
         pw_param.set(self.a, self.b, self.c)
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpAdeHxCmplxSingle()
+            pw_param = DcpAdeMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpAdeHxCmplx()
             pw_param = DcpAdeMagneticParamCmplx()
+        elif single:
+            pw_obj = DcpAdeHxRealSingle()
+            pw_param = DcpAdeMagneticParamRealSingle()
         else:
             pw_obj = DcpAdeHxReal()
             pw_param = DcpAdeMagneticParamReal()
@@ -1198,13 +1443,20 @@ class DcpAde(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpAdeHyCmplxSingle()
+            pw_param = DcpAdeMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpAdeHyCmplx()
             pw_param = DcpAdeMagneticParamCmplx()
+        elif single:
+            pw_obj = DcpAdeHyRealSingle()
+            pw_param = DcpAdeMagneticParamRealSingle()
         else:
             pw_obj = DcpAdeHyReal()
             pw_param = DcpAdeMagneticParamReal()
@@ -1214,13 +1466,20 @@ class DcpAde(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpAdeHzCmplxSingle()
+            pw_param = DcpAdeMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpAdeHzCmplx()
             pw_param = DcpAdeMagneticParamCmplx()
+        elif single:
+            pw_obj = DcpAdeHzRealSingle()
+            pw_param = DcpAdeMagneticParamRealSingle()
         else:
             pw_obj = DcpAdeHzReal()
             pw_param = DcpAdeMagneticParamReal()
@@ -1230,7 +1489,7 @@ class DcpAde(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
 
@@ -1246,6 +1505,8 @@ class DcpPlrc(Dielectric):
       2005.
 
     """
+    cost = 10
+
     def __init__(self, eps_inf=1, mu_inf=1, sigma=0, dps=(), cps=()):
         """
         eps_inf: The (frequency-independent) relative permittivity. Default is 1.
@@ -1380,10 +1641,17 @@ class DcpPlrc(Dielectric):
         for i in self.cps:
             i.display_info(indent+4)
         
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpPlrcExCmplxSingle()
+            pw_param = DcpPlrcElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpPlrcExCmplx()
             pw_param = DcpPlrcElectricParamCmplx()
+        elif single:
+            pw_obj = DcpPlrcExRealSingle()
+            pw_param = DcpPlrcElectricParamRealSingle()
         else:
             pw_obj = DcpPlrcExReal()
             pw_param = DcpPlrcElectricParamReal()
@@ -1394,13 +1662,20 @@ class DcpPlrc(Dielectric):
             pw_param.eps_inf = underneath.eps_inf
         
         pw_param.set(self.a, self.b, self.c)
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpPlrcEyCmplxSingle()
+            pw_param = DcpPlrcElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpPlrcEyCmplx()
             pw_param = DcpPlrcElectricParamCmplx()
+        elif single:
+            pw_obj = DcpPlrcEyRealSingle()
+            pw_param = DcpPlrcElectricParamRealSingle()
         else:
             pw_obj = DcpPlrcEyReal()
             pw_param = DcpPlrcElectricParamReal()
@@ -1411,13 +1686,20 @@ class DcpPlrc(Dielectric):
             pw_param.eps_inf = underneath.eps_inf
         
         pw_param.set(self.a, self.b, self.c)
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpPlrcEzCmplxSingle()
+            pw_param = DcpPlrcElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpPlrcEzCmplx()
             pw_param = DcpPlrcElectricParamCmplx()
+        elif single:
+            pw_obj = DcpPlrcEzRealSingle()
+            pw_param = DcpPlrcElectricParamRealSingle()
         else:
             pw_obj = DcpPlrcEzReal()
             pw_param = DcpPlrcElectricParamReal()
@@ -1428,13 +1710,20 @@ class DcpPlrc(Dielectric):
             pw_param.eps_inf = underneath.eps_inf
         
         pw_param.set(self.a, self.b, self.c)
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpPlrcHxCmplxSingle()
+            pw_param = DcpPlrcMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpPlrcHxCmplx()
             pw_param = DcpPlrcMagneticParamCmplx()
+        elif single:
+            pw_obj = DcpPlrcHxRealSingle()
+            pw_param = DcpPlrcMagneticParamRealSingle()
         else:
             pw_obj = DcpPlrcHxReal()
             pw_param = DcpPlrcMagneticParamReal()
@@ -1444,13 +1733,20 @@ class DcpPlrc(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpPlrcHyCmplxSingle()
+            pw_param = DcpPlrcMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpPlrcHyCmplx()
             pw_param = DcpPlrcMagneticParamCmplx()
+        elif single:
+            pw_obj = DcpPlrcHyRealSingle()
+            pw_param = DcpPlrcMagneticParamRealSingle()
         else:
             pw_obj = DcpPlrcHyReal()
             pw_param = DcpPlrcMagneticParamReal()
@@ -1460,13 +1756,20 @@ class DcpPlrc(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DcpPlrcHzCmplxSingle()
+            pw_param = DcpPlrcMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DcpPlrcHzCmplx()
             pw_param = DcpPlrcMagneticParamCmplx()
+        elif single:
+            pw_obj = DcpPlrcHzRealSingle()
+            pw_param = DcpPlrcMagneticParamRealSingle()
         else:
             pw_obj = DcpPlrcHzReal()
             pw_param = DcpPlrcMagneticParamReal()
@@ -1476,7 +1779,7 @@ class DcpPlrc(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
     
@@ -1514,6 +1817,8 @@ class Drude(Dielectric):
     Electron. Lett., vol. 42, no. 9, pp. 503-504, 2006.
     
     """
+    cost = 3
+
     def __init__(self, eps_inf=1, mu_inf=1, sigma=0, dps=()):
         """
         Arguments:
@@ -1587,10 +1892,17 @@ class Drude(Dielectric):
         for p in self.dps:
             p.display_info(indent+4)
         
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DrudeExCmplxSingle()
+            pw_param = DrudeElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DrudeExCmplx()
             pw_param = DrudeElectricParamCmplx()
+        elif single:
+            pw_obj = DrudeExRealSingle()
+            pw_param = DrudeElectricParamRealSingle()
         else:
             pw_obj = DrudeExReal()
             pw_param = DrudeElectricParamReal()
@@ -1602,13 +1914,20 @@ class Drude(Dielectric):
         
         pw_param.set(self.a, self.c)
 
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DrudeEyCmplxSingle()
+            pw_param = DrudeElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DrudeEyCmplx()
             pw_param = DrudeElectricParamCmplx()
+        elif single:
+            pw_obj = DrudeEyRealSingle()
+            pw_param = DrudeElectricParamRealSingle()
         else:
             pw_obj = DrudeEyReal()
             pw_param = DrudeElectricParamReal()
@@ -1620,13 +1939,20 @@ class Drude(Dielectric):
         
         pw_param.set(self.a, self.c)
 
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DrudeEzCmplxSingle()
+            pw_param = DrudeElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = DrudeEzCmplx()
             pw_param = DrudeElectricParamCmplx()
+        elif single:
+            pw_obj = DrudeEzRealSingle()
+            pw_param = DrudeElectricParamRealSingle()
         else:
             pw_obj = DrudeEzReal()
             pw_param = DrudeElectricParamReal()
@@ -1638,13 +1964,20 @@ class Drude(Dielectric):
         
         pw_param.set(self.a, self.c)
 
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DrudeHxCmplxSingle()
+            pw_param = DrudeMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DrudeHxCmplx()
             pw_param = DrudeMagneticParamCmplx()
+        elif single:
+            pw_obj = DrudeHxRealSingle()
+            pw_param = DrudeMagneticParamRealSingle()
         else:
             pw_obj = DrudeHxReal()
             pw_param = DrudeMagneticParamReal()
@@ -1654,13 +1987,20 @@ class Drude(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DrudeHyCmplxSingle()
+            pw_param = DrudeMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DrudeHyCmplx()
             pw_param = DrudeMagneticParamCmplx()
+        elif single:
+            pw_obj = DrudeHyRealSingle()
+            pw_param = DrudeMagneticParamRealSingle()
         else:
             pw_obj = DrudeHyReal()
             pw_param = DrudeMagneticParamReal()
@@ -1670,13 +2010,20 @@ class Drude(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = DrudeHzCmplxSingle()
+            pw_param = DrudeMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = DrudeHzCmplx()
             pw_param = DrudeMagneticParamCmplx()
+        elif single:
+            pw_obj = DrudeHzRealSingle()
+            pw_param = DrudeMagneticParamRealSingle()
         else:
             pw_obj = DrudeHzReal()
             pw_param = DrudeMagneticParamReal()
@@ -1686,7 +2033,7 @@ class Drude(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
 
@@ -1695,6 +2042,8 @@ class Lorentz(Dielectric):
     The auxiliary differential equation implementation of the Lorentz model.
     
     """
+    cost = 3
+
     def __init__(self, eps_inf=1, mu_inf=1, sigma=0, lps=()):
         """
         Arguments:
@@ -1765,10 +2114,17 @@ class Lorentz(Dielectric):
         for p in self.lps:
             p.display_info(indent+4)
         
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = LorentzExCmplxSingle()
+            pw_param = LorentzElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = LorentzExCmplx()
             pw_param = LorentzElectricParamCmplx()
+        elif single:
+            pw_obj = LorentzExRealSingle()
+            pw_param = LorentzElectricParamRealSingle()
         else:
             pw_obj = LorentzExReal()
             pw_param = LorentzElectricParamReal()
@@ -1779,13 +2135,20 @@ class Lorentz(Dielectric):
             pw_param.eps_inf = underneath.eps_inf
         
         pw_param.set(self.a, self.c)
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = LorentzEyCmplxSingle()
+            pw_param = LorentzElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = LorentzEyCmplx()
             pw_param = LorentzElectricParamCmplx()
+        elif single:
+            pw_obj = LorentzEyRealSingle()
+            pw_param = LorentzElectricParamRealSingle()
         else:
             pw_obj = LorentzEyReal()
             pw_param = LorentzElectricParamReal()
@@ -1796,13 +2159,20 @@ class Lorentz(Dielectric):
             pw_param.eps_inf = underneath.eps_inf
         
         pw_param.set(self.a, self.c)
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = LorentzEzCmplxSingle()
+            pw_param = LorentzElectricParamCmplxSingle()
+        elif cmplx:
             pw_obj = LorentzEzCmplx()
             pw_param = LorentzElectricParamCmplx()
+        elif single:
+            pw_obj = LorentzEzRealSingle()
+            pw_param = LorentzElectricParamRealSingle()
         else:
             pw_obj = LorentzEzReal()
             pw_param = LorentzElectricParamReal()
@@ -1813,13 +2183,20 @@ class Lorentz(Dielectric):
             pw_param.eps_inf = underneath.eps_inf
         
         pw_param.set(self.a, self.c)
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = LorentzHxCmplxSingle()
+            pw_param = LorentzMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = LorentzHxCmplx()
             pw_param = LorentzMagneticParamCmplx()
+        elif single:
+            pw_obj = LorentzHxRealSingle()
+            pw_param = LorentzMagneticParamRealSingle()
         else:
             pw_obj = LorentzHxReal()
             pw_param = LorentzMagneticParamReal()
@@ -1829,13 +2206,20 @@ class Lorentz(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = LorentzHyCmplxSingle()
+            pw_param = LorentzMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = LorentzHyCmplx()
             pw_param = LorentzMagneticParamCmplx()
+        elif single:
+            pw_obj = LorentzHyRealSingle()
+            pw_param = LorentzMagneticParamRealSingle()
         else:
             pw_obj = LorentzHyReal()
             pw_param = LorentzMagneticParamReal()
@@ -1845,13 +2229,20 @@ class Lorentz(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
-        if cmplx:
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
+        if cmplx and single:
+            pw_obj = LorentzHzCmplxSingle()
+            pw_param = LorentzMagneticParamCmplxSingle()
+        elif cmplx:
             pw_obj = LorentzHzCmplx()
             pw_param = LorentzMagneticParamCmplx()
+        elif single:
+            pw_obj = LorentzHzRealSingle()
+            pw_param = LorentzMagneticParamRealSingle()
         else:
             pw_obj = LorentzHzReal()
             pw_param = LorentzMagneticParamReal()
@@ -1861,7 +2252,7 @@ class Lorentz(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
 
@@ -1871,7 +2262,9 @@ class Dm2(Dielectric):
     a two-level medium.
     
     """
-    def __init__(self, eps_inf=1, mu_inf=1, omega=(1,), n_atom=(1,), rho30=-1, gamma=1, t1=1, t2=1, hbar=1, rtol=10e-5):
+    cost = 50
+
+    def __init__(self, eps_inf=1, mu_inf=1, omega=(1,), n_atom=(1,), rho30=-1, gamma=1, t1=1, t2=1, hbar=1, rtol=10e-5, solver='fixed-point'):
         """
         Arguments:
             eps_inf: float, optional
@@ -1895,6 +2288,14 @@ class Dm2(Dielectric):
                 The normalized reduced Planck constant. Defaults to 1.
             rtol: float, optional
                 relative tolerance for solution. Default is 10e-5.
+            solver: str, optional
+                'fixed-point' iterates the update equations of a cell
+                until they settle. 'newton' runs Newton iterations on 
+                the field of several cells at a time, which converge 
+                in fewer passes for strong fields. The iteration counts
+                are reported by solved_num, iteration_num, and 
+                max_iteration_num of the pw materials. Defaults to 
+                'fixed-point'.
 
         """
         Dielectric.__init__(self, eps_inf, mu_inf)
@@ -1915,6 +2316,10 @@ class Dm2(Dielectric):
         self.hbar = float(hbar)
         self.rtol = float(rtol)
 
+        if solver not in ('fixed-point', 'newton'):
+            raise ValueError("solver must be 'fixed-point' or 'newton'")
+        self.solver = solver
+
     def __getstate__(self):
         d = Dielectric.__setstate__(self)
         d['omega'] = deepcopoy(self.omega)
@@ -1925,6 +2330,7 @@ class Dm2(Dielectric):
         d['t2'] = self.t2
         d['hbar'] = self.hbar
         d['rtol'] = self.rtol
+        d['solver'] = self.solver
         d['initialized'] = self.initialized
 
         if self.initialized:
@@ -1939,6 +2345,7 @@ class Dm2(Dielectric):
         self.t2 = d['t2']
         self.hbar = d['hbar']
         self.rtol = d['rtol']
+        self.solver = d.get('solver', 'fixed-point')
         self.initialized = d['initialized']
 
         if self.initialized:
@@ -1964,10 +2371,15 @@ class Dm2(Dielectric):
         print "dephasing time:", self.t2
         print "normzlied reduced Planck constant:", self.hbar
         print "relative tolerance:", self.rtol
+        print "solver:", self.solver
 
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         if cmplx:
             raise ValueError('Dm2 class supports real fields only')
+        elif single:
+            pw_obj = Dm2ExRealSingle()
+            pw_param = Dm2ElectricParamRealSingle()
         else:
             pw_obj = Dm2ExReal()
             pw_param = Dm2ElectricParamReal()
@@ -1984,13 +2396,21 @@ class Dm2(Dielectric):
         pw_param.t2 = self.t2
         pw_param.hbar = self.hbar
         pw_param.rtol = self.rtol
+        if self.solver == 'newton':
+            pw_param.solver = DM2_NEWTON
+        else:
+            pw_param.solver = DM2_FIXED_POINT
 
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
         
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         if cmplx:
             raise ValueError('Dm2 class supports real fields only')
+        elif single:
+            pw_obj = Dm2EyRealSingle()
+            pw_param = Dm2ElectricParamRealSingle()
         else:
             pw_obj = Dm2EyReal()
             pw_param = Dm2ElectricParamReal()
@@ -2008,13 +2428,21 @@ class Dm2(Dielectric):
         pw_param.t2 = self.t2
         pw_param.hbar = self.hbar
         pw_param.rtol = self.rtol
+        if self.solver == 'newton':
+            pw_param.solver = DM2_NEWTON
+        else:
+            pw_param.solver = DM2_FIXED_POINT
 
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         if cmplx:
             raise ValueError('Dm2 class supports real fields only')
+        elif single:
+            pw_obj = Dm2EzRealSingle()
+            pw_param = Dm2ElectricParamRealSingle()
         else:
             pw_obj = Dm2EzReal()
             pw_param = Dm2ElectricParamReal()
@@ -2032,13 +2460,21 @@ class Dm2(Dielectric):
         pw_param.t2 = self.t2
         pw_param.hbar = self.hbar
         pw_param.rtol = self.rtol
+        if self.solver == 'newton':
+            pw_param.solver = DM2_NEWTON
+        else:
+            pw_param.solver = DM2_FIXED_POINT
 
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         if cmplx:
             raise ValueError('Dm2 class supports real fields only')
+        elif single:
+            pw_obj = Dm2HxRealSingle()
+            pw_param = Dm2MagneticParamRealSingle()
         else:
             pw_obj = Dm2HxReal()
             pw_param = Dm2MagneticParamReal()
@@ -2048,12 +2484,16 @@ class Dm2(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)    
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         if cmplx:
             raise ValueError('Dm2 class supports real fields only')
+        elif single:
+            pw_obj = Dm2HyRealSingle()
+            pw_param = Dm2MagneticParamRealSingle()
         else:
             pw_obj = Dm2HyReal()
             pw_param = Dm2MagneticParamReal()
@@ -2063,12 +2503,16 @@ class Dm2(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
 
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         if cmplx:
             raise ValueError('Dm2 class supports real fields only')
+        elif single:
+            pw_obj = Dm2HzRealSingle()
+            pw_param = Dm2MagneticParamRealSingle()
         else:
             pw_obj = Dm2HzReal()
             pw_param = Dm2MagneticParamReal()
@@ -2078,5 +2522,5 @@ class Dm2(Dielectric):
         else:
             pw_param.mu_inf = underneath.mu_inf
         
-        pw_obj.attach(idx, pw_param)
+        _attach(pw_obj, idx, pw_param)
         return pw_obj
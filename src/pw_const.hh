@@ -5,8 +5,6 @@
 #include <utility>
 #include "pw_material.hh"
 
-#define inplace_field(i,j,k) inplace_field[inplace_dim1==1&&inplace_dim2==1&&inplace_dim3==1?0:((i)*inplace_dim2+(j))*inplace_dim3+(k)]
-
 namespace gmes
 {
   template <typename T> 
@@ -31,18 +29,6 @@ namespace gmes
       return ConstElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size, 
 	   const PwMaterialParam* const pm_param_ptr)
@@ -53,17 +39,26 @@ namespace gmes
       const auto& const_param = *static_cast<const ConstElectricParam<T>*>(pm_param_ptr);
       
       idx_list.push_back(index);
-      param_list.push_back(const_param);
+      eps_inf_list.push_back(const_param.eps_inf);
+      value_list.push_back(const_param.value);
 
       return this;
     }
     
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(value_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto const_ptr = static_cast<const ConstElectric<T>*>(pm_ptr);
       std::copy(const_ptr->idx_list.begin(), const_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(const_ptr->param_list.begin(), const_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(const_ptr->eps_inf_list.begin(), const_ptr->eps_inf_list.end(), std::back_inserter(eps_inf_list));
+      std::copy(const_ptr->value_list.begin(), const_ptr->value_list.end(), std::back_inserter(value_list));
       return this;
     }
 
@@ -76,33 +71,48 @@ namespace gmes
 	       int in2_dim1, int in2_dim2, int in2_dim3,
 	       double d1, double d2, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(inplace_field, inplace_dim1, inplace_dim2, inplace_dim3,
-    	       in_field1, in1_dim1, in1_dim2, in1_dim3,
-    	       in_field2, in2_dim1, in2_dim2, in2_dim3,
-    	       d1, d2, dt, n, *idx, *param);
+      update_fields(*this, inplace_field,
+		    inplace_dim1 == 1 && inplace_dim2 == 1 && inplace_dim3 == 1,
+		    inplace_dim2, inplace_dim3,
+		    in_field1, in1_dim1 == 1 && in1_dim2 == 1 && in1_dim3 == 1,
+		    in1_dim2, in1_dim3,
+		    in_field2, in2_dim1 == 1 && in2_dim2 == 1 && in2_dim3 == 1,
+		    in2_dim2, in2_dim3,
+		    d1, d2, dt, n);
+    }
+
+    template <class Inplace, class In1, class In2>
+    void
+    update_cells(const Inplace& inplace_field, const In1& in_field1,
+		 const In2& in_field2, double d1, double d2, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(inplace_field, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(inplace_field, in_field1, in_field2, d1, d2, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T * const inplace_field, 
-	   int inplace_dim1, int inplace_dim2, int inplace_dim3,
-	   const T * const in_field1, int in1_dim1, int in1_dim2, int in1_dim3,
-	   const T * const in_field2, int in2_dim1, int in2_dim2, int in2_dim3,
-	   double d1, double d2, double dt, double n,
-	   const Index3& idx, 
-	   const ConstElectricParam<T>& const_param) const
+    template <class Inplace, class In1, class In2>
+    void
+    update(const Inplace& inplace_field, const In1& in_field1,
+	   const In2& in_field2, double d1, double d2, double dt, double n,
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      inplace_field(i,j,k) = const_param.value;
+      inplace_field(i,j,k) = value_list[p];
     }
 
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<ConstElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    std::vector<T, AlignedAllocator<T> > value_list;
 
   private:
     static const std::string tag; // "ConstElectric"
@@ -136,18 +146,6 @@ namespace gmes
       return ConstMagnetic<T>::tag;
     }
 
-    double
-    get_mu_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].mu_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size, 
 	   const PwMaterialParam* const pm_param_ptr)
@@ -158,17 +156,26 @@ namespace gmes
       const auto& const_param = *static_cast<const ConstMagneticParam<T>*>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(const_param);
+      mu_inf_list.push_back(const_param.mu_inf);
+      value_list.push_back(const_param.value);
 
       return this;
     }
 
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialMagnetic<T>::reserve(cell_num);
+      reserve_more(value_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto const_ptr = static_cast<const ConstMagnetic<T>*>(pm_ptr);
       std::copy(const_ptr->idx_list.begin(), const_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(const_ptr->param_list.begin(), const_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(const_ptr->mu_inf_list.begin(), const_ptr->mu_inf_list.end(), std::back_inserter(mu_inf_list));
+      std::copy(const_ptr->value_list.begin(), const_ptr->value_list.end(), std::back_inserter(value_list));
       return this;
     }
 
@@ -181,33 +188,48 @@ namespace gmes
 	       int in2_dim1, int in2_dim2, int in2_dim3,
 	       double d1, double d2, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(inplace_field, inplace_dim1, inplace_dim2, inplace_dim3,
-    	       in_field1, in1_dim1, in1_dim2, in1_dim3,
-    	       in_field2, in2_dim1, in2_dim2, in2_dim3,
-    	       d1, d2, dt, n, *idx, *param);
+      update_fields(*this, inplace_field,
+		    inplace_dim1 == 1 && inplace_dim2 == 1 && inplace_dim3 == 1,
+		    inplace_dim2, inplace_dim3,
+		    in_field1, in1_dim1 == 1 && in1_dim2 == 1 && in1_dim3 == 1,
+		    in1_dim2, in1_dim3,
+		    in_field2, in2_dim1 == 1 && in2_dim2 == 1 && in2_dim3 == 1,
+		    in2_dim2, in2_dim3,
+		    d1, d2, dt, n);
+    }
+
+    template <class Inplace, class In1, class In2>
+    void
+    update_cells(const Inplace& inplace_field, const In1& in_field1,
+		 const In2& in_field2, double d1, double d2, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(inplace_field, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(inplace_field, in_field1, in_field2, d1, d2, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T * const inplace_field, 
-	   int inplace_dim1, int inplace_dim2, int inplace_dim3,
-	   const T * const in_field1, int in1_dim1, int in1_dim2, int in1_dim3,
-	   const T * const in_field2, int in2_dim1, int in2_dim2, int in2_dim3,
-	   double d1, double d2, double dt, double n, 
-	   const Index3& idx, 
-	   const ConstMagneticParam<T>& const_param) const
+    template <class Inplace, class In1, class In2>
+    void
+    update(const Inplace& inplace_field, const In1& in_field1,
+	   const In2& in_field2, double d1, double d2, double dt, double n,
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      inplace_field(i,j,k) = const_param.value;
+      inplace_field(i,j,k) = value_list[p];
     }
 
   protected:
     using MaterialMagnetic<T>::position;
     using MaterialMagnetic<T>::idx_list;
-    std::vector<ConstMagneticParam<T> > param_list;
+    using MaterialMagnetic<T>::mu_inf_list;
+    std::vector<T, AlignedAllocator<T> > value_list;
 
   private:
     static const std::string tag; // "ConstMagnetic"
@@ -229,6 +251,4 @@ namespace gmes
   }; // template ConstHz
 } // namespace gmes
 
-#undef inplace_field
-
 #endif // PW_CONST_HH_
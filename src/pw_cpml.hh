@@ -12,13 +12,6 @@
 #include <utility>
 #include "pw_material.hh"
 
-#define ex(i,j,k) ex[ex_y_size==1?0:((i)*ex_y_size+(j))*ex_z_size+(k)]
-#define ey(i,j,k) ey[ey_z_size==1?0:((i)*ey_y_size+(j))*ey_z_size+(k)]
-#define ez(i,j,k) ez[ez_x_size==1?0:((i)*ez_y_size+(j))*ez_z_size+(k)]
-#define hx(i,j,k) hx[hx_y_size==1?0:((i)*hx_y_size+(j))*hx_z_size+(k)]
-#define hy(i,j,k) hy[hy_z_size==1?0:((i)*hy_y_size+(j))*hy_z_size+(k)]
-#define hz(i,j,k) hz[hz_x_size==1?0:((i)*hz_y_size+(j))*hz_z_size+(k)]
-
 namespace gmes
 {
   template <typename T> 
@@ -45,18 +38,6 @@ namespace gmes
       return CpmlElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size, 
 	   const PwMaterialParam* const pm_param_ptr)
@@ -67,24 +48,113 @@ namespace gmes
       const auto& cpml_param = *static_cast<const CpmlElectricParam<T>*>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(cpml_param);
+      eps_inf_list.push_back(cpml_param.eps_inf);
+      b1_list.push_back(cpml_param.b1);
+      b2_list.push_back(cpml_param.b2);
+      c1_list.push_back(cpml_param.c1);
+      c2_list.push_back(cpml_param.c2);
+      kappa1_list.push_back(cpml_param.kappa1);
+      kappa2_list.push_back(cpml_param.kappa2);
+      psi1_list.push_back(cpml_param.psi1);
+      psi2_list.push_back(cpml_param.psi2);
+
+      return this;
+    }
+
+    using MaterialElectric<T>::attach_many;
+
+    // Attach every row of indices with its own row of coeffs,
+    // (b1, b2, c1, c2, kappa1, kappa2). The remaining fields come from
+    // the shared parameter.
+    PwMaterial<T>*
+    attach_many(const int* const indices, int indices_size1, int indices_size2,
+		const PwMaterialParam* const pm_param_ptr,
+		const double* const coeffs, int coeffs_size1, int coeffs_size2)
+    {
+      auto cpml_param = *static_cast<const CpmlElectricParam<T>*>(pm_param_ptr);
+
+      const int num = std::min(indices_size1, coeffs_size1);
+      reserve(num);
+      for (int n = 0; n < num; ++n) {
+	const double* const row = coeffs + n * coeffs_size2;
+	cpml_param.b1 = row[0];
+	cpml_param.b2 = row[1];
+	cpml_param.c1 = row[2];
+	cpml_param.c2 = row[3];
+	cpml_param.kappa1 = row[4];
+	cpml_param.kappa2 = row[5];
+	attach(indices + n * indices_size2, indices_size2, &cpml_param);
+      }
 
       return this;
     }
 
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(b1_list, cell_num);
+      reserve_more(b2_list, cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(kappa1_list, cell_num);
+      reserve_more(kappa2_list, cell_num);
+      reserve_more(psi1_list, cell_num);
+      reserve_more(psi2_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto cpml_ptr = static_cast<const CpmlElectric<T>*>(pm_ptr);
       std::copy(cpml_ptr->idx_list.begin(), cpml_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(cpml_ptr->param_list.begin(), cpml_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(cpml_ptr->eps_inf_list.begin(), cpml_ptr->eps_inf_list.end(), std::back_inserter(eps_inf_list));
+      std::copy(cpml_ptr->b1_list.begin(), cpml_ptr->b1_list.end(), std::back_inserter(b1_list));
+      std::copy(cpml_ptr->b2_list.begin(), cpml_ptr->b2_list.end(), std::back_inserter(b2_list));
+      std::copy(cpml_ptr->c1_list.begin(), cpml_ptr->c1_list.end(), std::back_inserter(c1_list));
+      std::copy(cpml_ptr->c2_list.begin(), cpml_ptr->c2_list.end(), std::back_inserter(c2_list));
+      std::copy(cpml_ptr->kappa1_list.begin(), cpml_ptr->kappa1_list.end(), std::back_inserter(kappa1_list));
+      std::copy(cpml_ptr->kappa2_list.begin(), cpml_ptr->kappa2_list.end(), std::back_inserter(kappa2_list));
+      std::copy(cpml_ptr->psi1_list.begin(), cpml_ptr->psi1_list.end(), std::back_inserter(psi1_list));
+      std::copy(cpml_ptr->psi2_list.begin(), cpml_ptr->psi2_list.end(), std::back_inserter(psi2_list));
       return this;
     }
 
+    int
+    state_arrays() const
+    {
+      return 2;
+    }
+
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<CpmlElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    Reciprocal inv_eps_inf_list;
+    CoeffCnt b1_list, b2_list, c1_list, c2_list, kappa1_list, kappa2_list;
+    Reciprocal inv_kappa1_list, inv_kappa2_list;
+    std::vector<T, AlignedAllocator<T> > psi1_list, psi2_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(psi1_list, p, out);
+      save_cell(psi2_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(psi1_list);
+      sizes[1] = cell_state_size(psi2_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(psi1_list, p, in, sizes[0]);
+      load_cell(psi2_list, p, in, sizes[1]);
+    }
 
   private:
     static const std::string tag; // "CpmlElectric"
@@ -103,35 +173,92 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ex, const Field<const T>& hz,
+		 const Field<const T>& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      inv_kappa1_list.sync(kappa1_list);
+      inv_kappa2_list.sync(kappa2_list);
+      update_runs(*this, idx_list, ex, hz, hy, dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ex, const Field<const T>& hz,
+	       const Field<const T>& hy,
+	       double dy, double dz, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      T* const ex_00 = &ex(i,j,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_p0 = &hz(i+1,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+	const double by = b1_list[p];
+	const double bz = b2_list[p];
+	const double cy = c1_list[p];
+	const double cz = c2_list[p];
+	const double inv_kappay = inv_kappa1_list[p];
+	const double inv_kappaz = inv_kappa2_list[p];
+	T& psi1 = psi1_list[p];
+	T& psi2 = psi2_list[p];
+
+	psi1 = by * psi1 + cy * (hz_pp[l] - hz_p0[l]) * inv_dy;
+	psi2 = bz * psi2 + cz * (hy_p0[l + 1] - hy_p0[l]) * inv_dz;
+
+	ex_00[l] += dt * inv_eps_inf * ((hz_pp[l] - hz_p0[l]) * inv_dy * inv_kappay -
+					(hy_p0[l + 1] - hy_p0[l]) * inv_dz * inv_kappaz +
+					psi1 - psi2);
       }
     }
 
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx,
-	   CpmlElectricParam<T>& cpml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
 
-      const double eps_inf = cpml_param.eps_inf;
-      const double by = cpml_param.b1;
-      const double bz = cpml_param.b2;
-      const double cy = cpml_param.c1;
-      const double cz = cpml_param.c2;
-      const double kappay = cpml_param.kappa1;
-      const double kappaz = cpml_param.kappa2;
-      T& psi1 = cpml_param.psi1;
-      T& psi2 = cpml_param.psi2;
+      const double eps_inf = eps_inf_list[p];
+      const double by = b1_list[p];
+      const double bz = b2_list[p];
+      const double cy = c1_list[p];
+      const double cz = c2_list[p];
+      const double kappay = kappa1_list[p];
+      const double kappaz = kappa2_list[p];
+      T& psi1 = psi1_list[p];
+      T& psi2 = psi2_list[p];
 
       psi1 = by * psi1 + cy * (hz(i+1,j+1,k) - hz(i+1,j,k)) / dy;
       psi2 = bz * psi2 + cz * (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz;
@@ -143,7 +270,18 @@ namespace gmes
 
   protected:
     using CpmlElectric<T>::idx_list;
-    using CpmlElectric<T>::param_list;
+    using CpmlElectric<T>::eps_inf_list;
+    using CpmlElectric<T>::inv_eps_inf_list;
+    using CpmlElectric<T>::b1_list;
+    using CpmlElectric<T>::b2_list;
+    using CpmlElectric<T>::c1_list;
+    using CpmlElectric<T>::c2_list;
+    using CpmlElectric<T>::kappa1_list;
+    using CpmlElectric<T>::kappa2_list;
+    using CpmlElectric<T>::inv_kappa1_list;
+    using CpmlElectric<T>::inv_kappa2_list;
+    using CpmlElectric<T>::psi1_list;
+    using CpmlElectric<T>::psi2_list;
   }; // template CpmlEx
 
   template <typename T> 
@@ -156,35 +294,92 @@ namespace gmes
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ey, const Field<const T>& hx,
+		 const Field<const T>& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      inv_kappa1_list.sync(kappa1_list);
+      inv_kappa2_list.sync(kappa2_list);
+      update_runs(*this, idx_list, ey, hx, hz, dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ey, const Field<const T>& hx,
+	       const Field<const T>& hz,
+	       double dz, double dx, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      T* const ey_00 = &ey(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_0p = &hz(i,j+1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+	const double bz = b1_list[p];
+	const double bx = b2_list[p];
+	const double cz = c1_list[p];
+	const double cx = c2_list[p];
+	const double inv_kappaz = inv_kappa1_list[p];
+	const double inv_kappax = inv_kappa2_list[p];
+	T& psi1 = psi1_list[p];
+	T& psi2 = psi2_list[p];
+
+	psi1 = bz * psi1 + cz * (hx_0p[l + 1] - hx_0p[l]) * inv_dz;
+	psi2 = bx * psi2 + cx * (hz_pp[l] - hz_0p[l]) * inv_dx;
+
+	ey_00[l] += dt * inv_eps_inf * ((hx_0p[l + 1] - hx_0p[l]) * inv_dz * inv_kappaz -
+					(hz_pp[l] - hz_0p[l]) * inv_dx * inv_kappax +
+					psi1 - psi2);
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx,
-	   CpmlElectricParam<T>& cpml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
 
-      const double eps_inf = cpml_param.eps_inf;
-      const double bz = cpml_param.b1;
-      const double bx = cpml_param.b2;
-      const double cz = cpml_param.c1;
-      const double cx = cpml_param.c2;
-      const double kappaz = cpml_param.kappa1;
-      const double kappax = cpml_param.kappa2;
-      T& psi1 = cpml_param.psi1;
-      T& psi2 = cpml_param.psi2;
+      const double eps_inf = eps_inf_list[p];
+      const double bz = b1_list[p];
+      const double bx = b2_list[p];
+      const double cz = c1_list[p];
+      const double cx = c2_list[p];
+      const double kappaz = kappa1_list[p];
+      const double kappax = kappa2_list[p];
+      T& psi1 = psi1_list[p];
+      T& psi2 = psi2_list[p];
 
       psi1 = bz * psi1 + cz * (hx(i,j+1,k+1) - hx(i,j+1,k)) / dz;
       psi2 = bx * psi2 + cx * (hz(i+1,j+1,k) - hz(i,j+1,k)) / dx;
@@ -196,7 +391,18 @@ namespace gmes
 
   protected:
     using CpmlElectric<T>::idx_list;
-    using CpmlElectric<T>::param_list;
+    using CpmlElectric<T>::eps_inf_list;
+    using CpmlElectric<T>::inv_eps_inf_list;
+    using CpmlElectric<T>::b1_list;
+    using CpmlElectric<T>::b2_list;
+    using CpmlElectric<T>::c1_list;
+    using CpmlElectric<T>::c2_list;
+    using CpmlElectric<T>::kappa1_list;
+    using CpmlElectric<T>::kappa2_list;
+    using CpmlElectric<T>::inv_kappa1_list;
+    using CpmlElectric<T>::inv_kappa2_list;
+    using CpmlElectric<T>::psi1_list;
+    using CpmlElectric<T>::psi2_list;
   }; // template CpmlEy
 
   template <typename T> 
@@ -209,35 +415,93 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ez, const Field<const T>& hy,
+		 const Field<const T>& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      inv_kappa1_list.sync(kappa1_list);
+      inv_kappa2_list.sync(kappa2_list);
+      update_runs(*this, idx_list, ez, hy, hx, dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ez, const Field<const T>& hy,
+	       const Field<const T>& hx,
+	       double dx, double dy, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      T* const ez_00 = &ez(i,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+      const T* const hy_00 = &hy(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hx_00 = &hx(i,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+	const double bx = b1_list[p];
+	const double by = b2_list[p];
+	const double cx = c1_list[p];
+	const double cy = c2_list[p];
+	const double inv_kappax = inv_kappa1_list[p];
+	const double inv_kappay = inv_kappa2_list[p];
+	T& psi1 = psi1_list[p];
+	T& psi2 = psi2_list[p];
+
+	psi1 = bx * psi1 + cx * (hy_p0[l + 1] - hy_00[l + 1]) * inv_dx;
+	psi2 = by * psi2 + cy * (hx_0p[l + 1] - hx_00[l + 1]) * inv_dy;
+
+	ez_00[l] += dt * inv_eps_inf * ((hy_p0[l + 1] - hy_00[l + 1]) * inv_dx * inv_kappax -
+					(hx_0p[l + 1] - hx_00[l + 1]) * inv_dy * inv_kappay +
+					psi1 - psi2);
       }
     }
     
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx,
-	   CpmlElectricParam<T>& cpml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
 
-      const double eps_inf = cpml_param.eps_inf;
-      const double bx = cpml_param.b1;
-      const double by = cpml_param.b2;
-      const double cx = cpml_param.c1;
-      const double cy = cpml_param.c2;
-      const double kappax = cpml_param.kappa1;
-      const double kappay = cpml_param.kappa2;
-      T& psi1 = cpml_param.psi1;
-      T& psi2 = cpml_param.psi2;
+      const double eps_inf = eps_inf_list[p];
+      const double bx = b1_list[p];
+      const double by = b2_list[p];
+      const double cx = c1_list[p];
+      const double cy = c2_list[p];
+      const double kappax = kappa1_list[p];
+      const double kappay = kappa2_list[p];
+      T& psi1 = psi1_list[p];
+      T& psi2 = psi2_list[p];
 
       psi1 = bx * psi1 + cx * (hy(i+1,j,k+1) - hy(i,j,k+1)) / dx;
       psi2 = by * psi2 + cy * (hx(i,j+1,k+1) - hx(i,j,k+1)) / dy;
@@ -249,7 +513,18 @@ namespace gmes
 
   protected:
     using CpmlElectric<T>::idx_list;
-    using CpmlElectric<T>::param_list;
+    using CpmlElectric<T>::eps_inf_list;
+    using CpmlElectric<T>::inv_eps_inf_list;
+    using CpmlElectric<T>::b1_list;
+    using CpmlElectric<T>::b2_list;
+    using CpmlElectric<T>::c1_list;
+    using CpmlElectric<T>::c2_list;
+    using CpmlElectric<T>::kappa1_list;
+    using CpmlElectric<T>::kappa2_list;
+    using CpmlElectric<T>::inv_kappa1_list;
+    using CpmlElectric<T>::inv_kappa2_list;
+    using CpmlElectric<T>::psi1_list;
+    using CpmlElectric<T>::psi2_list;
   }; // template CpmlEz
 
   template <typename T>
@@ -262,18 +537,6 @@ namespace gmes
       return CpmlMagnetic<T>::tag;
     }
 
-    double
-    get_mu_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].mu_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size, 
 	   const PwMaterialParam* const pm_param_ptr)
@@ -284,24 +547,113 @@ namespace gmes
       const auto& cpml_param = *static_cast<const CpmlMagneticParam<T>*>(pm_param_ptr);
       
       idx_list.push_back(index);
-      param_list.push_back(cpml_param);
+      mu_inf_list.push_back(cpml_param.mu_inf);
+      b1_list.push_back(cpml_param.b1);
+      b2_list.push_back(cpml_param.b2);
+      c1_list.push_back(cpml_param.c1);
+      c2_list.push_back(cpml_param.c2);
+      kappa1_list.push_back(cpml_param.kappa1);
+      kappa2_list.push_back(cpml_param.kappa2);
+      psi1_list.push_back(cpml_param.psi1);
+      psi2_list.push_back(cpml_param.psi2);
+
+      return this;
+    }
+
+    using MaterialMagnetic<T>::attach_many;
+
+    // Attach every row of indices with its own row of coeffs,
+    // (b1, b2, c1, c2, kappa1, kappa2). The remaining fields come from
+    // the shared parameter.
+    PwMaterial<T>*
+    attach_many(const int* const indices, int indices_size1, int indices_size2,
+		const PwMaterialParam* const pm_param_ptr,
+		const double* const coeffs, int coeffs_size1, int coeffs_size2)
+    {
+      auto cpml_param = *static_cast<const CpmlMagneticParam<T>*>(pm_param_ptr);
+
+      const int num = std::min(indices_size1, coeffs_size1);
+      reserve(num);
+      for (int n = 0; n < num; ++n) {
+	const double* const row = coeffs + n * coeffs_size2;
+	cpml_param.b1 = row[0];
+	cpml_param.b2 = row[1];
+	cpml_param.c1 = row[2];
+	cpml_param.c2 = row[3];
+	cpml_param.kappa1 = row[4];
+	cpml_param.kappa2 = row[5];
+	attach(indices + n * indices_size2, indices_size2, &cpml_param);
+      }
 
       return this;
     }
 
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialMagnetic<T>::reserve(cell_num);
+      reserve_more(b1_list, cell_num);
+      reserve_more(b2_list, cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(kappa1_list, cell_num);
+      reserve_more(kappa2_list, cell_num);
+      reserve_more(psi1_list, cell_num);
+      reserve_more(psi2_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto cpml_ptr = static_cast<const CpmlMagnetic<T>*>(pm_ptr);
       std::copy(cpml_ptr->idx_list.begin(), cpml_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(cpml_ptr->param_list.begin(), cpml_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(cpml_ptr->mu_inf_list.begin(), cpml_ptr->mu_inf_list.end(), std::back_inserter(mu_inf_list));
+      std::copy(cpml_ptr->b1_list.begin(), cpml_ptr->b1_list.end(), std::back_inserter(b1_list));
+      std::copy(cpml_ptr->b2_list.begin(), cpml_ptr->b2_list.end(), std::back_inserter(b2_list));
+      std::copy(cpml_ptr->c1_list.begin(), cpml_ptr->c1_list.end(), std::back_inserter(c1_list));
+      std::copy(cpml_ptr->c2_list.begin(), cpml_ptr->c2_list.end(), std::back_inserter(c2_list));
+      std::copy(cpml_ptr->kappa1_list.begin(), cpml_ptr->kappa1_list.end(), std::back_inserter(kappa1_list));
+      std::copy(cpml_ptr->kappa2_list.begin(), cpml_ptr->kappa2_list.end(), std::back_inserter(kappa2_list));
+      std::copy(cpml_ptr->psi1_list.begin(), cpml_ptr->psi1_list.end(), std::back_inserter(psi1_list));
+      std::copy(cpml_ptr->psi2_list.begin(), cpml_ptr->psi2_list.end(), std::back_inserter(psi2_list));
       return this;
     }
 
+    int
+    state_arrays() const
+    {
+      return 2;
+    }
+
   protected:
     using MaterialMagnetic<T>::position;
     using PwMaterial<T>::idx_list;
-    std::vector<CpmlMagneticParam<T> > param_list;
+    using MaterialMagnetic<T>::mu_inf_list;
+    Reciprocal inv_mu_inf_list;
+    CoeffCnt b1_list, b2_list, c1_list, c2_list, kappa1_list, kappa2_list;
+    Reciprocal inv_kappa1_list, inv_kappa2_list;
+    std::vector<T, AlignedAllocator<T> > psi1_list, psi2_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(psi1_list, p, out);
+      save_cell(psi2_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(psi1_list);
+      sizes[1] = cell_state_size(psi2_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(psi1_list, p, in, sizes[0]);
+      load_cell(psi2_list, p, in, sizes[1]);
+    }
 
   private:
     static const std::string tag; // "CpmlMagnetic"
@@ -320,35 +672,92 @@ namespace gmes
 	       const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(hx, hx_x_size, hx_y_size, hx_z_size,
-	       ez, ez_x_size, ez_y_size, ez_z_size,
-	       ey, ey_x_size, ey_y_size, ey_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Hx, class Ez, class Ey>
+    void
+    update_cells(const Hx& hx, const Ez& ez, const Ey& ey,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hx, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hx, ez, ey, dy, dz, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hx, const Field<const T>& ez,
+		 const Field<const T>& ey,
+		 double dy, double dz, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      inv_kappa1_list.sync(kappa1_list);
+      inv_kappa2_list.sync(kappa2_list);
+      update_runs(*this, idx_list, hx, ez, ey, dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hx, const Field<const T>& ez,
+	       const Field<const T>& ey,
+	       double dy, double dz, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      T* const hx_00 = &hx(i,j,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_0m = &ez(i,j-1,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+	const double by = b1_list[p];
+	const double bz = b2_list[p];
+	const double cy = c1_list[p];
+	const double cz = c2_list[p];
+	const double inv_kappay = inv_kappa1_list[p];
+	const double inv_kappaz = inv_kappa2_list[p];
+	T& psi1 = psi1_list[p];
+	T& psi2 = psi2_list[p];
+
+	psi1 = by * psi1 + cy * (ez_00[l - 1] - ez_0m[l - 1]) * inv_dy;
+	psi2 = bz * psi2 + cz * (ey_0m[l] - ey_0m[l - 1]) * inv_dz;
+
+	hx_00[l] -= dt * inv_mu_inf * ((ez_00[l - 1] - ez_0m[l - 1]) * inv_dy * inv_kappay -
+				       (ey_0m[l] - ey_0m[l - 1]) * inv_dz * inv_kappaz +
+				       psi1 - psi2);
       }
     }
 
   private:
-    void 
-    update(T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
+    template <class Hx, class Ez, class Ey>
+    void
+    update(const Hx& hx, const Ez& ez, const Ey& ey,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx,
-	   CpmlMagneticParam<T>& cpml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
 
-      const double mu_inf = cpml_param.mu_inf;
-      const double by = cpml_param.b1;
-      const double bz = cpml_param.b2;
-      const double cy = cpml_param.c1;
-      const double cz = cpml_param.c2;
-      const double kappay = cpml_param.kappa1;
-      const double kappaz = cpml_param.kappa2;
-      T& psi1 = cpml_param.psi1;
-      T& psi2 = cpml_param.psi2;
+      const double mu_inf = mu_inf_list[p];
+      const double by = b1_list[p];
+      const double bz = b2_list[p];
+      const double cy = c1_list[p];
+      const double cz = c2_list[p];
+      const double kappay = kappa1_list[p];
+      const double kappaz = kappa2_list[p];
+      T& psi1 = psi1_list[p];
+      T& psi2 = psi2_list[p];
 
       psi1 = by * psi1 + cy * (ez(i,j,k-1) - ez(i,j-1,k-1)) / dy;
       psi2 = bz * psi2 + cz * (ey(i,j-1,k) - ey(i,j-1,k-1)) / dz;
@@ -360,7 +769,18 @@ namespace gmes
 
   protected:
     using CpmlMagnetic<T>::idx_list;
-    using CpmlMagnetic<T>::param_list;
+    using CpmlMagnetic<T>::mu_inf_list;
+    using CpmlMagnetic<T>::inv_mu_inf_list;
+    using CpmlMagnetic<T>::b1_list;
+    using CpmlMagnetic<T>::b2_list;
+    using CpmlMagnetic<T>::c1_list;
+    using CpmlMagnetic<T>::c2_list;
+    using CpmlMagnetic<T>::kappa1_list;
+    using CpmlMagnetic<T>::kappa2_list;
+    using CpmlMagnetic<T>::inv_kappa1_list;
+    using CpmlMagnetic<T>::inv_kappa2_list;
+    using CpmlMagnetic<T>::psi1_list;
+    using CpmlMagnetic<T>::psi2_list;
   }; // template CpmlHx
 
   template <typename T> 
@@ -373,35 +793,92 @@ namespace gmes
 	       const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(hy, hy_x_size, hy_y_size, hy_z_size,
-	       ex, ex_x_size, ex_y_size, ex_z_size,
-	       ez, ez_x_size, ez_y_size, ez_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Hy, class Ex, class Ez>
+    void
+    update_cells(const Hy& hy, const Ex& ex, const Ez& ez,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hy, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hy, ex, ez, dz, dx, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hy, const Field<const T>& ex,
+		 const Field<const T>& ez,
+		 double dz, double dx, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      inv_kappa1_list.sync(kappa1_list);
+      inv_kappa2_list.sync(kappa2_list);
+      update_runs(*this, idx_list, hy, ex, ez, dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hy, const Field<const T>& ex,
+	       const Field<const T>& ez,
+	       double dz, double dx, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      T* const hy_00 = &hy(i,j,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_m0 = &ez(i-1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+	const double bz = b1_list[p];
+	const double bx = b2_list[p];
+	const double cz = c1_list[p];
+	const double cx = c2_list[p];
+	const double inv_kappaz = inv_kappa1_list[p];
+	const double inv_kappax = inv_kappa2_list[p];
+	T& psi1 = psi1_list[p];
+	T& psi2 = psi2_list[p];
+
+	psi1 = bz * psi1 + cz * (ex_m0[l] - ex_m0[l - 1]) * inv_dz;
+	psi2 = bx * psi2 + cx * (ez_00[l - 1] - ez_m0[l - 1]) * inv_dx;
+
+	hy_00[l] -= dt * inv_mu_inf * ((ex_m0[l] - ex_m0[l - 1]) * inv_dz * inv_kappaz -
+				       (ez_00[l - 1] - ez_m0[l - 1]) * inv_dx * inv_kappax +
+				       psi1 - psi2);
       }
     }
 
   private:
-    void 
-    update(T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
+    template <class Hy, class Ex, class Ez>
+    void
+    update(const Hy& hy, const Ex& ex, const Ez& ez,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx,
-	   CpmlMagneticParam<T>& cpml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
 
-      const double mu_inf = cpml_param.mu_inf;
-      const double bz = cpml_param.b1;
-      const double bx = cpml_param.b2;
-      const double cz = cpml_param.c1;
-      const double cx = cpml_param.c2;
-      const double kappaz = cpml_param.kappa1;
-      const double kappax = cpml_param.kappa2;
-      T& psi1 = cpml_param.psi1;
-      T& psi2 = cpml_param.psi2;
+      const double mu_inf = mu_inf_list[p];
+      const double bz = b1_list[p];
+      const double bx = b2_list[p];
+      const double cz = c1_list[p];
+      const double cx = c2_list[p];
+      const double kappaz = kappa1_list[p];
+      const double kappax = kappa2_list[p];
+      T& psi1 = psi1_list[p];
+      T& psi2 = psi2_list[p];
 
       psi1 = bz * psi1 + cz * (ex(i-1,j,k) - ex(i-1,j,k-1)) / dz;
       psi2 = bx * psi2 + cx * (ez(i,j,k-1) - ez(i-1,j,k-1)) / dx;
@@ -413,7 +890,18 @@ namespace gmes
 
   protected:
     using CpmlMagnetic<T>::idx_list;
-    using CpmlMagnetic<T>::param_list;
+    using CpmlMagnetic<T>::mu_inf_list;
+    using CpmlMagnetic<T>::inv_mu_inf_list;
+    using CpmlMagnetic<T>::b1_list;
+    using CpmlMagnetic<T>::b2_list;
+    using CpmlMagnetic<T>::c1_list;
+    using CpmlMagnetic<T>::c2_list;
+    using CpmlMagnetic<T>::kappa1_list;
+    using CpmlMagnetic<T>::kappa2_list;
+    using CpmlMagnetic<T>::inv_kappa1_list;
+    using CpmlMagnetic<T>::inv_kappa2_list;
+    using CpmlMagnetic<T>::psi1_list;
+    using CpmlMagnetic<T>::psi2_list;
   }; // template CpmlHy
 
   template <typename T> class CpmlHz: public CpmlMagnetic<T>
@@ -425,35 +913,93 @@ namespace gmes
 	       const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(hz, hz_x_size, hz_y_size, hz_z_size,
-	       ey, ey_x_size, ey_y_size, ey_z_size,
-	       ex, ex_x_size, ex_y_size, ex_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Hz, class Ey, class Ex>
+    void
+    update_cells(const Hz& hz, const Ey& ey, const Ex& ex,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hz, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hz, ey, ex, dx, dy, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hz, const Field<const T>& ey,
+		 const Field<const T>& ex,
+		 double dx, double dy, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      inv_kappa1_list.sync(kappa1_list);
+      inv_kappa2_list.sync(kappa2_list);
+      update_runs(*this, idx_list, hz, ey, ex, dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hz, const Field<const T>& ey,
+	       const Field<const T>& ex,
+	       double dx, double dy, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      T* const hz_00 = &hz(i,j,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+      const T* const ey_mm = &ey(i-1,j-1,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+      const T* const ex_mm = &ex(i-1,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+	const double bx = b1_list[p];
+	const double by = b2_list[p];
+	const double cx = c1_list[p];
+	const double cy = c2_list[p];
+	const double inv_kappax = inv_kappa1_list[p];
+	const double inv_kappay = inv_kappa2_list[p];
+	T& psi1 = psi1_list[p];
+	T& psi2 = psi2_list[p];
+
+	psi1 = bx * psi1 + cx * (ey_0m[l] - ey_mm[l]) * inv_dx;
+	psi2 = by * psi2 + cy * (ex_m0[l] - ex_mm[l]) * inv_dy;
+
+	hz_00[l] -= dt * inv_mu_inf * ((ey_0m[l] - ey_mm[l]) * inv_dx * inv_kappax -
+				       (ex_m0[l] - ex_mm[l]) * inv_dy * inv_kappay +
+				       psi1 - psi2);
       }
     }
 
   private:
-    void 
-    update(T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
+    template <class Hz, class Ey, class Ex>
+    void
+    update(const Hz& hz, const Ey& ey, const Ex& ex,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx,
-	   CpmlMagneticParam<T>& cpml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
 
-      const double mu_inf = cpml_param.mu_inf;
-      const double bx = cpml_param.b1;
-      const double by = cpml_param.b2;
-      const double cx = cpml_param.c1;
-      const double cy = cpml_param.c2;
-      const double kappax = cpml_param.kappa1;
-      const double kappay = cpml_param.kappa2;
-      T& psi1 = cpml_param.psi1;
-      T& psi2 = cpml_param.psi2;
+      const double mu_inf = mu_inf_list[p];
+      const double bx = b1_list[p];
+      const double by = b2_list[p];
+      const double cx = c1_list[p];
+      const double cy = c2_list[p];
+      const double kappax = kappa1_list[p];
+      const double kappay = kappa2_list[p];
+      T& psi1 = psi1_list[p];
+      T& psi2 = psi2_list[p];
 
       psi1 = bx * psi1 + cx * (ey(i,j-1,k) - ey(i-1,j-1,k)) / dx;
       psi2 = by * psi2 + cy * (ex(i-1,j,k) - ex(i-1,j-1,k)) / dy;
@@ -465,15 +1011,19 @@ namespace gmes
 
   protected:
     using CpmlMagnetic<T>::idx_list;
-    using CpmlMagnetic<T>::param_list;
+    using CpmlMagnetic<T>::mu_inf_list;
+    using CpmlMagnetic<T>::inv_mu_inf_list;
+    using CpmlMagnetic<T>::b1_list;
+    using CpmlMagnetic<T>::b2_list;
+    using CpmlMagnetic<T>::c1_list;
+    using CpmlMagnetic<T>::c2_list;
+    using CpmlMagnetic<T>::kappa1_list;
+    using CpmlMagnetic<T>::kappa2_list;
+    using CpmlMagnetic<T>::inv_kappa1_list;
+    using CpmlMagnetic<T>::inv_kappa2_list;
+    using CpmlMagnetic<T>::psi1_list;
+    using CpmlMagnetic<T>::psi2_list;
   }; // template CpmlHz
 } // namespace gmes
 
-#undef ex
-#undef ey
-#undef ez
-#undef hx
-#undef hy
-#undef hz
-
 #endif // PW_CPML_HH_
@@ -21,13 +21,6 @@
 #include <vector>
 #include "pw_dielectric.hh"
 
-#define ex(i,j,k) ex[ex_y_size==1?0:((i)*ex_y_size+(j))*ex_z_size+(k)]
-#define ey(i,j,k) ey[ey_z_size==1?0:((i)*ey_y_size+(j))*ey_z_size+(k)]
-#define ez(i,j,k) ez[ez_x_size==1?0:((i)*ez_y_size+(j))*ez_z_size+(k)]
-#define hx(i,j,k) hx[hx_y_size==1?0:((i)*hx_y_size+(j))*hx_z_size+(k)]
-#define hy(i,j,k) hy[hy_z_size==1?0:((i)*hy_y_size+(j))*hy_z_size+(k)]
-#define hz(i,j,k) hz[hz_x_size==1?0:((i)*hz_y_size+(j))*hz_z_size+(k)]
-
 // The classes should be rewritten using template specialization
 // to increase the calculation speed.
 namespace gmes
@@ -74,18 +67,6 @@ namespace gmes
       return DcpAdeElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const pm_param_ptr)
@@ -96,45 +77,104 @@ namespace gmes
       const auto& dcp_param = *static_cast<const DcpAdeElectricParam<T> * const>(pm_param_ptr);
       
       idx_list.push_back(index);
-      param_list.push_back(dcp_param);
+      eps_inf_list.push_back(dcp_param.eps_inf);
+      a0_list.push_back(column(dcp_param.a, 0));
+      a1_list.push_back(column(dcp_param.a, 1));
+      a2_list.push_back(column(dcp_param.a, 2));
+      b0_list.push_back(column(dcp_param.b, 0));
+      b1_list.push_back(column(dcp_param.b, 1));
+      b2_list.push_back(column(dcp_param.b, 2));
+      b3_list.push_back(column(dcp_param.b, 3));
+      b4_list.push_back(column(dcp_param.b, 4));
+      c0_list.push_back(dcp_param.c[0]);
+      c1_list.push_back(dcp_param.c[1]);
+      c2_list.push_back(dcp_param.c[2]);
+      c3_list.push_back(dcp_param.c[3]);
+      e_old_list.push_back(dcp_param.e_old);
+      q_old_list.push_back(dcp_param.q_old);
+      q_now_list.push_back(dcp_param.q_now);
+      p_old_list.push_back(dcp_param.p_old);
+      p_now_list.push_back(dcp_param.p_now);
 
       return this;
     }
     
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(a0_list, cell_num);
+      reserve_more(a1_list, cell_num);
+      reserve_more(a2_list, cell_num);
+      reserve_more(b0_list, cell_num);
+      reserve_more(b1_list, cell_num);
+      reserve_more(b2_list, cell_num);
+      reserve_more(b3_list, cell_num);
+      reserve_more(b4_list, cell_num);
+      reserve_more(c0_list, cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(c3_list, cell_num);
+      reserve_more(e_old_list, cell_num);
+      reserve_more(q_old_list, cell_num);
+      reserve_more(q_now_list, cell_num);
+      reserve_more(p_old_list, cell_num);
+      reserve_more(p_now_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto dcp_ptr = static_cast<const DcpAdeElectric<T>*>(pm_ptr);
       std::copy(dcp_ptr->idx_list.begin(), dcp_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(dcp_ptr->param_list.begin(), dcp_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(dcp_ptr->eps_inf_list.begin(), dcp_ptr->eps_inf_list.end(), std::back_inserter(eps_inf_list));
+      a0_list.append(dcp_ptr->a0_list);
+      a1_list.append(dcp_ptr->a1_list);
+      a2_list.append(dcp_ptr->a2_list);
+      b0_list.append(dcp_ptr->b0_list);
+      b1_list.append(dcp_ptr->b1_list);
+      b2_list.append(dcp_ptr->b2_list);
+      b3_list.append(dcp_ptr->b3_list);
+      b4_list.append(dcp_ptr->b4_list);
+      std::copy(dcp_ptr->c0_list.begin(), dcp_ptr->c0_list.end(), std::back_inserter(c0_list));
+      std::copy(dcp_ptr->c1_list.begin(), dcp_ptr->c1_list.end(), std::back_inserter(c1_list));
+      std::copy(dcp_ptr->c2_list.begin(), dcp_ptr->c2_list.end(), std::back_inserter(c2_list));
+      std::copy(dcp_ptr->c3_list.begin(), dcp_ptr->c3_list.end(), std::back_inserter(c3_list));
+      std::copy(dcp_ptr->e_old_list.begin(), dcp_ptr->e_old_list.end(), std::back_inserter(e_old_list));
+      q_old_list.append(dcp_ptr->q_old_list);
+      q_now_list.append(dcp_ptr->q_now_list);
+      p_old_list.append(dcp_ptr->p_old_list);
+      p_now_list.append(dcp_ptr->p_now_list);
       return this;
     }
 
     T 
-    dps_sum(const T& init, const DcpAdeElectricParam<T>& dcp_param) const
+    dps_sum(const T& init, std::size_t p) const
     {
-      const auto& a = dcp_param.a;
-      const auto& q_old = dcp_param.q_old;
-      const auto& q_now = dcp_param.q_now;
+      const double* const a0 = a0_list[p];
+      const double* const a1 = a1_list[p];
+      const T* const q_old = q_old_list[p];
+      const T* const q_now = q_now_list[p];
       
       T sum(init);
-      for (typename std::vector<T>::size_type i = 0; i < a.size(); ++i) {
-	sum += (1 - a[i][1]) * q_now[i] - a[i][0] * q_old[i];
+      for (std::size_t i = 0; i < q_now_list.width(); ++i) {
+	sum += (1 - a1[i]) * q_now[i] - a0[i] * q_old[i];
       }
 
       return sum;
     }
     
     T 
-    cps_sum(const T& init, const DcpAdeElectricParam<T>& dcp_param) const
+    cps_sum(const T& init, std::size_t p) const
     {
-      const auto& b = dcp_param.b;
-      const auto& p_old = dcp_param.p_old;
-      const auto& p_now = dcp_param.p_now;
+      const double* const b0 = b0_list[p];
+      const double* const b1 = b1_list[p];
+      const T* const p_old = p_old_list[p];
+      const T* const p_now = p_now_list[p];
 
       T sum(init);
-      for (typename std::vector<T>::size_type i = 0; i < b.size(); ++i) {
-	sum += (1 - b[i][1]) * p_now[i] - b[i][0] * p_old[i];
+      for (std::size_t i = 0; i < p_now_list.width(); ++i) {
+	sum += (1 - b1[i]) * p_now[i] - b0[i] * p_old[i];
       }
       
       return sum;
@@ -142,42 +182,86 @@ namespace gmes
 
     void 
     update_q(const T& e_old, const T& e_now, const T& e_new,
-	     DcpAdeElectricParam<T>& dcp_param)
-    {
-      const auto& a = dcp_param.a;
-      auto& q_old = dcp_param.q_old;
-      auto& q_now = dcp_param.q_now;
-
-      std::vector<T> q_new(a.size());
-      for (typename std::vector<T>::size_type i = 0; i < a.size(); ++i) {
-	q_new[i] = a[i][0] * q_old[i] + a[i][1] * q_now[i] + a[i][2] * (e_old + 2.0 * e_now + e_new);
+	     std::size_t p)
+    {
+      const double* const a0 = a0_list[p];
+      const double* const a1 = a1_list[p];
+      const double* const a2 = a2_list[p];
+      T* const q_old = q_old_list[p];
+      T* const q_now = q_now_list[p];
+
+      for (std::size_t i = 0; i < q_now_list.width(); ++i) {
+	const T q_new = a0[i] * q_old[i] + a1[i] * q_now[i] + a2[i] * (e_old + 2.0 * e_now + e_new);
+	q_old[i] = q_now[i];
+	q_now[i] = q_new;
       }
-      
-      std::copy(q_now.begin(), q_now.end(), q_old.begin());
-      std::copy(q_new.begin(), q_new.end(), q_now.begin());
     }
     
     void 
     update_p(const T& e_old, const T& e_now, const T& e_new,
-	     DcpAdeElectricParam<T>& dcp_param)
-    {
-      const auto& b = dcp_param.b;
-      auto& p_old = dcp_param.p_old;
-      auto& p_now = dcp_param.p_now;
+	     std::size_t p)
+    {
+      const double* const b0 = b0_list[p];
+      const double* const b1 = b1_list[p];
+      const double* const b2 = b2_list[p];
+      const double* const b3 = b3_list[p];
+      const double* const b4 = b4_list[p];
+      T* const p_old = p_old_list[p];
+      T* const p_now = p_now_list[p];
     
-      std::vector<T> p_new(b.size());
-      for (typename std::vector<T>::size_type i = 0; i < b.size(); ++i) {
-	p_new[i] = b[i][0] * p_old[i] + b[i][1] * p_now[i] + b[i][2] 
-	  * e_old + b[i][3] * e_now + b[i][4] * e_new;
+      for (std::size_t i = 0; i < p_now_list.width(); ++i) {
+	const T p_new = b0[i] * p_old[i] + b1[i] * p_now[i] + b2[i] 
+	  * e_old + b3[i] * e_now + b4[i] * e_new;
+	p_old[i] = p_now[i];
+	p_now[i] = p_new;
       }
-      std::copy(p_now.begin(), p_now.end(), p_old.begin());
-      std::copy(p_new.begin(), p_new.end(), p_now.begin());
     }
   
+    int
+    state_arrays() const
+    {
+      return 5;
+    }
+
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<DcpAdeElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    CellArray<double> a0_list, a1_list, a2_list;
+    CellArray<double> b0_list, b1_list, b2_list, b3_list, b4_list;
+    CoeffCnt c0_list, c1_list, c2_list, c3_list;
+    std::vector<T, AlignedAllocator<T> > e_old_list;
+    CellArray<T> q_old_list, q_now_list, p_old_list, p_now_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(e_old_list, p, out);
+      save_cell(q_old_list, p, out);
+      save_cell(q_now_list, p, out);
+      save_cell(p_old_list, p, out);
+      save_cell(p_now_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(e_old_list);
+      sizes[1] = cell_state_size(q_old_list);
+      sizes[2] = cell_state_size(q_now_list);
+      sizes[3] = cell_state_size(p_old_list);
+      sizes[4] = cell_state_size(p_now_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(e_old_list, p, in, sizes[0]);
+      load_cell(q_old_list, p, in, sizes[1]);
+      load_cell(q_now_list, p, in, sizes[2]);
+      load_cell(p_old_list, p, in, sizes[3]);
+      load_cell(p_now_list, p, in, sizes[4]);
+    }
 
   private:
     static const std::string tag; // "DcpAdeElectric"
@@ -196,38 +280,48 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx,
-	   DcpAdeElectricParam<T>& dcp_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const auto& c = dcp_param.c;
-      T& e_old = dcp_param.e_old;
+      T& e_old = e_old_list[p];
 
       const T& e_now = ex(i,j,k);
-      const T e_new = c[0] * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
-			      (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz) 
-	+ c[1] * (dps_sum(static_cast<T>(0), dcp_param) + 
-		  cps_sum(static_cast<T>(0), dcp_param))
-	+ c[2] * e_old + c[3] * e_now;
+      const T e_new = c0_list[p] * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
+				      (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz) 
+	+ c1_list[p] * (dps_sum(static_cast<T>(0), p) + 
+			 cps_sum(static_cast<T>(0), p))
+	+ c2_list[p] * e_old + c3_list[p] * e_now;
       
-      update_q(e_old, e_now, e_new, dcp_param);
-      update_p(e_old, e_now, e_new, dcp_param);
+      update_q(e_old, e_now, e_new, p);
+      update_p(e_old, e_now, e_new, p);
       
       e_old = e_now;
       ex(i,j,k) = e_new;
@@ -235,7 +329,11 @@ namespace gmes
     
   protected:
     using DcpAdeElectric<T>::idx_list;
-    using DcpAdeElectric<T>::param_list;
+    using DcpAdeElectric<T>::c0_list;
+    using DcpAdeElectric<T>::c1_list;
+    using DcpAdeElectric<T>::c2_list;
+    using DcpAdeElectric<T>::c3_list;
+    using DcpAdeElectric<T>::e_old_list;
     using DcpAdeElectric<T>::dps_sum;
     using DcpAdeElectric<T>::cps_sum;
     using DcpAdeElectric<T>::update_q;
@@ -252,38 +350,48 @@ namespace gmes
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx,
-	   DcpAdeElectricParam<T>& dcp_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const auto& c = dcp_param.c;
-      T& e_old = dcp_param.e_old;
+      T& e_old = e_old_list[p];
       
       const T& e_now = ey(i,j,k);
-      T e_new = c[0] * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
-			(hz(i+1,j+1,k) - hz(i,j+1,k)) / dx)
-	+ c[1] * (dps_sum(static_cast<T>(0), dcp_param) + 
-		  cps_sum(static_cast<T>(0), dcp_param))
-	+ c[2] * e_old + c[3] * e_now;
-
-      update_q(e_old, e_now, e_new, dcp_param);
-      update_p(e_old, e_now, e_new, dcp_param);
+      T e_new = c0_list[p] * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
+			      (hz(i+1,j+1,k) - hz(i,j+1,k)) / dx)
+	+ c1_list[p] * (dps_sum(static_cast<T>(0), p) + 
+			 cps_sum(static_cast<T>(0), p))
+	+ c2_list[p] * e_old + c3_list[p] * e_now;
+
+      update_q(e_old, e_now, e_new, p);
+      update_p(e_old, e_now, e_new, p);
       
       e_old = e_now;
       ey(i,j,k) = e_new;
@@ -291,7 +399,11 @@ namespace gmes
     
   protected:
     using DcpAdeElectric<T>::idx_list;
-    using DcpAdeElectric<T>::param_list;
+    using DcpAdeElectric<T>::c0_list;
+    using DcpAdeElectric<T>::c1_list;
+    using DcpAdeElectric<T>::c2_list;
+    using DcpAdeElectric<T>::c3_list;
+    using DcpAdeElectric<T>::e_old_list;
     using DcpAdeElectric<T>::dps_sum;
     using DcpAdeElectric<T>::cps_sum;
     using DcpAdeElectric<T>::update_q;
@@ -308,38 +420,48 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx,
-	   DcpAdeElectricParam<T>& dcp_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const auto& c = dcp_param.c;
-      T& e_old = dcp_param.e_old;
+      T& e_old = e_old_list[p];
 
       const T& e_now = ez(i,j,k);
-      T e_new = c[0] * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
-			(hx(i,j+1,k+1) - hx(i,j,k+1)) / dy)
-	+ c[1] * (dps_sum(static_cast<T>(0), dcp_param) + 
-		  cps_sum(static_cast<T>(0), dcp_param))
-	+ c[2] * e_old + c[3] * e_now;
+      T e_new = c0_list[p] * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
+			      (hx(i,j+1,k+1) - hx(i,j,k+1)) / dy)
+	+ c1_list[p] * (dps_sum(static_cast<T>(0), p) + 
+			 cps_sum(static_cast<T>(0), p))
+	+ c2_list[p] * e_old + c3_list[p] * e_now;
       
-      update_q(e_old, e_now, e_new, dcp_param);
-      update_p(e_old, e_now, e_new, dcp_param);
+      update_q(e_old, e_now, e_new, p);
+      update_p(e_old, e_now, e_new, p);
       
       e_old = e_now;
       ez(i,j,k) = e_new;
@@ -347,7 +469,11 @@ namespace gmes
 
   protected:
     using DcpAdeElectric<T>::idx_list;
-    using DcpAdeElectric<T>::param_list;
+    using DcpAdeElectric<T>::c0_list;
+    using DcpAdeElectric<T>::c1_list;
+    using DcpAdeElectric<T>::c2_list;
+    using DcpAdeElectric<T>::c3_list;
+    using DcpAdeElectric<T>::e_old_list;
     using DcpAdeElectric<T>::dps_sum;
     using DcpAdeElectric<T>::cps_sum;
     using DcpAdeElectric<T>::update_q;
@@ -441,18 +567,6 @@ namespace gmes
       return DcpPlrcElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const pm_param_ptr)
@@ -463,77 +577,166 @@ namespace gmes
       auto dcp_param = *static_cast<const DcpPlrcElectricParam<T> * const>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(dcp_param);
+      eps_inf_list.push_back(dcp_param.eps_inf);
+      a0_list.push_back(column(dcp_param.a, 0));
+      a1_list.push_back(column(dcp_param.a, 1));
+      a2_list.push_back(column(dcp_param.a, 2));
+      b0_list.push_back(column(dcp_param.b, 0));
+      b1_list.push_back(column(dcp_param.b, 1));
+      b2_list.push_back(column(dcp_param.b, 2));
+      c0_list.push_back(dcp_param.c[0]);
+      c1_list.push_back(dcp_param.c[1]);
+      c2_list.push_back(dcp_param.c[2]);
+      psi_dp_re_list.push_back(dcp_param.psi_dp_re);
+      psi_dp_im_list.push_back(dcp_param.psi_dp_im);
+      psi_cp_re_list.push_back(dcp_param.psi_cp_re);
+      psi_cp_im_list.push_back(dcp_param.psi_cp_im);
       
       return this;
     }
 
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(a0_list, cell_num);
+      reserve_more(a1_list, cell_num);
+      reserve_more(a2_list, cell_num);
+      reserve_more(b0_list, cell_num);
+      reserve_more(b1_list, cell_num);
+      reserve_more(b2_list, cell_num);
+      reserve_more(c0_list, cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(psi_dp_re_list, cell_num);
+      reserve_more(psi_dp_im_list, cell_num);
+      reserve_more(psi_cp_re_list, cell_num);
+      reserve_more(psi_cp_im_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto dcp_ptr = static_cast<const DcpPlrcElectric<T>*>(pm_ptr);
       std::copy(dcp_ptr->idx_list.begin(), dcp_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(dcp_ptr->param_list.begin(), dcp_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(dcp_ptr->eps_inf_list.begin(), dcp_ptr->eps_inf_list.end(), std::back_inserter(eps_inf_list));
+      a0_list.append(dcp_ptr->a0_list);
+      a1_list.append(dcp_ptr->a1_list);
+      a2_list.append(dcp_ptr->a2_list);
+      b0_list.append(dcp_ptr->b0_list);
+      b1_list.append(dcp_ptr->b1_list);
+      b2_list.append(dcp_ptr->b2_list);
+      std::copy(dcp_ptr->c0_list.begin(), dcp_ptr->c0_list.end(), std::back_inserter(c0_list));
+      std::copy(dcp_ptr->c1_list.begin(), dcp_ptr->c1_list.end(), std::back_inserter(c1_list));
+      std::copy(dcp_ptr->c2_list.begin(), dcp_ptr->c2_list.end(), std::back_inserter(c2_list));
+      psi_dp_re_list.append(dcp_ptr->psi_dp_re_list);
+      psi_dp_im_list.append(dcp_ptr->psi_dp_im_list);
+      psi_cp_re_list.append(dcp_ptr->psi_cp_re_list);
+      psi_cp_im_list.append(dcp_ptr->psi_cp_im_list);
       return this;
     }
 
     void 
     update_psi_dp(const std::complex<double>& e_now, 
 		  const std::complex<double>& e_new,
-		  DcpPlrcElectricParam<T>& dcp_param)
+		  std::size_t p)
     {
-      const auto& a = dcp_param.a;
-      auto& psi_dp_re = dcp_param.psi_dp_re;
-      auto& psi_dp_im = dcp_param.psi_dp_im;
+      const double* const a0 = a0_list[p];
+      const double* const a1 = a1_list[p];
+      const double* const a2 = a2_list[p];
+      double* const psi_dp_re = psi_dp_re_list[p];
+      double* const psi_dp_im = psi_dp_im_list[p];
       
-      for (typename std::vector<T>::size_type i = 0; i < a.size(); ++i) {
-	psi_dp_re[i] = a[i][0] * e_new.real() 
-	  + a[i][1] * e_now.real() + a[i][2] * psi_dp_re[i];
-	psi_dp_im[i] = a[i][0] * e_new.imag() 
-	  + a[i][1] * e_now.imag() + a[i][2] * psi_dp_im[i];
+      for (std::size_t i = 0; i < psi_dp_re_list.width(); ++i) {
+	psi_dp_re[i] = a0[i] * e_new.real() 
+	  + a1[i] * e_now.real() + a2[i] * psi_dp_re[i];
+	psi_dp_im[i] = a0[i] * e_new.imag() 
+	  + a1[i] * e_now.imag() + a2[i] * psi_dp_im[i];
       }
     }
 
     void 
     update_psi_cp(const std::complex<double>& e_now, 
 		  const std::complex<double>& e_new,
-		  DcpPlrcElectricParam<T>& dcp_param)
+		  std::size_t p)
     {
-      const auto& b = dcp_param.b;
-      auto& psi_cp_re = dcp_param.psi_cp_re;
-      auto& psi_cp_im = dcp_param.psi_cp_im;
+      const std::complex<double>* const b0 = b0_list[p];
+      const std::complex<double>* const b1 = b1_list[p];
+      const std::complex<double>* const b2 = b2_list[p];
+      std::complex<double>* const psi_cp_re = psi_cp_re_list[p];
+      std::complex<double>* const psi_cp_im = psi_cp_im_list[p];
       
-      for (typename std::vector<std::complex<double> >::size_type i = 0; i < b.size(); ++i) {
-	psi_cp_re[i] = b[i][0] * e_new.real() 
-	  + b[i][1] * e_now.real() + b[i][2] * psi_cp_re[i];
-	psi_cp_im[i] = b[i][0] * e_new.imag()
-	  + b[i][1] * e_now.imag() + b[i][2] * psi_cp_im[i];
+      for (std::size_t i = 0; i < psi_cp_re_list.width(); ++i) {
+	psi_cp_re[i] = b0[i] * e_new.real() 
+	  + b1[i] * e_now.real() + b2[i] * psi_cp_re[i];
+	psi_cp_im[i] = b0[i] * e_new.imag()
+	  + b1[i] * e_now.imag() + b2[i] * psi_cp_im[i];
       }
     }
 
     std::complex<double> 
-    psi_total(const DcpPlrcElectricParam<T>& dcp_param) const
+    psi_total(std::size_t p) const
     {
-      const auto& psi_dp_re = dcp_param.psi_dp_re;
-      const auto& psi_dp_im = dcp_param.psi_dp_im;
-      const auto& psi_cp_re = dcp_param.psi_cp_re;
-      const auto& psi_cp_im = dcp_param.psi_cp_im;
+      const double* const psi_dp_re = psi_dp_re_list[p];
+      const double* const psi_dp_im = psi_dp_im_list[p];
+      const std::complex<double>* const psi_cp_re = psi_cp_re_list[p];
+      const std::complex<double>* const psi_cp_im = psi_cp_im_list[p];
+      const std::size_t dp_num = psi_dp_re_list.width();
+      const std::size_t cp_num = psi_cp_re_list.width();
 
       double psi_re = 
-	std::accumulate(psi_dp_re.begin(), psi_dp_re.end(), 0.0) + 
-	std::accumulate(psi_cp_re.begin(), psi_cp_re.end(), std::complex<double>(0)).real();
+	std::accumulate(psi_dp_re, psi_dp_re + dp_num, 0.0) + 
+	std::accumulate(psi_cp_re, psi_cp_re + cp_num, std::complex<double>(0)).real();
       
       double psi_im = 
-	std::accumulate(psi_dp_im.begin(), psi_dp_im.end(), 0.0) +
-	std::accumulate(psi_cp_im.begin(), psi_cp_im.end(), std::complex<double>(0)).real();
+	std::accumulate(psi_dp_im, psi_dp_im + dp_num, 0.0) +
+	std::accumulate(psi_cp_im, psi_cp_im + cp_num, std::complex<double>(0)).real();
       
       return std::complex<double>(psi_re, psi_im);
     }
     
+    int
+    state_arrays() const
+    {
+      return 4;
+    }
+
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<DcpPlrcElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    CellArray<double> a0_list, a1_list, a2_list;
+    CellArray<std::complex<double> > b0_list, b1_list, b2_list;
+    CoeffCnt c0_list, c1_list, c2_list;
+    CellArray<double> psi_dp_re_list, psi_dp_im_list;
+    CellArray<std::complex<double> > psi_cp_re_list, psi_cp_im_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(psi_dp_re_list, p, out);
+      save_cell(psi_dp_im_list, p, out);
+      save_cell(psi_cp_re_list, p, out);
+      save_cell(psi_cp_im_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(psi_dp_re_list);
+      sizes[1] = cell_state_size(psi_dp_im_list);
+      sizes[2] = cell_state_size(psi_cp_re_list);
+      sizes[3] = cell_state_size(psi_cp_im_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(psi_dp_re_list, p, in, sizes[0]);
+      load_cell(psi_dp_im_list, p, in, sizes[1]);
+      load_cell(psi_cp_re_list, p, in, sizes[2]);
+      load_cell(psi_cp_im_list, p, in, sizes[3]);
+    }
 
   private:
     static const std::string tag; // "DcpPlrcElectric"
@@ -565,43 +768,54 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx, 
-	   DcpPlrcElectricParam<T>& dcp_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      
-      const auto& c = dcp_param.c;
 
       const std::complex<double> e_now = ex(i,j,k);
       const std::complex<double> e_new = 
-	c[0] * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
-		(hy(i+1,j,k+1) - hy(i+1,j,k)) / dz) +
-	c[1] * e_now + c[2] * psi_total(dcp_param);
+	c0_list[p] * std::complex<double>((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
+					   (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz) +
+	c1_list[p] * e_now + c2_list[p] * psi_total(p);
       
-      update_psi_dp(e_now, e_new, dcp_param);
-      update_psi_cp(e_now, e_new, dcp_param);
+      update_psi_dp(e_now, e_new, p);
+      update_psi_cp(e_now, e_new, p);
 
       assign(e_new, ex(i,j,k));
   }
 
   protected:
     using DcpPlrcElectric<T>::idx_list;
-    using DcpPlrcElectric<T>::param_list;
+    using DcpPlrcElectric<T>::c0_list;
+    using DcpPlrcElectric<T>::c1_list;
+    using DcpPlrcElectric<T>::c2_list;
     using DcpPlrcElectric<T>::update_psi_dp;
     using DcpPlrcElectric<T>::update_psi_cp;
     using DcpPlrcElectric<T>::psi_total;
@@ -616,43 +830,54 @@ namespace gmes
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx, 
-	   DcpPlrcElectricParam<T>& dcp_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      
-      const auto& c = dcp_param.c;
 
       const std::complex<double> e_now = ey(i,j,k);
       const std::complex<double> e_new = 
-	c[0] * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
-		(hz(i+1,j+1,k) - hz(i,j+1,k)) / dx) +
-	c[1] * e_now + c[2] * psi_total(dcp_param);
+	c0_list[p] * std::complex<double>((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
+					   (hz(i+1,j+1,k) - hz(i,j+1,k)) / dx) +
+	c1_list[p] * e_now + c2_list[p] * psi_total(p);
 
-      update_psi_dp(e_now, e_new, dcp_param);
-      update_psi_cp(e_now, e_new, dcp_param);
+      update_psi_dp(e_now, e_new, p);
+      update_psi_cp(e_now, e_new, p);
 
       assign(e_new, ey(i,j,k));
     }
 
   protected:
     using DcpPlrcElectric<T>::idx_list;
-    using DcpPlrcElectric<T>::param_list;
+    using DcpPlrcElectric<T>::c0_list;
+    using DcpPlrcElectric<T>::c1_list;
+    using DcpPlrcElectric<T>::c2_list;
     using DcpPlrcElectric<T>::update_psi_dp;
     using DcpPlrcElectric<T>::update_psi_cp;
     using DcpPlrcElectric<T>::psi_total;
@@ -667,43 +892,54 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx, 
-	   DcpPlrcElectricParam<T>& dcp_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      
-      const auto& c = dcp_param.c;
 
       const std::complex<double> e_now = ez(i,j,k);
       const std::complex<double> e_new = 
-	c[0] * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
-		(hx(i,j+1,k+1) - hx(i,j,k+1)) / dy) +
-	c[1] * e_now + c[2] * psi_total(dcp_param);
+	c0_list[p] * std::complex<double>((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
+					   (hx(i,j+1,k+1) - hx(i,j,k+1)) / dy) +
+	c1_list[p] * e_now + c2_list[p] * psi_total(p);
 
-      update_psi_dp(e_now, e_new, dcp_param);
-      update_psi_cp(e_now, e_new, dcp_param);
+      update_psi_dp(e_now, e_new, p);
+      update_psi_cp(e_now, e_new, p);
       
       assign(e_new, ez(i,j,k));
     }
 
   protected:
     using DcpPlrcElectric<T>::idx_list;
-    using DcpPlrcElectric<T>::param_list;
+    using DcpPlrcElectric<T>::c0_list;
+    using DcpPlrcElectric<T>::c1_list;
+    using DcpPlrcElectric<T>::c2_list;
     using DcpPlrcElectric<T>::update_psi_dp;
     using DcpPlrcElectric<T>::update_psi_cp;
     using DcpPlrcElectric<T>::psi_total;
@@ -761,11 +997,4 @@ namespace gmes
   const std::string DcpPlrcHz<T>::tag = "DcpPlrcMagnetic";
 }
 
-#undef ex
-#undef ey
-#undef ez
-#undef hx
-#undef hy
-#undef hz
-
 #endif /*PW_DCP_HH_*/
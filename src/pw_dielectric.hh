@@ -11,13 +11,6 @@
 #include <utility>
 #include "pw_material.hh"
 
-#define ex(i,j,k) ex[ex_y_size==1?0:((i)*ex_y_size+(j))*ex_z_size+(k)]
-#define ey(i,j,k) ey[ey_z_size==1?0:((i)*ey_y_size+(j))*ey_z_size+(k)]
-#define ez(i,j,k) ez[ez_x_size==1?0:((i)*ez_y_size+(j))*ez_z_size+(k)]
-#define hx(i,j,k) hx[hx_y_size==1?0:((i)*hx_y_size+(j))*hx_z_size+(k)]
-#define hy(i,j,k) hy[hy_z_size==1?0:((i)*hy_y_size+(j))*hy_z_size+(k)]
-#define hz(i,j,k) hz[hz_x_size==1?0:((i)*hz_y_size+(j))*hz_z_size+(k)]
-
 namespace gmes
 {
   template <typename T> 
@@ -40,18 +33,6 @@ namespace gmes
       return DielectricElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const pm_param_ptr)
@@ -62,7 +43,7 @@ namespace gmes
       const auto& dielectric_param = *static_cast<const DielectricElectricParam<T>*>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(dielectric_param);
+      eps_inf_list.push_back(dielectric_param.eps_inf);
 
       return this;
     }
@@ -75,16 +56,17 @@ namespace gmes
       std::copy(dielectric_ptr->idx_list.begin(), 
 		dielectric_ptr->idx_list.end(), 
 		std::back_inserter(idx_list));
-      std::copy(dielectric_ptr->param_list.begin(), 
-		dielectric_ptr->param_list.end(), 
-		std::back_inserter(param_list));
+      std::copy(dielectric_ptr->eps_inf_list.begin(), 
+		dielectric_ptr->eps_inf_list.end(), 
+		std::back_inserter(eps_inf_list));
       return this;
     }
 
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<DielectricElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    Reciprocal inv_eps_inf_list;
 
   private:
     static const std::string tag; // "DielectricElectric"
@@ -103,26 +85,69 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ex, const Field<const T>& hz,
+		 const Field<const T>& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      update_runs(*this, idx_list, ex, hz, hy, dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ex, const Field<const T>& hz,
+	       const Field<const T>& hy,
+	       double dy, double dz, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      T* const ex_00 = &ex(i,j,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_p0 = &hz(i+1,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+
+	ex_00[l] += dt * inv_eps_inf * ((hz_pp[l] - hz_p0[l]) * inv_dy -
+					(hy_p0[l + 1] - hy_p0[l]) * inv_dz);
       }
     }
     
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx, 
-	   const DielectricElectricParam<T>& dielectric_param) const
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const double eps_inf = dielectric_param.eps_inf;
+      const double eps_inf = eps_inf_list[p];
 
       ex(i,j,k) += dt / eps_inf * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
 				   (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz);
@@ -130,7 +155,8 @@ namespace gmes
     
   protected:
     using DielectricElectric<T>::idx_list;
-    using DielectricElectric<T>::param_list;
+    using DielectricElectric<T>::eps_inf_list;
+    using DielectricElectric<T>::inv_eps_inf_list;
   }; // template DielectricEx
 
   template <typename T>
@@ -143,26 +169,69 @@ namespace gmes
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-      	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ey, const Field<const T>& hx,
+		 const Field<const T>& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      update_runs(*this, idx_list, ey, hx, hz, dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ey, const Field<const T>& hx,
+	       const Field<const T>& hz,
+	       double dz, double dx, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      T* const ey_00 = &ey(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_0p = &hz(i,j+1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+
+	ey_00[l] += dt * inv_eps_inf * ((hx_0p[l + 1] - hx_0p[l]) * inv_dz -
+					(hz_pp[l] - hz_0p[l]) * inv_dx);
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   double dz, double dx, double dt, double n, 
-	   const Index3& idx, 
-	   const DielectricElectricParam<T>& dielectric_param) const
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
+	   double dz, double dx, double dt, double n,
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const double eps_inf = dielectric_param.eps_inf;
+      const double eps_inf = eps_inf_list[p];
 
       ey(i,j,k) += dt / eps_inf * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
 				   (hz(i+1,j+1,k) - hz(i,j+1,k)) / dx);
@@ -170,7 +239,8 @@ namespace gmes
 
   protected:
     using DielectricElectric<T>::idx_list;
-    using DielectricElectric<T>::param_list;
+    using DielectricElectric<T>::eps_inf_list;
+    using DielectricElectric<T>::inv_eps_inf_list;
   }; // template DielectricEy
 
   template <typename T> 
@@ -183,27 +253,70 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n,
-      	       *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ez, const Field<const T>& hy,
+		 const Field<const T>& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      update_runs(*this, idx_list, ez, hy, hx, dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ez, const Field<const T>& hy,
+	       const Field<const T>& hx,
+	       double dx, double dy, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      T* const ez_00 = &ez(i,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+      const T* const hy_00 = &hy(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hx_00 = &hx(i,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+
+	ez_00[l] += dt * inv_eps_inf * ((hy_p0[l + 1] - hy_00[l + 1]) * inv_dx -
+					(hx_0p[l + 1] - hx_00[l + 1]) * inv_dy);
       }
     }
 
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   double dx, double dy, double dt, double n, 
-	   const Index3& idx, 
-	   const DielectricElectricParam<T>& dielectric_param) const
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
+	   double dx, double dy, double dt, double n,
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const double eps_inf = dielectric_param.eps_inf;
+      const double eps_inf = eps_inf_list[p];
 
       ez(i,j,k) += dt / eps_inf * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx -
       				   (hx(i,j+1,k+1) - hx(i,j,k+1)) / dy);
@@ -211,7 +324,8 @@ namespace gmes
 
   protected:
     using DielectricElectric<T>::idx_list;
-    using DielectricElectric<T>::param_list;
+    using DielectricElectric<T>::eps_inf_list;
+    using DielectricElectric<T>::inv_eps_inf_list;
   }; // template DielectricEz
 
   template <typename T> 
@@ -224,18 +338,6 @@ namespace gmes
       return DielectricMagnetic<T>::tag;
     }
 
-    double
-    get_mu_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].mu_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size, 
 	   const PwMaterialParam* const pm_param_ptr)
@@ -246,7 +348,7 @@ namespace gmes
       const auto& dielectric_param = *static_cast<const DielectricMagneticParam<T>*>(pm_param_ptr);
       
       idx_list.push_back(index);
-      param_list.push_back(dielectric_param);
+      mu_inf_list.push_back(dielectric_param.mu_inf);
       
       return this;
     }
@@ -256,14 +358,15 @@ namespace gmes
     {
       auto dielectric_ptr = static_cast<const DielectricMagnetic<T>*>(pm_ptr);
       std::copy(dielectric_ptr->idx_list.begin(), dielectric_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(dielectric_ptr->param_list.begin(), dielectric_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(dielectric_ptr->mu_inf_list.begin(), dielectric_ptr->mu_inf_list.end(), std::back_inserter(mu_inf_list));
       return this;
     }
 
   protected:
     using MaterialMagnetic<T>::position;
     using MaterialMagnetic<T>::idx_list;
-    std::vector<DielectricMagneticParam<T> > param_list;
+    using MaterialMagnetic<T>::mu_inf_list;
+    Reciprocal inv_mu_inf_list;
 
   private:
     static const std::string tag; // "DielectricMagnetic"
@@ -282,26 +385,69 @@ namespace gmes
 	       const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-      	update(hx, hx_x_size, hx_y_size, hx_z_size,
-	       ez, ez_x_size, ez_y_size, ez_z_size,
-	       ey, ey_x_size, ey_y_size, ey_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Hx, class Ez, class Ey>
+    void
+    update_cells(const Hx& hx, const Ez& ez, const Ey& ey,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hx, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hx, ez, ey, dy, dz, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hx, const Field<const T>& ez,
+		 const Field<const T>& ey,
+		 double dy, double dz, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      update_runs(*this, idx_list, hx, ez, ey, dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hx, const Field<const T>& ez,
+	       const Field<const T>& ey,
+	       double dy, double dz, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      T* const hx_00 = &hx(i,j,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_0m = &ez(i,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+
+	hx_00[l] += dt * inv_mu_inf * ((ey_0m[l] - ey_0m[l - 1]) * inv_dz -
+				       (ez_00[l - 1] - ez_0m[l - 1]) * inv_dy);
       }
     }
 
   private:
+    template <class Hx, class Ez, class Ey>
     void
-    update(T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   double dy, double dz, double dt, double n, 
-	   const Index3& idx, 
-	   const DielectricMagneticParam<T>& dielectric_param) const
+    update(const Hx& hx, const Ez& ez, const Ey& ey,
+	   double dy, double dz, double dt, double n,
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const double mu_inf = dielectric_param.mu_inf;
+      const double mu_inf = mu_inf_list[p];
 
       hx(i,j,k) += dt / mu_inf * ((ey(i,j-1,k) - ey(i,j-1,k-1)) / dz -
       				  (ez(i,j,k-1) - ez(i,j-1,k-1)) / dy);
@@ -309,7 +455,8 @@ namespace gmes
 
   protected:
     using DielectricMagnetic<T>::idx_list;
-    using DielectricMagnetic<T>::param_list;
+    using DielectricMagnetic<T>::mu_inf_list;
+    using DielectricMagnetic<T>::inv_mu_inf_list;
   }; // template DielectricHx
 
   template <typename T> 
@@ -322,26 +469,69 @@ namespace gmes
 	       const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-      	update(hy, hy_x_size, hy_y_size, hy_z_size,
-	       ex, ex_x_size, ex_y_size, ex_z_size,
-	       ez, ez_x_size, ez_y_size, ez_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Hy, class Ex, class Ez>
+    void
+    update_cells(const Hy& hy, const Ex& ex, const Ez& ez,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hy, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hy, ex, ez, dz, dx, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hy, const Field<const T>& ex,
+		 const Field<const T>& ez,
+		 double dz, double dx, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      update_runs(*this, idx_list, hy, ex, ez, dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hy, const Field<const T>& ex,
+	       const Field<const T>& ez,
+	       double dz, double dx, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      T* const hy_00 = &hy(i,j,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_m0 = &ez(i-1,j,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+
+	hy_00[l] += dt * inv_mu_inf * ((ez_00[l - 1] - ez_m0[l - 1]) * inv_dx -
+				       (ex_m0[l] - ex_m0[l - 1]) * inv_dz);
       }
     }
 
   private:
-    void 
-    update(T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   double dz, double dx, double dt, double n, 
-	   const Index3& idx, 
-	   const DielectricMagneticParam<T>& dielectric_param) const
+    template <class Hy, class Ex, class Ez>
+    void
+    update(const Hy& hy, const Ex& ex, const Ez& ez,
+	   double dz, double dx, double dt, double n,
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const double mu_inf = dielectric_param.mu_inf;
+      const double mu_inf = mu_inf_list[p];
 
       hy(i,j,k) += dt / mu_inf * ((ez(i,j,k-1) - ez(i-1,j,k-1)) / dx -
       				  (ex(i-1,j,k) - ex(i-1,j,k-1)) / dz);
@@ -349,7 +539,8 @@ namespace gmes
 
   protected:
     using DielectricMagnetic<T>::idx_list;
-    using DielectricMagnetic<T>::param_list;
+    using DielectricMagnetic<T>::mu_inf_list;
+    using DielectricMagnetic<T>::inv_mu_inf_list;
   }; // template DielectricHy
 
   template <typename T> 
@@ -362,26 +553,70 @@ namespace gmes
 	       const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(hz, hz_x_size, hz_y_size, hz_z_size,
-	       ey, ey_x_size, ey_y_size, ey_z_size,
-	       ex, ex_x_size, ex_y_size, ex_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Hz, class Ey, class Ex>
+    void
+    update_cells(const Hz& hz, const Ey& ey, const Ex& ex,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hz, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hz, ey, ex, dx, dy, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hz, const Field<const T>& ey,
+		 const Field<const T>& ex,
+		 double dx, double dy, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      update_runs(*this, idx_list, hz, ey, ex, dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hz, const Field<const T>& ey,
+	       const Field<const T>& ex,
+	       double dx, double dy, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      T* const hz_00 = &hz(i,j,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+      const T* const ex_mm = &ex(i-1,j-1,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+      const T* const ey_mm = &ey(i-1,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+
+	hz_00[l] += dt * inv_mu_inf * ((ex_m0[l] - ex_mm[l]) * inv_dy -
+				       (ey_0m[l] - ey_mm[l]) * inv_dx);
       }
     }
 
   private:
-    void 
-    update(T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   double dx, double dy, double dt, double n, 
-	   const Index3& idx, 
-	   const DielectricMagneticParam<T>& dielectric_param) const
+    template <class Hz, class Ey, class Ex>
+    void
+    update(const Hz& hz, const Ey& ey, const Ex& ex,
+	   double dx, double dy, double dt, double n,
+	   const Index3& idx, std::size_t p) const
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const double mu_inf = dielectric_param.mu_inf;
+      const double mu_inf = mu_inf_list[p];
       
       hz(i,j,k) += dt / mu_inf * ((ex(i-1,j,k) - ex(i-1,j-1,k)) / dy -
 				  (ey(i,j-1,k) - ey(i-1,j-1,k)) / dx);
@@ -389,15 +624,9 @@ namespace gmes
 
   protected:
     using DielectricMagnetic<T>::idx_list;
-    using DielectricMagnetic<T>::param_list;
+    using DielectricMagnetic<T>::mu_inf_list;
+    using DielectricMagnetic<T>::inv_mu_inf_list;
   }; // template DielectricHz
 } // namespace gmes
 
-#undef ex
-#undef ey
-#undef ez
-#undef hx
-#undef hy
-#undef hz
-
 #endif // PW_DIELECTRIC_HH_
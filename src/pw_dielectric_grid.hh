@@ -0,0 +1,438 @@
+/* Non-dispersive isotropic dielectrics updated by a sweep over a
+ * grid laid on the bounding box of their cells. The cells of a
+ * component hold one byte ids into a small table of dt / eps (or
+ * dt / mu), so the bulk of a simulation volume is updated without
+ * per-cell coefficients. The sweep hands the runs of cells the
+ * material owns to update_runs(), whose target clones inline the
+ * update_run() kernels below; there run.p0 locates the ids of a run
+ * in the grid. The update equations are those of
+ * pw_dielectric.hh; sparse or placeholder cases, and the update of a
+ * part of the cells, fall back to them.
+ */
+
+#ifndef PW_DIELECTRIC_GRID_HH_
+#define PW_DIELECTRIC_GRID_HH_
+
+#include <vector>
+#include "pw_dielectric.hh"
+
+namespace gmes
+{
+  template <typename T>
+  class DielectricGridEx: public DielectricEx<T>
+  {
+  public:
+    void
+    update_all(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
+	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+	       double dy, double dz, double dt, double n)
+    {
+      if (ex_y_size == 1 || hz_x_size == 1 || hy_z_size == 1 ||
+	  idx_list.partial() || !grid.sync(idx_list, eps_inf_list)) {
+	DielectricEx<T>::update_all(ex, ex_x_size, ex_y_size, ex_z_size,
+				    hz, hz_x_size, hz_y_size, hz_z_size,
+				    hy, hy_x_size, hy_y_size, hy_z_size,
+				    dy, dz, dt, n);
+	return;
+      }
+
+      sweep(Field<T>(ex, ex_y_size, ex_z_size),
+	    Field<const T>(hz, hz_y_size, hz_z_size),
+	    Field<const T>(hy, hy_y_size, hy_z_size), dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ex, const Field<const T>& hz,
+	       const Field<const T>& hy,
+	       double dy, double dz, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      const unsigned char* const id = grid.row(run);
+      T* const ex_00 = &ex(i,j,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_p0 = &hz(i+1,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	ex_00[l] += coeff[id[l]] * ((hz_pp[l] - hz_p0[l]) * inv_dy -
+				    (hy_p0[l + 1] - hy_p0[l]) * inv_dz);
+      }
+    }
+
+  private:
+    void
+    sweep(const Field<T>& ex, const Field<const T>& hz,
+	  const Field<const T>& hy, double dy, double dz, double dt, double n)
+    {
+      const std::vector<double>& eps_inf = grid.table();
+      coeff.resize(eps_inf.size());
+      coeff[0] = 0;
+      for (std::size_t id = 1; id < eps_inf.size(); ++id) {
+	coeff[id] = dt / eps_inf[id];
+      }
+
+      update_runs(*this, grid, ex, hz, hy, dy, dz, dt, n);
+    }
+
+  protected:
+    using DielectricEx<T>::idx_list;
+    using DielectricEx<T>::eps_inf_list;
+
+  private:
+    CoeffGrid grid;
+    CoeffCnt coeff;
+  }; // template DielectricGridEx
+
+  template <typename T>
+  class DielectricGridEy: public DielectricEy<T>
+  {
+  public:
+    void
+    update_all(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
+	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+	       double dz, double dx, double dt, double n)
+    {
+      if (ey_z_size == 1 || hx_y_size == 1 || hz_x_size == 1 ||
+	  idx_list.partial() || !grid.sync(idx_list, eps_inf_list)) {
+	DielectricEy<T>::update_all(ey, ey_x_size, ey_y_size, ey_z_size,
+				    hx, hx_x_size, hx_y_size, hx_z_size,
+				    hz, hz_x_size, hz_y_size, hz_z_size,
+				    dz, dx, dt, n);
+	return;
+      }
+
+      sweep(Field<T>(ey, ey_y_size, ey_z_size),
+	    Field<const T>(hx, hx_y_size, hx_z_size),
+	    Field<const T>(hz, hz_y_size, hz_z_size), dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ey, const Field<const T>& hx,
+	       const Field<const T>& hz,
+	       double dz, double dx, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      const unsigned char* const id = grid.row(run);
+      T* const ey_00 = &ey(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_0p = &hz(i,j+1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	ey_00[l] += coeff[id[l]] * ((hx_0p[l + 1] - hx_0p[l]) * inv_dz -
+				    (hz_pp[l] - hz_0p[l]) * inv_dx);
+      }
+    }
+
+  private:
+    void
+    sweep(const Field<T>& ey, const Field<const T>& hx,
+	  const Field<const T>& hz, double dz, double dx, double dt, double n)
+    {
+      const std::vector<double>& eps_inf = grid.table();
+      coeff.resize(eps_inf.size());
+      coeff[0] = 0;
+      for (std::size_t id = 1; id < eps_inf.size(); ++id) {
+	coeff[id] = dt / eps_inf[id];
+      }
+
+      update_runs(*this, grid, ey, hx, hz, dz, dx, dt, n);
+    }
+
+  protected:
+    using DielectricEy<T>::idx_list;
+    using DielectricEy<T>::eps_inf_list;
+
+  private:
+    CoeffGrid grid;
+    CoeffCnt coeff;
+  }; // template DielectricGridEy
+
+  template <typename T>
+  class DielectricGridEz: public DielectricEz<T>
+  {
+  public:
+    void
+    update_all(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
+	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+	       double dx, double dy, double dt, double n)
+    {
+      if (ez_x_size == 1 || hy_z_size == 1 || hx_y_size == 1 ||
+	  idx_list.partial() || !grid.sync(idx_list, eps_inf_list)) {
+	DielectricEz<T>::update_all(ez, ez_x_size, ez_y_size, ez_z_size,
+				    hy, hy_x_size, hy_y_size, hy_z_size,
+				    hx, hx_x_size, hx_y_size, hx_z_size,
+				    dx, dy, dt, n);
+	return;
+      }
+
+      sweep(Field<T>(ez, ez_y_size, ez_z_size),
+	    Field<const T>(hy, hy_y_size, hy_z_size),
+	    Field<const T>(hx, hx_y_size, hx_z_size), dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ez, const Field<const T>& hy,
+	       const Field<const T>& hx,
+	       double dx, double dy, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      const unsigned char* const id = grid.row(run);
+      T* const ez_00 = &ez(i,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+      const T* const hy_00 = &hy(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hx_00 = &hx(i,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	ez_00[l] += coeff[id[l]] * ((hy_p0[l + 1] - hy_00[l + 1]) * inv_dx -
+				    (hx_0p[l + 1] - hx_00[l + 1]) * inv_dy);
+      }
+    }
+
+  private:
+    void
+    sweep(const Field<T>& ez, const Field<const T>& hy,
+	  const Field<const T>& hx, double dx, double dy, double dt, double n)
+    {
+      const std::vector<double>& eps_inf = grid.table();
+      coeff.resize(eps_inf.size());
+      coeff[0] = 0;
+      for (std::size_t id = 1; id < eps_inf.size(); ++id) {
+	coeff[id] = dt / eps_inf[id];
+      }
+
+      update_runs(*this, grid, ez, hy, hx, dx, dy, dt, n);
+    }
+
+  protected:
+    using DielectricEz<T>::idx_list;
+    using DielectricEz<T>::eps_inf_list;
+
+  private:
+    CoeffGrid grid;
+    CoeffCnt coeff;
+  }; // template DielectricGridEz
+
+  template <typename T>
+  class DielectricGridHx: public DielectricHx<T>
+  {
+  public:
+    void
+    update_all(T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+	       const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
+	       const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
+	       double dy, double dz, double dt, double n)
+    {
+      if (hx_y_size == 1 || ez_x_size == 1 || ey_z_size == 1 ||
+	  idx_list.partial() || !grid.sync(idx_list, mu_inf_list)) {
+	DielectricHx<T>::update_all(hx, hx_x_size, hx_y_size, hx_z_size,
+				    ez, ez_x_size, ez_y_size, ez_z_size,
+				    ey, ey_x_size, ey_y_size, ey_z_size,
+				    dy, dz, dt, n);
+	return;
+      }
+
+      sweep(Field<T>(hx, hx_y_size, hx_z_size),
+	    Field<const T>(ez, ez_y_size, ez_z_size),
+	    Field<const T>(ey, ey_y_size, ey_z_size), dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hx, const Field<const T>& ez,
+	       const Field<const T>& ey,
+	       double dy, double dz, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      const unsigned char* const id = grid.row(run);
+      T* const hx_00 = &hx(i,j,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_0m = &ez(i,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	hx_00[l] += coeff[id[l]] * ((ey_0m[l] - ey_0m[l - 1]) * inv_dz -
+				    (ez_00[l - 1] - ez_0m[l - 1]) * inv_dy);
+      }
+    }
+
+  private:
+    void
+    sweep(const Field<T>& hx, const Field<const T>& ez,
+	  const Field<const T>& ey, double dy, double dz, double dt, double n)
+    {
+      const std::vector<double>& mu_inf = grid.table();
+      coeff.resize(mu_inf.size());
+      coeff[0] = 0;
+      for (std::size_t id = 1; id < mu_inf.size(); ++id) {
+	coeff[id] = dt / mu_inf[id];
+      }
+
+      update_runs(*this, grid, hx, ez, ey, dy, dz, dt, n);
+    }
+
+  protected:
+    using DielectricHx<T>::idx_list;
+    using DielectricHx<T>::mu_inf_list;
+
+  private:
+    CoeffGrid grid;
+    CoeffCnt coeff;
+  }; // template DielectricGridHx
+
+  template <typename T>
+  class DielectricGridHy: public DielectricHy<T>
+  {
+  public:
+    void
+    update_all(T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+	       const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
+	       const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
+	       double dz, double dx, double dt, double n)
+    {
+      if (hy_z_size == 1 || ex_y_size == 1 || ez_x_size == 1 ||
+	  idx_list.partial() || !grid.sync(idx_list, mu_inf_list)) {
+	DielectricHy<T>::update_all(hy, hy_x_size, hy_y_size, hy_z_size,
+				    ex, ex_x_size, ex_y_size, ex_z_size,
+				    ez, ez_x_size, ez_y_size, ez_z_size,
+				    dz, dx, dt, n);
+	return;
+      }
+
+      sweep(Field<T>(hy, hy_y_size, hy_z_size),
+	    Field<const T>(ex, ex_y_size, ex_z_size),
+	    Field<const T>(ez, ez_y_size, ez_z_size), dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hy, const Field<const T>& ex,
+	       const Field<const T>& ez,
+	       double dz, double dx, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      const unsigned char* const id = grid.row(run);
+      T* const hy_00 = &hy(i,j,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_m0 = &ez(i-1,j,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	hy_00[l] += coeff[id[l]] * ((ez_00[l - 1] - ez_m0[l - 1]) * inv_dx -
+				    (ex_m0[l] - ex_m0[l - 1]) * inv_dz);
+      }
+    }
+
+  private:
+    void
+    sweep(const Field<T>& hy, const Field<const T>& ex,
+	  const Field<const T>& ez, double dz, double dx, double dt, double n)
+    {
+      const std::vector<double>& mu_inf = grid.table();
+      coeff.resize(mu_inf.size());
+      coeff[0] = 0;
+      for (std::size_t id = 1; id < mu_inf.size(); ++id) {
+	coeff[id] = dt / mu_inf[id];
+      }
+
+      update_runs(*this, grid, hy, ex, ez, dz, dx, dt, n);
+    }
+
+  protected:
+    using DielectricHy<T>::idx_list;
+    using DielectricHy<T>::mu_inf_list;
+
+  private:
+    CoeffGrid grid;
+    CoeffCnt coeff;
+  }; // template DielectricGridHy
+
+  template <typename T>
+  class DielectricGridHz: public DielectricHz<T>
+  {
+  public:
+    void
+    update_all(T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+	       const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
+	       const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
+	       double dx, double dy, double dt, double n)
+    {
+      if (hz_x_size == 1 || ey_z_size == 1 || ex_y_size == 1 ||
+	  idx_list.partial() || !grid.sync(idx_list, mu_inf_list)) {
+	DielectricHz<T>::update_all(hz, hz_x_size, hz_y_size, hz_z_size,
+				    ey, ey_x_size, ey_y_size, ey_z_size,
+				    ex, ex_x_size, ex_y_size, ex_z_size,
+				    dx, dy, dt, n);
+	return;
+      }
+
+      sweep(Field<T>(hz, hz_y_size, hz_z_size),
+	    Field<const T>(ey, ey_y_size, ey_z_size),
+	    Field<const T>(ex, ex_y_size, ex_z_size), dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hz, const Field<const T>& ey,
+	       const Field<const T>& ex,
+	       double dx, double dy, double dt, double n,
+	       const Run& run) const
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      const unsigned char* const id = grid.row(run);
+      T* const hz_00 = &hz(i,j,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+      const T* const ex_mm = &ex(i-1,j-1,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+      const T* const ey_mm = &ey(i-1,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	hz_00[l] += coeff[id[l]] * ((ex_m0[l] - ex_mm[l]) * inv_dy -
+				    (ey_0m[l] - ey_mm[l]) * inv_dx);
+      }
+    }
+
+  private:
+    void
+    sweep(const Field<T>& hz, const Field<const T>& ey,
+	  const Field<const T>& ex, double dx, double dy, double dt, double n)
+    {
+      const std::vector<double>& mu_inf = grid.table();
+      coeff.resize(mu_inf.size());
+      coeff[0] = 0;
+      for (std::size_t id = 1; id < mu_inf.size(); ++id) {
+	coeff[id] = dt / mu_inf[id];
+      }
+
+      update_runs(*this, grid, hz, ey, ex, dx, dy, dt, n);
+    }
+
+  protected:
+    using DielectricHz<T>::idx_list;
+    using DielectricHz<T>::mu_inf_list;
+
+  private:
+    CoeffGrid grid;
+    CoeffCnt coeff;
+  }; // template DielectricGridHz
+} // namespace gmes
+
+#endif // PW_DIELECTRIC_GRID_HH_
@@ -22,68 +22,53 @@
 #define PW_DM2_HH_
 
 #include <array>
-#include <numeric>
 #include <stdexcept>
 #include <vector>
 #include <cmath>
 
 #include "pw_dielectric.hh"
 
-#define ex(i,j,k) ex[ex_y_size==1?0:((i)*ex_y_size+(j))*ex_z_size+(k)]
-#define ey(i,j,k) ey[ey_z_size==1?0:((i)*ey_y_size+(j))*ey_z_size+(k)]
-#define ez(i,j,k) ez[ez_x_size==1?0:((i)*ez_y_size+(j))*ez_z_size+(k)]
-#define hx(i,j,k) hx[hx_y_size==1?0:((i)*hx_y_size+(j))*hx_z_size+(k)]
-#define hy(i,j,k) hy[hy_z_size==1?0:((i)*hy_y_size+(j))*hy_z_size+(k)]
-#define hz(i,j,k) hz[hz_x_size==1?0:((i)*hz_y_size+(j))*hz_z_size+(k)]
-
 namespace gmes
 {  
-  // TODO: l2_norm should be a local function.
+  // Add the squared change of an iterate from prev to next to
+  // diff2, and the squared prev to ref2. The iteration converges when
+  // the ratio of their square roots is within the tolerance.
   template <typename T>
-  double 
-  l2_norm(const T& e, const std::vector<std::array<T, 3> >& u)
+  inline void
+  add_change(T next, T prev, double& diff2, double& ref2)
   {
-    T accu = e * e;
-    for (std::size_t i = 0; i < u.size(); ++i) {  
-      accu += std::inner_product(u[i].begin(), u[i].end(), 
-                                 u[i].begin(), static_cast<T>(0));
-    }
+    diff2 += (next - prev) * (next - prev);
+    ref2 += prev * prev;
+  } // template add_change
 
-    // accu += std::accumulate(u.begin(), u.end(), 0,
-    //                         [](int a, const std::array<int, 3>& b)
-    //                         { 
-    //                           return a + std::inner_product(b.begin(), b.end(), 
-    //                                                         b.begin(),
-    //                                                         static_cast<T>(0));
-    //                         }
-    //                         );
 
-    return std::sqrt(accu);
-  } // template l2_norm
+  // Solvers of the implicit update of a cell. The fixed-point solver
+  // iterates the update equations until they settle. The Newton 
+  // solver eliminates the density matrix vectors, which are linear in
+  // them for a given field, and runs Newton iterations on the field 
+  // alone for several cells at a time.
+  enum Dm2Solver
+    {
+      DM2_FIXED_POINT, DM2_NEWTON
+    };
 
 
-  // TODO: rel_error should be a local function.
+  // Number of cells the Newton solver takes together from a run of 
+  // cells. The cells writing to a placeholder read the fields of the
+  // cells before them, so they are taken one by one.
   template <typename T>
-  double
-  rel_error(const T& e_new, const std::vector<std::array<T, 3> >& u_new,
-            const T& e_ref, const std::vector<std::array<T, 3> >& u_ref)
+  int
+  dm2_lanes(const Field<T>&)
   {
-    T e_diff = e_new - e_ref;
-
-    std::vector<std::array<T, 3> > u_diff;
-    u_diff.reserve(u_ref.size());
+    return 8;
+  }
 
-    for (std::size_t  i = 0; i < u_ref.size(); ++i) {
-      std::set_difference(u_new[i].begin(), u_new[i].end(),
-                          u_ref[i].begin(), u_ref[i].end(),
-                          u_diff[i].begin());
-    }
-
-    double denom = l2_norm(e_diff, u_diff);
-    double num = l2_norm(e_ref, u_ref);
-    
-    return denom / num;
-  } // template rel_error
+  template <typename T>
+  int
+  dm2_lanes(const Placeholder<T>&)
+  {
+    return 1;
+  }
 
 
   template <typename T> 
@@ -96,6 +81,7 @@ namespace gmes
     double t1, t2;
     double hbar;
     double rtol;
+    int solver; // one of Dm2Solver
 
     std::vector<std::array<T, 3> > u;
   }; // template Dm2ElectricParam
@@ -107,10 +93,15 @@ namespace gmes
   }; // template Dm2MagneticParam
 
   
-  template <typename T> 
+  template <typename T>
   class Dm2Electric: public MaterialElectric<T>
   {
   public:
+    Dm2Electric():
+      coeff_t(0), coeff_width(0)
+    {
+    }
+
     // TODO: range check of bin
     T
     get_rho(const int* const idx, int idx_size, int bin, int rho_idx, double t) const
@@ -122,22 +113,22 @@ namespace gmes
       if (i < 0)
         return 0;
       else {
-        const auto& p = param_list[i];
-	  
+        const ParamSet& ps = param_set(i);
         switch (rho_idx)
           {
           case 0:
+            return exp(-t / ps.t2) * u0_list[i][bin];
           case 1:
-            return exp(-t / p.t2) * p.u[bin][rho_idx];
+            return exp(-t / ps.t2) * u1_list[i][bin];
 	  case 2:
-            return p.rho30 + exp(-t / p.t1) * p.u[bin][rho_idx];
+            return ps.rho30 + exp(-t / ps.t1) * u2_list[i][bin];
 	  default:
             throw std::out_of_range("rho_idx should be in [0, 2]");
             return 0;
 	  }
       }
     }
-    
+
     void
     get_u(const int* const idx, int idx_size, double t, double* const u, int u_size) const
     {
@@ -148,11 +139,9 @@ namespace gmes
       if (i < 0)
         return;
       else {
-        const auto& p = param_list[i];
-
-        double factor = exp(-t / p.t2);
+        double factor = exp(-t / param_set(i).t2);
         for (int j = 0; j < u_size; ++j) {
-          u[j] = factor * p.u[j][0];
+          u[j] = factor * u0_list[i][j];
         }
       }
     }
@@ -167,11 +156,9 @@ namespace gmes
       if (i < 0)
         return;
       else {
-        const auto& p = param_list[i];
-
-        double factor = exp(-t / p.t2);
+        double factor = exp(-t / param_set(i).t2);
         for (int j = 0; j < v_size; ++j) {
-          v[j] = factor * p.u[j][1];
+          v[j] = factor * u1_list[i][j];
         }
       }
     }
@@ -186,32 +173,19 @@ namespace gmes
       if (i < 0)
         return;
       else {
-        const auto& p = param_list[i];
-
-        double factor = exp(-t / p.t1);
+        const ParamSet& ps = param_set(i);
+        double factor = exp(-t / ps.t1);
         for (int j = 0; j < w_size; ++j) {
-          w[j] = p.rho30 + factor * p.u[j][2];
+          w[j] = ps.rho30 + factor * u2_list[i][j];
         }
       }
     }
 
-    const std::string& 
+    const std::string&
     name() const
     {
       return Dm2Electric<T>::tag;
     }
-    
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
 
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
@@ -223,93 +197,495 @@ namespace gmes
       const auto& dm2_param = *static_cast<const Dm2ElectricParam<T> * const>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(dm2_param);
+      eps_inf_list.push_back(dm2_param.eps_inf);
+
+      ParamSet ps;
+      ps.omega = dm2_param.omega;
+      ps.n_atom = dm2_param.n_atom;
+      ps.rho30 = dm2_param.rho30;
+      ps.gamma = dm2_param.gamma;
+      ps.t1 = dm2_param.t1;
+      ps.t2 = dm2_param.t2;
+      ps.hbar = dm2_param.hbar;
+      ps.rtol = dm2_param.rtol;
+      ps.solver = dm2_param.solver;
+      set_id_list.push_back(add_param_set(ps));
+
+      u0_list.push_back(column(dm2_param.u, 0));
+      u1_list.push_back(column(dm2_param.u, 1));
+      u2_list.push_back(column(dm2_param.u, 2));
+      reserve_work();
 
       return this;
     };
 
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(set_id_list, cell_num);
+      reserve_more(u0_list, cell_num);
+      reserve_more(u1_list, cell_num);
+      reserve_more(u2_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
-      auto dm2_ptr 
+      auto dm2_ptr
 	= static_cast<const Dm2Electric<T>*>(pm_ptr);
-      std::copy(dm2_ptr->idx_list.begin(), 
-		dm2_ptr->idx_list.end(), 
+      std::copy(dm2_ptr->idx_list.begin(),
+		dm2_ptr->idx_list.end(),
 		std::back_inserter(idx_list));
-      std::copy(dm2_ptr->param_list.begin(), 
-		dm2_ptr->param_list.end(), 
-		std::back_inserter(param_list));
+      std::copy(dm2_ptr->eps_inf_list.begin(),
+		dm2_ptr->eps_inf_list.end(),
+		std::back_inserter(eps_inf_list));
+      std::vector<int> set_id(dm2_ptr->param_set_list.size());
+      for (std::size_t s = 0; s < set_id.size(); ++s)
+	set_id[s] = add_param_set(dm2_ptr->param_set_list[s]);
+      for (auto id: dm2_ptr->set_id_list)
+	set_id_list.push_back(set_id[id]);
+      u0_list.append(dm2_ptr->u0_list);
+      u1_list.append(dm2_ptr->u1_list);
+      u2_list.append(dm2_ptr->u2_list);
+      reserve_work();
       return this;
     }
-    
+
+    int
+    state_arrays() const
+    {
+      return 3;
+    }
+
+    // Statistics of the solvers since the last reset_stats: the number
+    // of the solved cells, summed over the steps, the total number of 
+    // their iterations, and the largest number of iterations of a cell.
+    std::size_t
+    solved_num() const
+    {
+      std::size_t num = 0;
+      for (const auto& w: work_list)
+	num += w.solved_num;
+      return num;
+    }
+
+    std::size_t
+    iteration_num() const
+    {
+      std::size_t num = 0;
+      for (const auto& w: work_list)
+	num += w.iteration_num;
+      return num;
+    }
+
+    int
+    max_iteration_num() const
+    {
+      int num = 0;
+      for (const auto& w: work_list)
+	num = std::max(num, w.max_iteration_num);
+      return num;
+    }
+
+    void
+    reset_stats()
+    {
+      for (auto& w: work_list) {
+	w.solved_num = w.iteration_num = 0;
+	w.max_iteration_num = 0;
+      }
+    }
+
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<Dm2ElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    // Parameters of the two-level atoms, which are shared by many
+    // cells.
+    struct ParamSet
+    {
+      std::vector<double> omega, n_atom;
+      double rho30, gamma, t1, t2, hbar, rtol;
+      int solver;
+
+      bool
+      operator==(const ParamSet& other) const
+      {
+	return omega == other.omega && n_atom == other.n_atom
+	  && rho30 == other.rho30 && gamma == other.gamma
+	  && t1 == other.t1 && t2 == other.t2
+	  && hbar == other.hbar && rtol == other.rtol
+	  && solver == other.solver;
+      }
+    }; // struct ParamSet
 
-    void
-    a(double t, const Dm2ElectricParam<T>& dm2_param,
-      std::vector<double>& a_out) const 
+    // Time-dependent coefficients of a parameter set at a time step.
+    // a, b, and omega are per bin, padded with zeros to the width of
+    // the density matrix vectors.
+    struct Coeff
+    {
+      std::vector<double> a, b, omega;
+      double c_plus, c_minus, d;
+    }; // struct Coeff
+
+    static const int lane_num = 8;
+    static const int max_newton_iterations = 50;
+
+    // Scratch space and iteration counts of a thread.
+    struct Work
     {
-      const auto& n_atom = dm2_param.n_atom;
-      const auto& gamma = dm2_param.gamma;
-      const auto& t2 = dm2_param.t2;
+      std::vector<T> u;
+      std::size_t solved_num, iteration_num;
+      int max_iteration_num;
+    }; // struct Work
 
-      for (std::size_t i = 0; i < n_atom.size(); ++i) {
-        a_out.push_back(n_atom[i] * gamma / t2 * exp(-t / t2));
+    // Newton cells of a run gathered for solve_newton.
+    struct Batch
+    {
+      Batch(int limit):
+	size(0), limit(limit)
+      {
       }
+
+      int size, limit;
+      std::size_t p[lane_num];
+      T* field[lane_num];
+      T e_old[lane_num], e_free[lane_num];
+    }; // struct Batch
+
+    CellArray<T> u0_list, u1_list, u2_list;
+    std::vector<int> set_id_list;
+    std::vector<ParamSet> param_set_list;
+    std::vector<Coeff> coeff_list;
+    double coeff_t;
+    std::size_t coeff_width;
+    std::vector<Work> work_list;
+
+    const ParamSet&
+    param_set(std::size_t p) const
+    {
+      return param_set_list[set_id_list[p]];
+    }
+
+    // Return the id of ps in the parameter sets, which is added unless
+    // found.
+    int
+    add_param_set(const ParamSet& ps)
+    {
+      for (std::size_t s = param_set_list.size(); s > 0; --s)
+	if (param_set_list[s - 1] == ps)
+	  return s - 1;
+
+      param_set_list.push_back(ps);
+      return param_set_list.size() - 1;
     }
 
+    // Compute the coefficients of every parameter set at the time t,
+    // unless they are up to date. The cells share them in the step.
     void
-    b(double t, const Dm2ElectricParam<T>& dm2_param,
-      std::vector<double>& b_out) const
+    sync_coeff(double t)
     {
-      const auto& n_atom = dm2_param.n_atom;
-      const auto& gamma = dm2_param.gamma;
-      const auto& omega = dm2_param.omega;
-      const auto& t2 = dm2_param.t2;
+      const std::size_t width = u0_list.width();
+      if (coeff_list.size() == param_set_list.size() 
+	  && coeff_t == t && coeff_width == width)
+	return;
+
+      coeff_list.resize(param_set_list.size());
+      for (std::size_t s = 0; s < param_set_list.size(); ++s) {
+	const ParamSet& ps = param_set_list[s];
+	Coeff& c = coeff_list[s];
+	c.a.assign(width, 0);
+	c.b.assign(width, 0);
+	c.omega.assign(width, 0);
+	std::copy(ps.omega.begin(),
+		  ps.omega.begin() + std::min(width, ps.omega.size()),
+		  c.omega.begin());
+
+	const double decay = exp(-t / ps.t2);
+	for (std::size_t i = 0; i < std::min(width, ps.n_atom.size()); ++i) {
+	  c.a[i] = ps.n_atom[i] * ps.gamma / ps.t2 * decay;
+	  c.b[i] = ps.n_atom[i] * ps.gamma * c.omega[i] * decay;
+	}
+	c.c_plus = 2 / ps.hbar * ps.gamma * exp(-t * (1 / ps.t1 - 1 / ps.t2));
+	c.c_minus = 2 / ps.hbar * ps.gamma * exp(-t * (1 / ps.t2 - 1 / ps.t1));
+	c.d = 2 / ps.hbar * ps.gamma * ps.rho30 * exp(t / ps.t2);
+      }
+
+      coeff_t = t;
+      coeff_width = width;
+    }
 
-      for (std::size_t i = 0; i < n_atom.size(); ++i) {
-        b_out.push_back(n_atom[i] * gamma * omega[i] * exp(-t / t2));
+    // Size the scratch space of the solvers for every thread. It grows
+    // only when the bins widen or the threads increase, so the updates
+    // do not allocate.
+    void
+    reserve_work()
+    {
+      const std::size_t size = 3 * u0_list.width() * lane_num;
+      const std::size_t thread_num = get_num_threads();
+      if (work_list.size() < thread_num)
+	work_list.resize(thread_num);
+      for (auto& w: work_list)
+	if (w.u.size() < size)
+	  w.u.resize(size);
+    }
+
+    static void
+    record(Work& w, int iterations)
+    {
+      ++w.solved_num;
+      w.iteration_num += iterations;
+      w.max_iteration_num = std::max(w.max_iteration_num, iterations);
+    }
+
+    // Prepare the shared coefficients and the scratch space for the
+    // update of the cells at the time step n.
+    void
+    prepare_update(double dt, double n)
+    {
+      sync_coeff((n + 0.5) * dt);
+      reserve_work();
+    }
+
+    // Solve the cell at p, whose field f is updated to e_free without
+    // the atoms, by the solver of its parameter set. The Newton cells 
+    // are gathered into the batch, and solved when it fills up or is
+    // flushed.
+    void
+    solve_cell(Batch& batch, std::size_t p, T& f, T e_free, double dt)
+    {
+      if (param_set(p).solver != DM2_NEWTON) {
+	f = solve(p, f, e_free, dt);
+	return;
       }
+
+      const int l = batch.size++;
+      batch.p[l] = p;
+      batch.field[l] = &f;
+      batch.e_old[l] = f;
+      batch.e_free[l] = e_free;
+      if (batch.size == batch.limit)
+	flush(batch, dt);
     }
 
-    void 
-    c_plus(double t, const Dm2ElectricParam<T>& dm2_param,
-           double& c_out) const
+    void
+    flush(Batch& batch, double dt)
+    {
+      if (batch.size > 0)
+	solve_newton(batch, dt);
+      batch.size = 0;
+    }
+
+    // Solve the field and the density matrix vectors of the cell at p
+    // by the predictor-corrector iteration, and return the new field.
+    // e_old is the field before the step, and e_free the field after 
+    // the step without the atoms. The vectors are iterated in place, 
+    // and those before the step are kept in the scratch space of the 
+    // thread.
+    T
+    solve(std::size_t p, T e_old, T e_free, double dt)
     {
-      const auto& gamma = dm2_param.gamma;
-      const auto& t1 = dm2_param.t1;
-      const auto& t2 = dm2_param.t2;
-      const auto& hbar = dm2_param.hbar;
-      
-      c_out = 2 / hbar * gamma * exp(-t * (1 / t1 - 1 / t2));
+      const std::size_t width = u0_list.width();
+      const Coeff& coeff = coeff_list[set_id_list[p]];
+      const double* const a = coeff.a.data();
+      const double* const b = coeff.b.data();
+      const double* const omega = coeff.omega.data();
+      const double c_plus = coeff.c_plus;
+      const double c_minus = coeff.c_minus;
+      const double d = coeff.d;
+      const double rtol = param_set(p).rtol;
+      T* const u0 = u0_list[p];
+      T* const u1 = u1_list[p];
+      T* const u2 = u2_list[p];
+      Work& w = work_list[get_thread_num()];
+      T* const u = w.u.data();
+
+      for (std::size_t i = 0; i < width; ++i) {
+	u[3 * i] = u0[i];
+	u[3 * i + 1] = u1[i];
+	u[3 * i + 2] = u2[i];
+      }
+
+      T e_new = e_old;
+      double diff2, ref2;
+      int iterations = 0;
+      do {
+	++iterations;
+	const T e_prev = e_new;
+	e_new = e_free;
+	for (std::size_t i = 0; i < width; ++i) {
+	  e_new -= .5 * dt * a[i] * (u0[i] + u[3 * i]);
+	  e_new += .5 * dt * b[i] * (u1[i] + u[3 * i + 1]);
+	}
+
+	diff2 = ref2 = 0;
+	add_change(e_new, e_prev, diff2, ref2);
+
+	const T e_sum = e_new + e_old;
+	for (std::size_t i = 0; i < width; ++i) {
+	  const T v0 = u[3 * i] 
+	    + .5 * dt * omega[i] * (u1[i] + u[3 * i + 1]);
+	  add_change(v0, u0[i], diff2, ref2);
+	  u0[i] = v0;
+
+	  const T v1 = u[3 * i + 1] 
+	    - .5 * dt * omega[i] * (u0[i] + u[3 * i])
+	    + .25 * dt * c_plus * (u2[i] + u[3 * i + 2]) * e_sum
+	    + .5 * dt * d * e_sum;
+	  add_change(v1, u1[i], diff2, ref2);
+	  u1[i] = v1;
+
+	  const T v2 = u[3 * i + 2] 
+	    - .25 * dt * c_minus * (u1[i] + u[3 * i + 1]) * e_sum;
+	  add_change(v2, u2[i], diff2, ref2);
+	  u2[i] = v2;
+	}
+      } while (diff2 > rtol * rtol * ref2);
+
+      record(w, iterations);
+      return e_new;
     }
 
+    // Solve the cells of the batch by Newton iterations on their fields,
+    // a cell in each lane. For a field E the update equations of a bin
+    // are linear in its density matrix vectors, and the sums X, Y, Z of
+    // the vectors before and after the step follow in closed form. The
+    // field solves 
+    //   F(E) = E - e_free + dt / 2 * sum(a * X - b * Y) = 0.
+    // A lane stops iterating when the change of its field is within the
+    // tolerance relative to the norm of the field and the vectors, and
+    // the cells are written once all lanes stop.
     void
-    c_minus(double t, const Dm2ElectricParam<T>& dm2_param,
-            double& c_out) const
+    solve_newton(Batch& batch, double dt)
     {
-      const auto& gamma = dm2_param.gamma;
-      const auto& t1 = dm2_param.t1;
-      const auto& t2 = dm2_param.t2;
-      const auto& hbar = dm2_param.hbar;
+      const std::size_t width = u0_list.width();
+      const int num = batch.size;
+      const double h_dt = .5 * dt, q_dt = .25 * dt;
+      Work& w = work_list[get_thread_num()];
+
+      // The vectors before the step at u[(3 * i + c) * lane_num + l]
+      // for the component c of the bin i in the lane l.
+      T* const u = w.u.data();
+      const Coeff* coeff[lane_num];
+      double e[lane_num], e_old[lane_num], e_free[lane_num], rtol2[lane_num];
+      bool active[lane_num];
+      int iterations[lane_num];
+
+      // The idle lanes repeat the first cell.
+      for (int l = 0; l < lane_num; ++l) {
+	const int m = l < num ? l : 0;
+	const std::size_t p = batch.p[m];
+	coeff[l] = &coeff_list[set_id_list[p]];
+	e[l] = e_old[l] = batch.e_old[m];
+	e_free[l] = batch.e_free[m];
+	rtol2[l] = param_set(p).rtol * param_set(p).rtol;
+	active[l] = l < num;
+	iterations[l] = 0;
+	for (std::size_t i = 0; i < width; ++i) {
+	  u[3 * i * lane_num + l] = u0_list[p][i];
+	  u[(3 * i + 1) * lane_num + l] = u1_list[p][i];
+	  u[(3 * i + 2) * lane_num + l] = u2_list[p][i];
+	}
+      }
+
+      for (int it = 1, remaining = num; remaining > 0; ++it) {
+	double f[lane_num], df[lane_num], ref2[lane_num];
+	for (int l = 0; l < lane_num; ++l) {
+	  f[l] = e[l] - e_free[l];
+	  df[l] = 1;
+	  ref2[l] = e[l] * e[l];
+	}
+
+	for (std::size_t i = 0; i < width; ++i) {
+	  const T* const u_i = u + 3 * i * lane_num;
+#pragma omp simd
+	  for (int l = 0; l < lane_num; ++l) {
+	    const Coeff& c = *coeff[l];
+	    const double s = e[l] + e_old[l];
+	    const double h = h_dt * c.omega[i];
+	    const double k_s = q_dt * c.c_plus, m_s = q_dt * c.c_minus;
+	    const double g_s = h_dt * c.d;
+	    const double k = k_s * s, m = m_s * s;
+	    const double u0 = u_i[l];
+	    const double u1 = u_i[lane_num + l];
+	    const double u2 = u_i[2 * lane_num + l];
+
+	    const double num_y = 2 * (u1 - h * u0 + k * u2) + g_s * s;
+	    const double den_y = 1 + h * h + k * m;
+	    const double y = num_y / den_y;
+	    const double x = 2 * u0 + h * y;
+	    const double z = 2 * u2 - m * y;
+	    const double dy_ds = ((2 * k_s * u2 + g_s) * den_y
+				  - num_y * (k_s * m + k * m_s)) 
+	      / (den_y * den_y);
+
+	    f[l] += h_dt * (c.a[i] * x - c.b[i] * y);
+	    df[l] += h_dt * (c.a[i] * h - c.b[i]) * dy_ds;
+	    ref2[l] += (x - u0) * (x - u0) + (y - u1) * (y - u1) 
+	      + (z - u2) * (z - u2);
+	  }
+	}
+
+	for (int l = 0; l < num; ++l) {
+	  if (!active[l])
+	    continue;
+	  const double delta = -f[l] / df[l];
+	  e[l] += delta;
+	  iterations[l] = it;
+	  if (delta * delta <= rtol2[l] * ref2[l] 
+	      || it == max_newton_iterations) {
+	    active[l] = false;
+	    --remaining;
+	  }
+	}
+      }
 
-      c_out = 2 / hbar * gamma * exp(-t * (1 / t2 - 1 / t1));
+      for (int l = 0; l < num; ++l) {
+	const std::size_t p = batch.p[l];
+	const Coeff& c = *coeff[l];
+	const double s = e[l] + e_old[l];
+	for (std::size_t i = 0; i < width; ++i) {
+	  const double h = h_dt * c.omega[i];
+	  const double k = q_dt * c.c_plus * s, m = q_dt * c.c_minus * s;
+	  const double u0 = u[3 * i * lane_num + l];
+	  const double u1 = u[(3 * i + 1) * lane_num + l];
+	  const double u2 = u[(3 * i + 2) * lane_num + l];
+	  const double y = (2 * (u1 - h * u0 + k * u2) + h_dt * c.d * s)
+	    / (1 + h * h + k * m);
+	  u0_list[p][i] = 2 * u0 + h * y - u0;
+	  u1_list[p][i] = y - u1;
+	  u2_list[p][i] = 2 * u2 - m * y - u2;
+	}
+	*batch.field[l] = e[l];
+	record(w, iterations[l]);
+      }
     }
 
     void
-    d(double t, const Dm2ElectricParam<T>& dm2_param,
-      double& d_out) const
+    save_state(std::size_t p, double* out) const
     {
-      const auto& gamma = dm2_param.gamma;
-      const auto& rho30 = dm2_param.rho30;
-      const auto& t2 = dm2_param.t2;
-      const auto& hbar = dm2_param.hbar;
+      save_cell(u0_list, p, out);
+      save_cell(u1_list, p, out);
+      save_cell(u2_list, p, out);
+    }
 
-      d_out = 2 / hbar * gamma * rho30 * exp(t / t2);
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(u0_list);
+      sizes[1] = cell_state_size(u1_list);
+      sizes[2] = cell_state_size(u2_list);
     }
-    
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(u0_list, p, in, sizes[0]);
+      load_cell(u1_list, p, in, sizes[1]);
+      load_cell(u2_list, p, in, sizes[2]);
+    }
+
   private:
     static const std::string tag; // "Dm2Electric"
   }; // template Dm2Electric
@@ -328,78 +704,48 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      this->prepare_update(dt, n);
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	typename Dm2Electric<T>::Batch batch(dm2_lanes(ex));
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l, batch);
+	}
+	this->flush(batch, dt);
       }
     }
 
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx, 
-	   Dm2ElectricParam<T>& dm2_param)
+	   const Index3& idx, std::size_t p,
+	   typename Dm2Electric<T>::Batch& batch)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const std::vector<double>& omega = dm2_param.omega;
-      const double rtol = dm2_param.rtol;
-      std::vector<std::array<T, 3> >& u = dm2_param.u;
-      
-      const double t = (n + 0.5) * dt;
-      
-      std::vector<double> a, b;
-      double c_plus, c_minus, d;
-
-      this->a(t, dm2_param, a);
-      this->b(t, dm2_param, b);
-      this->c_plus(t, dm2_param, c_plus);
-      this->c_minus(t, dm2_param, c_minus);
-      this->d(t, dm2_param, d);
-      
-      T e_new = ex(i,j,k);
-      std::vector<std::array<T, 3> > u_new = u;
-
       const T e_old = ex(i,j,k);
       const T hy_dz = (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz;
 
-      double error;
-      do {
-        T e_tmp = e_new;
-        std::vector<std::array<T, 3> > u_tmp = u_new;
-        
-	e_new = e_old - dt * hy_dz;
-        for (std::size_t i = 0; i < u.size(); ++i) {
-	  e_new -= .5 * dt * a[i] * (u_new[i][0] + u[i][0]);
-	  e_new += .5 * dt * b[i] * (u_new[i][1] + u[i][1]);
-        }
-
-        for (std::size_t i = 0; i < u.size(); ++i) {
-          u_new[i][0] = u[i][0] 
-            + .5 * dt * omega[i] * (u_new[i][1] + u[i][1]);
-          u_new[i][1] = u[i][1] 
-            - .5 * dt * omega[i] * (u_new[i][0] + u[i][0])
-            + .25 * dt * c_plus * (u_new[i][2] + u[i][2]) * (e_new + e_old) 
-            + .5 * dt * d * (e_new + e_old);
-          u_new[i][2] = u[i][2] 
-            - .25 * dt * c_minus * (u_new[i][1] + u[i][1]) * (e_new + e_old);
-        }
-        
-        error = rel_error(e_new, u_new, e_tmp, u_tmp);
-      } while (error > rtol);
-      
-      ex(i,j,k) = e_new;
-      std::copy(u_new.begin(), u_new.end(), u.begin());
+      this->solve_cell(batch, p, ex(i,j,k), e_old - dt * hy_dz, dt);
     }
     
   protected:
     using Dm2Electric<T>::idx_list;
-    using Dm2Electric<T>::param_list;
   }; // template Dm2Ex
   
 
@@ -413,78 +759,48 @@ namespace gmes
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      this->prepare_update(dt, n);
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	typename Dm2Electric<T>::Batch batch(dm2_lanes(ey));
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l, batch);
+	}
+	this->flush(batch, dt);
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   double dz, double dx, double dt, double n, 
-	   const Index3& idx, 
-	   Dm2ElectricParam<T>& dm2_param)
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
+	   double dz, double dx, double dt, double n,
+	   const Index3& idx, std::size_t p,
+	   typename Dm2Electric<T>::Batch& batch)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const std::vector<double>& omega = dm2_param.omega;
-      const double rtol = dm2_param.rtol;
-      std::vector<std::array<T, 3> >& u = dm2_param.u;
-      
-      const double t = (n + 0.5) * dt;
-      
-      std::vector<double> a, b;
-      double c_plus, c_minus, d;
-
-      this->a(t, dm2_param, a);
-      this->b(t, dm2_param, b);
-      this->c_plus(t, dm2_param, c_plus);
-      this->c_minus(t, dm2_param, c_minus);
-      this->d(t, dm2_param, d);
-      
-      T e_new = ey(i,j,k);
-      std::vector<std::array<T, 3> > u_new = u;
-
       const T e_old = ey(i,j,k);
       const T hz_dx = (hz(i+1,j+1,k) - hz(i,j+1,k)) / dx;
 
-      double error;
-      do {
-        T e_tmp = e_new;
-        std::vector<std::array<T, 3> > u_tmp = u_new;
-        
-	e_new = e_old - dt * hz_dx;
-        for (std::size_t i = 0; i < u.size(); ++i) {
-	  e_new -= .5 * dt * a[i] * (u_new[i][0] + u[i][0]);
-	  e_new += .5 * dt * b[i] * (u_new[i][1] + u[i][1]);
-        }
-
-        for (std::size_t i = 0; i < u.size(); ++i) {
-          u_new[i][0] = u[i][0] 
-            + .5 * dt * omega[i] * (u_new[i][1] + u[i][1]);
-          u_new[i][1] = u[i][1] 
-            - .5 * dt * omega[i] * (u_new[i][0] + u[i][0])
-            + .25 * dt * c_plus * (u_new[i][2] + u[i][2]) * (e_new + e_old) 
-            + .5 * dt * d * (e_new + e_old);
-          u_new[i][2] = u[i][2] 
-            - .25 * dt * c_minus * (u_new[i][1] + u[i][1]) * (e_new + e_old);
-        }
-        
-        error = rel_error(e_new, u_new, e_tmp, u_tmp);
-      } while (error > rtol);
-      
-      ey(i,j,k) = e_new;
-      std::copy(u_new.begin(), u_new.end(), u.begin());
+      this->solve_cell(batch, p, ey(i,j,k), e_old - dt * hz_dx, dt);
     }
 
   protected:
     using Dm2Electric<T>::idx_list;
-    using Dm2Electric<T>::param_list;
   }; // template Dm2Ey
 
 
@@ -498,78 +814,48 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      this->prepare_update(dt, n);
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	typename Dm2Electric<T>::Batch batch(dm2_lanes(ez));
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l, batch);
+	}
+	this->flush(batch, dt);
       }
     }
 
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   double dx, double dy, double dt, double n, 
-	   const Index3& idx, 
-	   Dm2ElectricParam<T>& dm2_param)
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
+	   double dx, double dy, double dt, double n,
+	   const Index3& idx, std::size_t p,
+	   typename Dm2Electric<T>::Batch& batch)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-      const std::vector<double>& omega = dm2_param.omega;
-      const double rtol = dm2_param.rtol;
-      std::vector<std::array<T, 3> >& u = dm2_param.u;
-      
-      const double t = (n + 0.5) * dt;
-      
-      std::vector<double> a, b;
-      double c_plus, c_minus, d;
-
-      this->a(t, dm2_param, a);
-      this->b(t, dm2_param, b);
-      this->c_plus(t, dm2_param, c_plus);
-      this->c_minus(t, dm2_param, c_minus);
-      this->d(t, dm2_param, d);
-      
-      T e_new = ez(i,j,k);
-      std::vector<std::array<T, 3> > u_new = u;
-
       const T e_old = ez(i,j,k);
       const T hx_dy = (hx(i,j+1,k+1) - hx(i,j,k+1)) / dy;
 
-      double error;
-      do {
-        T e_tmp = e_new;
-        std::vector<std::array<T, 3> > u_tmp = u_new;
-        
-	e_new = e_old - dt * hx_dy;
-        for (std::size_t i = 0; i < u.size(); ++i) {
-	  e_new -= .5 * dt * a[i] * (u_new[i][0] + u[i][0]);
-	  e_new += .5 * dt * b[i] * (u_new[i][1] + u[i][1]);
-        }
-
-        for (std::size_t i = 0; i < u.size(); ++i) {
-          u_new[i][0] = u[i][0] 
-            + .5 * dt * omega[i] * (u_new[i][1] + u[i][1]);
-          u_new[i][1] = u[i][1] 
-            - .5 * dt * omega[i] * (u_new[i][0] + u[i][0])
-            + .25 * dt * c_plus * (u_new[i][2] + u[i][2]) * (e_new + e_old) 
-            + .5 * dt * d * (e_new + e_old);
-          u_new[i][2] = u[i][2] 
-            - .25 * dt * c_minus * (u_new[i][1] + u[i][1]) * (e_new + e_old);
-        }
-        
-        error = rel_error(e_new, u_new, e_tmp, u_tmp);
-      } while (error > rtol);
-      
-      ez(i,j,k) = e_new;
-      std::copy(u_new.begin(), u_new.end(), u.begin());
+      this->solve_cell(batch, p, ez(i,j,k), e_old - dt * hx_dy, dt);
     }
 
   protected:
     using Dm2Electric<T>::idx_list;
-    using Dm2Electric<T>::param_list;
   }; // template Dm2Ez
 
 
@@ -595,21 +881,6 @@ namespace gmes
   class Dm2Hy: public DielectricHy<T>
   {
   public:
-    void
-    update_all(T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	       const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	       const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	       double dz, double dx, double dt, double n)
-    {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-      	update(hy, hy_x_size, hy_y_size, hy_z_size,
-	       ex, ex_x_size, ex_y_size, ex_z_size,
-	       ez, ez_x_size, ez_y_size, ez_z_size,
-	       dz, dx, dt, n, *idx, *param);
-      }
-    }
-
     const std::string& 
     name() const
     {
@@ -617,26 +888,7 @@ namespace gmes
     }
 
   private:
-    void 
-    update(T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   double dz, double dx, double dt, double n, 
-	   const Index3& idx, 
-	   const DielectricMagneticParam<T>& dielectric_param) const
-    {
-      const int i = idx[0], j = idx[1], k = idx[2];
-      const double mu_inf = dielectric_param.mu_inf;
-      
-      hy(i,j,k) += dt / mu_inf * ((ez(i,j,k-1) - ez(i-1,j,k-1)) / dx -
-      				  (ex(i-1,j,k) - ex(i-1,j,k-1)) / dz);
-    }
-    
     static const std::string tag; // "Dm2Magnetic"
-
-  protected:
-    using DielectricHy<T>::idx_list;
-    using DielectricHy<T>::param_list;
   }; // template Dm2Hy
 
   template <typename T>
@@ -661,11 +913,4 @@ namespace gmes
   const std::string Dm2Hz<T>::tag = "Dm2Magnetic";
 } // namespace gmes
 
-#undef ex
-#undef ey
-#undef ez
-#undef hx
-#undef hy
-#undef hz
-
 #endif // PW_DM2_HH_
@@ -11,13 +11,6 @@
 #include <vector>
 #include "pw_dielectric.hh"
 
-#define ex(i,j,k) ex[ex_y_size==1?0:((i)*ex_y_size+(j))*ex_z_size+(k)]
-#define ey(i,j,k) ey[ey_z_size==1?0:((i)*ey_y_size+(j))*ey_z_size+(k)]
-#define ez(i,j,k) ez[ez_x_size==1?0:((i)*ez_y_size+(j))*ez_z_size+(k)]
-#define hx(i,j,k) hx[hx_y_size==1?0:((i)*hx_y_size+(j))*hx_z_size+(k)]
-#define hy(i,j,k) hy[hy_z_size==1?0:((i)*hy_y_size+(j))*hy_z_size+(k)]
-#define hz(i,j,k) hz[hz_x_size==1?0:((i)*hz_y_size+(j))*hz_z_size+(k)]
-
 namespace gmes
 {
   template <typename T> 
@@ -43,18 +36,6 @@ namespace gmes
       return DrudeElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const pm_param_ptr)
@@ -65,29 +46,58 @@ namespace gmes
       const auto& drude_param = *static_cast<const DrudeElectricParam<T>*>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(drude_param);
+      eps_inf_list.push_back(drude_param.eps_inf);
+      a0_list.push_back(column(drude_param.a, 0));
+      a1_list.push_back(column(drude_param.a, 1));
+      a2_list.push_back(column(drude_param.a, 2));
+      c0_list.push_back(drude_param.c[0]);
+      c1_list.push_back(drude_param.c[1]);
+      c2_list.push_back(drude_param.c[2]);
+      q_now_list.push_back(drude_param.q_now);
+      q_new_list.push_back(drude_param.q_new);
 
       return this;
     };
 
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(a0_list, cell_num);
+      reserve_more(a1_list, cell_num);
+      reserve_more(a2_list, cell_num);
+      reserve_more(c0_list, cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(q_now_list, cell_num);
+      reserve_more(q_new_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto drude_ptr = static_cast<const DrudeElectric<T>*>(pm_ptr);
       std::copy(drude_ptr->idx_list.begin(), drude_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(drude_ptr->param_list.begin(), drude_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(drude_ptr->eps_inf_list.begin(), drude_ptr->eps_inf_list.end(), std::back_inserter(eps_inf_list));
+      a0_list.append(drude_ptr->a0_list);
+      a1_list.append(drude_ptr->a1_list);
+      a2_list.append(drude_ptr->a2_list);
+      std::copy(drude_ptr->c0_list.begin(), drude_ptr->c0_list.end(), std::back_inserter(c0_list));
+      std::copy(drude_ptr->c1_list.begin(), drude_ptr->c1_list.end(), std::back_inserter(c1_list));
+      std::copy(drude_ptr->c2_list.begin(), drude_ptr->c2_list.end(), std::back_inserter(c2_list));
+      q_now_list.append(drude_ptr->q_now_list);
+      q_new_list.append(drude_ptr->q_new_list);
       return this;
     }
 
     T 
-    dps_sum(const T& init, const DrudeElectricParam<T>& drude_param) const
+    dps_sum(const T& init, std::size_t p) const
     {
-      const auto& a = drude_param.a;
-      const auto& q_now = drude_param.q_now;
-      const auto& q_new = drude_param.q_new;
+      const T* const q_now = q_now_list[p];
+      const T* const q_new = q_new_list[p];
 
       T sum(init);
-      for (typename std::vector<T>::size_type i = 0; i < a.size(); ++i)	{
+      for (std::size_t i = 0; i < q_now_list.width(); ++i) {
 	sum += q_new[i] - q_now[i];
       }
 
@@ -95,23 +105,55 @@ namespace gmes
     }
 
     void 
-    update_q(const T& e_now, DrudeElectricParam<T>& drude_param)
+    update_q(const T& e_now, std::size_t p)
     {
-      const std::vector<std::array<double, 3> >& a = drude_param.a;
-      std::vector<T>& q_now = drude_param.q_now;
-      std::vector<T>& q_new = drude_param.q_new;
-
-      std::vector<T> q_old(q_now);
-      std::copy(q_new.begin(), q_new.end(), q_now.begin());
-      for (typename std::vector<T>::size_type i = 0; i < a.size(); ++i)	{
-	q_new[i] = a[i][0] * q_old[i] + a[i][1] * q_now[i] + a[i][2] * e_now;
+      const double* const a0 = a0_list[p];
+      const double* const a1 = a1_list[p];
+      const double* const a2 = a2_list[p];
+      T* const q_now = q_now_list[p];
+      T* const q_new = q_new_list[p];
+
+      for (std::size_t i = 0; i < q_now_list.width(); ++i) {
+	const T q_old = q_now[i];
+	q_now[i] = q_new[i];
+	q_new[i] = a0[i] * q_old + a1[i] * q_now[i] + a2[i] * e_now;
       }
     }
 
+    int
+    state_arrays() const
+    {
+      return 2;
+    }
+
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<DrudeElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    CellArray<double> a0_list, a1_list, a2_list;
+    CoeffCnt c0_list, c1_list, c2_list;
+    CellArray<T> q_now_list, q_new_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(q_now_list, p, out);
+      save_cell(q_new_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(q_now_list);
+      sizes[1] = cell_state_size(q_new_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(q_now_list, p, in, sizes[0]);
+      load_cell(q_new_list, p, in, sizes[1]);
+    }
 
   private:
     static const std::string tag; // "DrudeElectric"
@@ -130,38 +172,83 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ex, const Field<const T>& hz,
+		 const Field<const T>& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	update_run(ex, hz, hy, dy, dz, dt, n, idx_list.run(r));
       }
     }
 
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   double dy, double dz, double dt, double n, 
-	   const Index3& idx, 
-	   DrudeElectricParam<T>& drude_param)
+    void
+    update_run(const Field<T>& ex, const Field<const T>& hz,
+	       const Field<const T>& hy,
+	       double dy, double dz, double dt, double n,
+	       const Run& run)
     {
-      const int i = idx[0], j = idx[1], k = idx[2];
+      const int i = run.i, j = run.j, k = run.k0;
+      T* const ex_00 = &ex(i,j,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_p0 = &hz(i+1,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const T& e_now = ex_00[l];
+	update_q(e_now, p);
+	ex_00[l] = c0_list[p] * ((hz_pp[l] - hz_p0[l]) / dy -
+				 (hy_p0[l + 1] - hy_p0[l]) / dz)
+	  + c1_list[p] * dps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
+      }
+    }
 
-      const auto& c = drude_param.c;
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
+	   double dy, double dz, double dt, double n,
+	   const Index3& idx, std::size_t p)
+    {
+      const int i = idx[0], j = idx[1], k = idx[2];
       
       const T& e_now = ex(i,j,k);
-      update_q(e_now, drude_param);
-      ex(i,j,k) = c[0] * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
-			  (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz)
-	+ c[1] * dps_sum(static_cast<T>(0), drude_param) + c[2] * e_now;
+      update_q(e_now, p);
+      ex(i,j,k) = c0_list[p] * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
+				(hy(i+1,j,k+1) - hy(i+1,j,k)) / dz)
+	+ c1_list[p] * dps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
     }
 
   protected:
     using DrudeElectric<T>::idx_list;
-    using DrudeElectric<T>::param_list;
+    using DrudeElectric<T>::c0_list;
+    using DrudeElectric<T>::c1_list;
+    using DrudeElectric<T>::c2_list;
     using DrudeElectric<T>::update_q;
     using DrudeElectric<T>::dps_sum;
   }; // template DrudeEx
@@ -176,38 +263,83 @@ namespace gmes
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ey, const Field<const T>& hx,
+		 const Field<const T>& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	update_run(ey, hx, hz, dz, dx, dt, n, idx_list.run(r));
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+    void
+    update_run(const Field<T>& ey, const Field<const T>& hx,
+	       const Field<const T>& hz,
+	       double dz, double dx, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      T* const ey_00 = &ey(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_0p = &hz(i,j+1,k);
+
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const T& e_now = ey_00[l];
+	update_q(e_now, p);
+	ey_00[l] = c0_list[p] * ((hx_0p[l + 1] - hx_0p[l]) / dz -
+				 (hz_pp[l] - hz_0p[l]) / dx)
+	  + c1_list[p] * dps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
+      }
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx, 
-	   DrudeElectricParam<T>& drude_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-
-      const auto& c = drude_param.c;
       
       const T& e_now = ey(i,j,k);
-      update_q(e_now, drude_param);
-      ey(i,j,k) = c[0] * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
-			  (hz(i+1,j+1,k) - hz(i,j+1,k)) / dx)
-	+ c[1] * dps_sum(static_cast<T>(0), drude_param) + c[2] * e_now;
+      update_q(e_now, p);
+      ey(i,j,k) = c0_list[p] * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
+				(hz(i+1,j+1,k) - hz(i,j+1,k)) / dx)
+	+ c1_list[p] * dps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
     }
 
   protected:
     using DrudeElectric<T>::idx_list;
-    using DrudeElectric<T>::param_list;
+    using DrudeElectric<T>::c0_list;
+    using DrudeElectric<T>::c1_list;
+    using DrudeElectric<T>::c2_list;
     using DrudeElectric<T>::update_q;
     using DrudeElectric<T>::dps_sum;
   }; // template DrudeEy
@@ -221,38 +353,84 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ez, const Field<const T>& hy,
+		 const Field<const T>& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	update_run(ez, hy, hx, dx, dy, dt, n, idx_list.run(r));
       }
     }
 
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+    void
+    update_run(const Field<T>& ez, const Field<const T>& hy,
+	       const Field<const T>& hx,
+	       double dx, double dy, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      T* const ez_00 = &ez(i,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+      const T* const hy_00 = &hy(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hx_00 = &hx(i,j,k);
+
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const T& e_now = ez_00[l];
+	update_q(e_now, p);
+	ez_00[l] = c0_list[p] * ((hy_p0[l + 1] - hy_00[l + 1]) / dx -
+				 (hx_0p[l + 1] - hx_00[l + 1]) / dy)
+	  + c1_list[p] * dps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
+      }
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx, 
-	   DrudeElectricParam<T>& drude_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-
-      const auto& c = drude_param.c;
       
       const T& e_now = ez(i,j,k);
-      update_q(e_now, drude_param);
-      ez(i,j,k) = c[0] * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
-			  (hx(i,j+1,k+1) - hx(i,j,k+1)) / dy)
-	+ c[1] * dps_sum(static_cast<T>(0), drude_param) + c[2] * e_now;
+      update_q(e_now, p);
+      ez(i,j,k) = c0_list[p] * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
+				(hx(i,j+1,k+1) - hx(i,j,k+1)) / dy)
+	+ c1_list[p] * dps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
     }
 
   protected:
     using DrudeElectric<T>::idx_list;
-    using DrudeElectric<T>::param_list;
+    using DrudeElectric<T>::c0_list;
+    using DrudeElectric<T>::c1_list;
+    using DrudeElectric<T>::c2_list;
     using DrudeElectric<T>::update_q;
     using DrudeElectric<T>::dps_sum;
   }; // template DrudeEz
@@ -310,11 +488,4 @@ namespace gmes
 
 } // namespace gmes
 
-#undef ex
-#undef ey
-#undef ez
-#undef hx
-#undef hy
-#undef hz
-
 #endif // PW_DRUDE_HH_
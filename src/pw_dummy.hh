@@ -25,18 +25,6 @@ namespace gmes
       return DummyElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const pm_param_ptr)
@@ -47,7 +35,7 @@ namespace gmes
       const auto& dummy_param = *static_cast<const DummyElectricParam<T>*>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(dummy_param);
+      eps_inf_list.push_back(dummy_param.eps_inf);
 
       return this;
     }
@@ -57,7 +45,7 @@ namespace gmes
     {
       auto dummy_ptr = static_cast<const DummyElectric<T>*>(pm_ptr);
       std::copy(dummy_ptr->idx_list.begin(), dummy_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(dummy_ptr->param_list.begin(), dummy_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(dummy_ptr->eps_inf_list.begin(), dummy_ptr->eps_inf_list.end(), std::back_inserter(eps_inf_list));
       return this;
     }
 
@@ -76,7 +64,7 @@ namespace gmes
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<DummyElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
 
   private:
     static const std::string tag; // "DrudeElectric"
@@ -107,18 +95,6 @@ namespace gmes
       return DummyMagnetic<T>::tag;
     }
     
-    double
-    get_mu_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].mu_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const pm_param_ptr)
@@ -129,7 +105,7 @@ namespace gmes
       const auto& dummy_param = *static_cast<const DummyMagneticParam<T>*>(pm_param_ptr);
       
       idx_list.push_back(index);
-      param_list.push_back(dummy_param);
+      mu_inf_list.push_back(dummy_param.mu_inf);
       
       return this;
     }
@@ -139,7 +115,7 @@ namespace gmes
     {
       auto dummy_ptr = static_cast<const DummyMagnetic<T>*>(pm_ptr);
       std::copy(dummy_ptr->idx_list.begin(), dummy_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(dummy_ptr->param_list.begin(), dummy_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(dummy_ptr->mu_inf_list.begin(), dummy_ptr->mu_inf_list.end(), std::back_inserter(mu_inf_list));
       return this;
     }
  
@@ -158,7 +134,7 @@ namespace gmes
   protected:
     using MaterialMagnetic<T>::position;
     using MaterialMagnetic<T>::idx_list;
-    std::vector<DummyMagneticParam<T> > param_list;
+    using MaterialMagnetic<T>::mu_inf_list;
 
   private:
     static const std::string tag; // "DummyMagnetic"
@@ -0,0 +1,100 @@
+#ifndef PW_HALO_HH_
+#define PW_HALO_HH_
+
+#include <stdexcept>
+
+namespace gmes
+{
+  // Halo plane of a field component across a boundary along the
+  // axis. The boundary plane from is packed into a contiguous buffer
+  // to send to the neighbor, and the buffer received from the other
+  // neighbor is unpacked onto the halo plane to, multiplied by the
+  // Bloch phase of the period. The phase is fixed when the halo is
+  // made, so the exchange of each time step only moves the fields.
+  template <typename T>
+  class Halo
+  {
+  public:
+    Halo(int axis, int from, int to, T phase):
+      axis(axis), from(from), to(to), phase(phase)
+    {
+    }
+
+    // Copy the plane from of the field into buf, which holds the
+    // plane in the row-major order of the two other axes. Throw
+    // std::length_error unless buf is exactly the size of the plane.
+    void
+    pack(const T* const halo_field,
+	 int halo_x_size, int halo_y_size, int halo_z_size,
+	 T* const buf, int buf_size) const
+    {
+      const Plane p = plane(halo_x_size, halo_y_size, halo_z_size);
+      check(p, buf_size);
+      const T* const f = halo_field + from * p.stride;
+      for (int i = 0; i < p.u_size; ++i)
+	for (int j = 0; j < p.v_size; ++j)
+	  buf[i * p.v_size + j] = f[i * p.u_stride + j * p.v_stride];
+    }
+
+    // Set the plane to of the field to the phase times buf, which
+    // must be exactly the size of the plane as in pack().
+    void
+    unpack(T* const halo_field,
+	   int halo_x_size, int halo_y_size, int halo_z_size,
+	   const T* const buf, int buf_size) const
+    {
+      const Plane p = plane(halo_x_size, halo_y_size, halo_z_size);
+      check(p, buf_size);
+      T* const f = halo_field + to * p.stride;
+      for (int i = 0; i < p.u_size; ++i)
+	for (int j = 0; j < p.v_size; ++j)
+	  f[i * p.u_stride + j * p.v_stride] = phase * buf[i * p.v_size + j];
+    }
+
+    // Set the plane to of the field to the phase times the plane
+    // from, i.e. the exchange with itself across a periodic boundary.
+    void
+    wrap(T* const halo_field,
+	 int halo_x_size, int halo_y_size, int halo_z_size) const
+    {
+      const Plane p = plane(halo_x_size, halo_y_size, halo_z_size);
+      const T* const src = halo_field + from * p.stride;
+      T* const dest = halo_field + to * p.stride;
+      for (int i = 0; i < p.u_size; ++i)
+	for (int j = 0; j < p.v_size; ++j) {
+	  const int offset = i * p.u_stride + j * p.v_stride;
+	  dest[offset] = phase * src[offset];
+	}
+    }
+
+  private:
+    // Sizes and strides of the two other axes in ascending order, and
+    // the stride of the axis.
+    struct Plane
+    {
+      int stride, u_size, u_stride, v_size, v_stride;
+    };
+
+    Plane
+    plane(int x_size, int y_size, int z_size) const
+    {
+      const int size[3] = {x_size, y_size, z_size};
+      const int stride[3] = {y_size * z_size, z_size, 1};
+      const int u = axis == 0 ? 1 : 0, v = axis == 2 ? 1 : 2;
+      const Plane p = {stride[axis], size[u], stride[u], size[v], stride[v]};
+      return p;
+    }
+
+    void
+    check(const Plane& p, int buf_size) const
+    {
+      if (buf_size != p.u_size * p.v_size)
+	throw std::length_error("buf_size should be the size of the halo plane");
+    }
+
+    int axis, from, to;
+    T phase;
+  }; // template Halo
+} // namespace gmes
+
+#endif // PW_HALO_HH_
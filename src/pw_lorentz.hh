@@ -12,13 +12,6 @@
 #include <vector>
 #include "pw_dielectric.hh"
 
-#define ex(i,j,k) ex[ex_y_size==1?0:((i)*ex_y_size+(j))*ex_z_size+(k)]
-#define ey(i,j,k) ey[ey_z_size==1?0:((i)*ey_y_size+(j))*ey_z_size+(k)]
-#define ez(i,j,k) ez[ez_x_size==1?0:((i)*ez_y_size+(j))*ez_z_size+(k)]
-#define hx(i,j,k) hx[hx_y_size==1?0:((i)*hx_y_size+(j))*hx_z_size+(k)]
-#define hy(i,j,k) hy[hy_z_size==1?0:((i)*hy_y_size+(j))*hy_z_size+(k)]
-#define hz(i,j,k) hz[hz_x_size==1?0:((i)*hz_y_size+(j))*hz_z_size+(k)]
-
 namespace gmes
 {
   template <typename T> 
@@ -44,18 +37,6 @@ namespace gmes
       return LorentzElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const pm_param_ptr)
@@ -66,11 +47,33 @@ namespace gmes
       const auto& lorentz_param = *static_cast<const LorentzElectricParam<T> * const>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(lorentz_param);
+      eps_inf_list.push_back(lorentz_param.eps_inf);
+      a0_list.push_back(column(lorentz_param.a, 0));
+      a1_list.push_back(column(lorentz_param.a, 1));
+      a2_list.push_back(column(lorentz_param.a, 2));
+      c0_list.push_back(lorentz_param.c[0]);
+      c1_list.push_back(lorentz_param.c[1]);
+      c2_list.push_back(lorentz_param.c[2]);
+      l_now_list.push_back(lorentz_param.l_now);
+      l_new_list.push_back(lorentz_param.l_new);
 
       return this;
     };
 
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(a0_list, cell_num);
+      reserve_more(a1_list, cell_num);
+      reserve_more(a2_list, cell_num);
+      reserve_more(c0_list, cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(l_now_list, cell_num);
+      reserve_more(l_new_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
@@ -79,21 +82,34 @@ namespace gmes
       std::copy(lorentz_ptr->idx_list.begin(), 
 		lorentz_ptr->idx_list.end(), 
 		std::back_inserter(idx_list));
-      std::copy(lorentz_ptr->param_list.begin(), 
-		lorentz_ptr->param_list.end(), 
-		std::back_inserter(param_list));
+      std::copy(lorentz_ptr->eps_inf_list.begin(), 
+		lorentz_ptr->eps_inf_list.end(), 
+		std::back_inserter(eps_inf_list));
+      a0_list.append(lorentz_ptr->a0_list);
+      a1_list.append(lorentz_ptr->a1_list);
+      a2_list.append(lorentz_ptr->a2_list);
+      std::copy(lorentz_ptr->c0_list.begin(), 
+		lorentz_ptr->c0_list.end(), 
+		std::back_inserter(c0_list));
+      std::copy(lorentz_ptr->c1_list.begin(), 
+		lorentz_ptr->c1_list.end(), 
+		std::back_inserter(c1_list));
+      std::copy(lorentz_ptr->c2_list.begin(), 
+		lorentz_ptr->c2_list.end(), 
+		std::back_inserter(c2_list));
+      l_now_list.append(lorentz_ptr->l_now_list);
+      l_new_list.append(lorentz_ptr->l_new_list);
       return this;
     }
 
     T 
-    lps_sum(const T& init, const LorentzElectricParam<T>& lorentz_param) const
+    lps_sum(const T& init, std::size_t p) const
     {
-      const auto& a = lorentz_param.a;
-      const auto& l_now = lorentz_param.l_now;
-      const auto& l_new = lorentz_param.l_new;
+      const T* const l_now = l_now_list[p];
+      const T* const l_new = l_new_list[p];
       
       T sum(init);
-      for (typename std::vector<T>::size_type i = 0; i < a.size(); ++i)	{
+      for (std::size_t i = 0; i < l_now_list.width(); ++i) {
 	sum += l_new[i] - l_now[i];
       }
 
@@ -101,23 +117,55 @@ namespace gmes
     }
 
     void 
-    update_l(const T& e_now, LorentzElectricParam<T>& lorentz_param)
+    update_l(const T& e_now, std::size_t p)
     {
-      const auto& a = lorentz_param.a;
-      auto& l_now = lorentz_param.l_now;
-      auto& l_new = lorentz_param.l_new;
-
-      const auto l_old = l_now;
-      std::copy(l_new.begin(), l_new.end(), l_now.begin());
-      for (typename std::vector<T>::size_type i = 0; i < a.size(); ++i)	{
-	l_new[i] = a[i][0] * l_old[i] + a[i][1] * l_now[i] + a[i][2] * e_now;
+      const double* const a0 = a0_list[p];
+      const double* const a1 = a1_list[p];
+      const double* const a2 = a2_list[p];
+      T* const l_now = l_now_list[p];
+      T* const l_new = l_new_list[p];
+
+      for (std::size_t i = 0; i < l_now_list.width(); ++i) {
+	const T l_old = l_now[i];
+	l_now[i] = l_new[i];
+	l_new[i] = a0[i] * l_old + a1[i] * l_now[i] + a2[i] * e_now;
       }
     }
 
+    int
+    state_arrays() const
+    {
+      return 2;
+    }
+
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<LorentzElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    CellArray<double> a0_list, a1_list, a2_list;
+    CoeffCnt c0_list, c1_list, c2_list;
+    CellArray<T> l_now_list, l_new_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(l_now_list, p, out);
+      save_cell(l_new_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(l_now_list);
+      sizes[1] = cell_state_size(l_new_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(l_now_list, p, in, sizes[0]);
+      load_cell(l_new_list, p, in, sizes[1]);
+    }
 
   private:
     static const std::string tag; // "LorentzElectric"
@@ -136,38 +184,49 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx, 
-	   LorentzElectricParam<T>& lorentz_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
 
-      const auto& c = lorentz_param.c;
-
       const T& e_now = ex(i,j,k);
-      update_l(e_now, lorentz_param);
-      ex(i,j,k) = c[0] * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
-			  (hy(i+1,j,k+1) - hy(i+1,j,k)) / dz)
-	+ c[1] * lps_sum(static_cast<T>(0), lorentz_param) + c[2] * e_now;
+      update_l(e_now, p);
+      ex(i,j,k) = c0_list[p] * ((hz(i+1,j+1,k) - hz(i+1,j,k)) / dy - 
+				(hy(i+1,j,k+1) - hy(i+1,j,k)) / dz)
+	+ c1_list[p] * lps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
     }
 
   protected:
     using LorentzElectric<T>::idx_list;
-    using LorentzElectric<T>::param_list;
+    using LorentzElectric<T>::c0_list;
+    using LorentzElectric<T>::c1_list;
+    using LorentzElectric<T>::c2_list;
     using LorentzElectric<T>::update_l;
     using LorentzElectric<T>::lps_sum;
   }; // template LorentzEx
@@ -182,38 +241,49 @@ namespace gmes
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx, 
-	   LorentzElectricParam<T>& lorentz_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-
-      const auto& c = lorentz_param.c;
       
       const T& e_now = ey(i,j,k);
-      update_l(e_now, lorentz_param);
-      ey(i,j,k) = c[0] * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
-			  (hz(i+1,j+1,k) - hz(i,j+1,k)) / dx)
-	+ c[1] * lps_sum(static_cast<T>(0), lorentz_param) + c[2] * e_now;
+      update_l(e_now, p);
+      ey(i,j,k) = c0_list[p] * ((hx(i,j+1,k+1) - hx(i,j+1,k)) / dz - 
+				(hz(i+1,j+1,k) - hz(i,j+1,k)) / dx)
+	+ c1_list[p] * lps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
     }
     
   protected:
     using LorentzElectric<T>::idx_list;
-    using LorentzElectric<T>::param_list;
+    using LorentzElectric<T>::c0_list;
+    using LorentzElectric<T>::c1_list;
+    using LorentzElectric<T>::c2_list;
     using LorentzElectric<T>::update_l;
     using LorentzElectric<T>::lps_sum;
   }; // template LorentzEy
@@ -228,38 +298,49 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l);
+	}
       }
     }
 
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx, 
-	   LorentzElectricParam<T>& lorentz_param)
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
-
-      const auto& c = lorentz_param.c;
       
       const T& e_now = ez(i,j,k);
-      update_l(e_now, lorentz_param);
-      ez(i,j,k) = c[0] * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
-			  (hx(i,j+1,k+1) - hx(i,j,k+1)) / dy)
-	+ c[1] * lps_sum(static_cast<T>(0), lorentz_param) + c[2] * e_now;
+      update_l(e_now, p);
+      ez(i,j,k) = c0_list[p] * ((hy(i+1,j,k+1) - hy(i,j,k+1)) / dx - 
+				(hx(i,j+1,k+1) - hx(i,j,k+1)) / dy)
+	+ c1_list[p] * lps_sum(static_cast<T>(0), p) + c2_list[p] * e_now;
     }
 
   protected:
     using LorentzElectric<T>::idx_list;
-    using LorentzElectric<T>::param_list;
+    using LorentzElectric<T>::c0_list;
+    using LorentzElectric<T>::c1_list;
+    using LorentzElectric<T>::c2_list;
     using LorentzElectric<T>::update_l;
     using LorentzElectric<T>::lps_sum;
   }; // template LorentzEz
@@ -316,11 +397,4 @@ namespace gmes
   const std::string LorentzHz<T>::tag = "LorentzMagnetic";
 } // namespace gmes
 
-#undef ex
-#undef ey
-#undef ez
-#undef hx
-#undef hy
-#undef hz
-
 #endif // PW_LORENTZ_HH_
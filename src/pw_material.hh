@@ -3,10 +3,20 @@
 
 #include <algorithm>
 #include <array>
+#include <complex>
 #include <iterator>
+#include <numeric>
 #include <functional>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
+#include "simd.hh"
+#include "storage.hh"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace gmes 
 {
@@ -27,12 +37,270 @@ namespace gmes
   }; // template MagneticParam
 
   typedef std::array<int, 3> Index3;
-  typedef std::vector<Index3> IdxCnt;
+  typedef RunList IdxCnt;
+
+  // Arithmetic of the single precision complex fields with the double
+  // coefficients, which std::complex does not mix. The result keeps
+  // the precision of the field.
+  inline std::complex<float>
+  operator*(double a, const std::complex<float>& b)
+  {
+    return static_cast<float>(a) * b;
+  }
+
+  inline std::complex<float>
+  operator*(const std::complex<float>& a, double b)
+  {
+    return a * static_cast<float>(b);
+  }
+
+  inline std::complex<float>
+  operator/(const std::complex<float>& a, double b)
+  {
+    return a / static_cast<float>(b);
+  }
+
+  inline std::complex<float>
+  operator+(const std::complex<float>& a, double b)
+  {
+    return a + static_cast<float>(b);
+  }
+
+  inline std::complex<float>
+  operator-(const std::complex<float>& a, double b)
+  {
+    return a - static_cast<float>(b);
+  }
+
+  // Array of a field component of (x_size, y_size, z_size).
+  template <typename T>
+  struct FieldArray
+  {
+    T* f;
+    int x_size, y_size, z_size;
+  }; // template FieldArray
+
+  // Accessor of a field array of (x_size, y_size, z_size).
+  template <typename T>
+  class Field
+  {
+  public:
+    Field(T* const f, int y_size, int z_size):
+      f(f), y_size(y_size), z_size(z_size)
+    {
+    }
+
+    T&
+    operator()(int i, int j, int k) const
+    {
+      return f[(i * y_size + j) * z_size + k];
+    }
+
+  private:
+    T* const f;
+    const int y_size, z_size;
+  }; // template Field
+
+  // Accessor of a placeholder array of one element, which the FDTD
+  // classes of lower dimension pass for the components they do not
+  // update. Every cell reads the element.
+  template <typename T>
+  class Placeholder
+  {
+  public:
+    Placeholder(T* const f, int, int):
+      f(f)
+    {
+    }
+
+    T&
+    operator()(int, int, int) const
+    {
+      return *f;
+    }
+
+  private:
+    T* const f;
+  }; // template Placeholder
+
+  // Number of threads sharing the cells of a material update. Without
+  // OpenMP the updates run serially and the number stays 1.
+  inline void
+  set_num_threads(int num)
+  {
+#ifdef _OPENMP
+    if (num > 0)
+      omp_set_num_threads(num);
+#endif
+  }
+
+  inline int
+  get_num_threads()
+  {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  // Index of the calling thread among those of get_num_threads.
+  inline int
+  get_thread_num()
+  {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+  }
+
+  // Whether to split the cells of a material among the threads.
+  // Every cell writes only its own field entry and auxiliary values,
+  // so the result does not depend on the split. The cells writing to
+  // a placeholder share its element and stay serial, and so do
+  // materials too small to pay for the threads.
+  template <typename T>
+  bool
+  threaded(const Field<T>&, std::size_t cell_num)
+  {
+    return cell_num >= 1024;
+  }
+
+  template <typename T>
+  bool
+  threaded(const Placeholder<T>&, std::size_t)
+  {
+    return false;
+  }
+
+  // Call m.update_cells(f0, f1, f2, d1, d2, dt, n) with each field
+  // wrapped in a Placeholder accessor if its flag is set, or in a
+  // Field accessor otherwise. The shape is chosen once per sweep, so
+  // each instantiation of the cell loop indexes without branches. A
+  // material may overload update_cells() for the case without
+  // placeholder fields, in which its cells are updated run by run
+  // through update_runs().
+  template <class M, class A0, class A1, typename T>
+  void
+  update_fields(M& m, const A0& f0, const A1& f1,
+		const T* const f2, bool f2_placeholder, int f2_y_size, int f2_z_size,
+		double d1, double d2, double dt, double n)
+  {
+    if (f2_placeholder)
+      m.update_cells(f0, f1, Placeholder<const T>(f2, f2_y_size, f2_z_size),
+		     d1, d2, dt, n);
+    else
+      m.update_cells(f0, f1, Field<const T>(f2, f2_y_size, f2_z_size),
+		     d1, d2, dt, n);
+  }
+
+  template <class M, class A0, typename T>
+  void
+  update_fields(M& m, const A0& f0,
+		const T* const f1, bool f1_placeholder, int f1_y_size, int f1_z_size,
+		const T* const f2, bool f2_placeholder, int f2_y_size, int f2_z_size,
+		double d1, double d2, double dt, double n)
+  {
+    if (f1_placeholder)
+      update_fields(m, f0, Placeholder<const T>(f1, f1_y_size, f1_z_size),
+		    f2, f2_placeholder, f2_y_size, f2_z_size, d1, d2, dt, n);
+    else
+      update_fields(m, f0, Field<const T>(f1, f1_y_size, f1_z_size),
+		    f2, f2_placeholder, f2_y_size, f2_z_size, d1, d2, dt, n);
+  }
+
+  template <class M, typename T>
+  void
+  update_fields(M& m,
+		T* const f0, bool f0_placeholder, int f0_y_size, int f0_z_size,
+		const T* const f1, bool f1_placeholder, int f1_y_size, int f1_z_size,
+		const T* const f2, bool f2_placeholder, int f2_y_size, int f2_z_size,
+		double d1, double d2, double dt, double n)
+  {
+    if (f0_placeholder)
+      update_fields(m, Placeholder<T>(f0, f0_y_size, f0_z_size),
+		    f1, f1_placeholder, f1_y_size, f1_z_size,
+		    f2, f2_placeholder, f2_y_size, f2_z_size, d1, d2, dt, n);
+    else
+      update_fields(m, Field<T>(f0, f0_y_size, f0_z_size),
+		    f1, f1_placeholder, f1_y_size, f1_z_size,
+		    f2, f2_placeholder, f2_y_size, f2_z_size, d1, d2, dt, n);
+  }
+
+  // Update every run of run_list with m.update_run(), the kernel of
+  // m for the cells of a run, which is inlined into a loop compiled
+  // for each instruction set. The inner loops of the kernels are thus
+  // vectorized with the widest set of the CPU. run_list is the
+  // idx_list of m or any other list of runs with size(), run_size()
+  // and run(), such as a CoeffGrid.
+  template <class M, class L, class A0, class A1, class A2>
+  GMES_TARGET_AVX512 void
+  update_runs_avx512(M& m, const L& run_list,
+		     const A0& f0, const A1& f1, const A2& f2,
+		     double d1, double d2, double dt, double n)
+  {
+    const std::size_t run_num = run_list.run_size();
+#pragma omp parallel for if (threaded(f0, run_list.size()))
+    for (std::size_t r = 0; r < run_num; ++r) {
+      m.update_run(f0, f1, f2, d1, d2, dt, n, run_list.run(r));
+    }
+  }
+
+  template <class M, class L, class A0, class A1, class A2>
+  GMES_TARGET_AVX2 void
+  update_runs_avx2(M& m, const L& run_list,
+		   const A0& f0, const A1& f1, const A2& f2,
+		   double d1, double d2, double dt, double n)
+  {
+    const std::size_t run_num = run_list.run_size();
+#pragma omp parallel for if (threaded(f0, run_list.size()))
+    for (std::size_t r = 0; r < run_num; ++r) {
+      m.update_run(f0, f1, f2, d1, d2, dt, n, run_list.run(r));
+    }
+  }
+
+  template <class M, class L, class A0, class A1, class A2>
+  void
+  update_runs_generic(M& m, const L& run_list,
+		      const A0& f0, const A1& f1, const A2& f2,
+		      double d1, double d2, double dt, double n)
+  {
+    const std::size_t run_num = run_list.run_size();
+#pragma omp parallel for if (threaded(f0, run_list.size()))
+    for (std::size_t r = 0; r < run_num; ++r) {
+      m.update_run(f0, f1, f2, d1, d2, dt, n, run_list.run(r));
+    }
+  }
+
+  template <class M, class L, class A0, class A1, class A2>
+  void
+  update_runs(M& m, const L& run_list,
+	      const A0& f0, const A1& f1, const A2& f2,
+	      double d1, double d2, double dt, double n)
+  {
+    switch (simd_level())
+      {
+      case SIMD_AVX512:
+	update_runs_avx512(m, run_list, f0, f1, f2, d1, d2, dt, n);
+	break;
+      case SIMD_AVX2:
+	update_runs_avx2(m, run_list, f0, f1, f2, d1, d2, dt, n);
+	break;
+      default:
+	update_runs_generic(m, run_list, f0, f1, f2, d1, d2, dt, n);
+      }
+  }
 
   template <typename T> 
   class PwMaterial 
   {
   public:
+    PwMaterial():
+      bound0(), bound1(), bound2(), bound_d1(0), bound_d2(0), bound_dt(0)
+    {
+    }
+
     virtual
     ~PwMaterial() {}
 
@@ -43,6 +311,28 @@ namespace gmes
     attach(const int* const idx, int idx_size,
 	   const PwMaterialParam* const parameter) = 0;
     
+    // Attach every row of indices with the same parameter.
+    PwMaterial<T>*
+    attach_many(const int* const indices, int indices_size1, int indices_size2,
+		const PwMaterialParam* const parameter)
+    {
+      for (int n = 0; n < indices_size1; ++n) {
+	attach(indices + n * indices_size2, indices_size2, parameter);
+	// The first cell fixes the number of values per cell.
+	if (n == 0)
+	  reserve(indices_size1 - 1);
+      }
+
+      return this;
+    }
+
+    // Make room for cell_num more cells. The cell indices are kept
+    // as runs, whose number is not known in advance.
+    virtual void
+    reserve(std::size_t)
+    {
+    }
+
     virtual void
     update_all(T* const inplace_field,
 	       int inplace_dim1, int inplace_dim2, int inplace_dim3,
@@ -51,12 +341,170 @@ namespace gmes
 	       const T* const in_field2, 
 	       int in2_dim1, int in2_dim2, int in2_dim3,
 	       double d1, double d2, double dt, double n) = 0;
+
+    // Keep the arguments of update_all() but n, so that update_bound()
+    // runs it without converting the field arrays on every call. The
+    // arrays must outlive the binding.
+    void
+    bind(T* const bound_field,
+	 int bound_dim1, int bound_dim2, int bound_dim3,
+	 const T* const bound_field1,
+	 int bound1_dim1, int bound1_dim2, int bound1_dim3,
+	 const T* const bound_field2,
+	 int bound2_dim1, int bound2_dim2, int bound2_dim3,
+	 double d1, double d2, double dt)
+    {
+      const FieldArray<T> f0 =
+	{bound_field, bound_dim1, bound_dim2, bound_dim3};
+      const FieldArray<const T> f1 =
+	{bound_field1, bound1_dim1, bound1_dim2, bound1_dim3};
+      const FieldArray<const T> f2 =
+	{bound_field2, bound2_dim1, bound2_dim2, bound2_dim3};
+      bound0 = f0;
+      bound1 = f1;
+      bound2 = f2;
+      bound_d1 = d1;
+      bound_d2 = d2;
+      bound_dt = dt;
+    }
+
+    // Run update_all() on the arrays of the last bind().
+    void
+    update_bound(double n)
+    {
+      update_all(bound0.f, bound0.x_size, bound0.y_size, bound0.z_size,
+		 bound1.f, bound1.x_size, bound1.y_size, bound1.z_size,
+		 bound2.f, bound2.x_size, bound2.y_size, bound2.z_size,
+		 bound_d1, bound_d2, bound_dt, n);
+    }
+
+    // Split the cells into the interior, the cells in the box [lo, hi)
+    // whose update reads no halo plane, and the boundary shell. The
+    // interior can then be updated while the halo planes are on the
+    // way, and the shell once they have arrived.
+    void
+    split(const int* const lo, int lo_size, const int* const hi, int hi_size)
+    {
+      Index3 lo_idx, hi_idx;
+      std::copy(lo, lo + lo_size, lo_idx.begin());
+      std::copy(hi, hi + hi_size, hi_idx.begin());
+      idx_list.split(lo_idx, hi_idx);
+    }
+
+    // Run update_bound() on the interior or the shell cells only.
+    void
+    update_interior(double n)
+    {
+      update_part(RUN_INTERIOR, n);
+    }
+
+    void
+    update_shell(double n)
+    {
+      update_part(RUN_SHELL, n);
+    }
+
+    // Copy the cell indices into the rows of cell_indices, in the
+    // attach order.
+    void
+    get_indices(int* const cell_indices,
+		int cell_indices_size1, int cell_indices_size2) const
+    {
+      int n = 0;
+      for (auto it = idx_list.begin();
+	   it != idx_list.end() && n < cell_indices_size1; ++it, ++n)
+	std::copy(it->begin(), it->begin() + cell_indices_size2,
+		  cell_indices + n * cell_indices_size2);
+    }
+
+    // Number of the per-cell arrays of the state, e.g. the auxiliary
+    // fields of a dispersive material or a PML. get_state() and
+    // set_state() move the state along with the cells between nodes.
+    virtual int
+    state_arrays() const
+    {
+      return 0;
+    }
+
+    // Number of doubles of the per-cell state.
+    int
+    state_size() const
+    {
+      std::vector<int> sizes(state_arrays());
+      state_sizes(sizes.data());
+      return std::accumulate(sizes.begin(), sizes.end(), 0);
+    }
+
+    // Number of doubles of each per-cell array of the state. The
+    // arrays of the merged materials differ in width, so the state
+    // goes to another node with its sizes.
+    void
+    get_state_sizes(int* const sizes, int sizes_size) const
+    {
+      if (sizes_size != state_arrays())
+	throw std::length_error("sizes_size should be state_arrays()");
+
+      state_sizes(sizes);
+    }
+
+    // Copy the state of the cells at the rows of indices into the rows
+    // of state. The rows of the cells not in this material are left
+    // as they are.
+    void
+    get_state(const int* const indices, int indices_size1, int indices_size2,
+	      double* const state, int state_size1, int state_size2) const
+    {
+      if (state_size2 != state_size())
+	throw std::length_error("state_size2 should be state_size()");
+
+      Index3 index;
+      index.fill(0);
+      const int width = std::min(indices_size2, static_cast<int>(index.size()));
+      const int num = std::min(indices_size1, state_size1);
+      for (int n = 0; n < num; ++n) {
+	std::copy(indices + n * indices_size2,
+		  indices + n * indices_size2 + width, index.begin());
+	const int p = position(index);
+	if (p >= 0)
+	  save_state(p, state + n * state_size2);
+      }
+    }
+
+    // Set the state of the cells at the rows of indices to the rows of
+    // state, of the array sizes given by get_state_sizes() of the 
+    // sender. An array of a different width is cut or padded with 
+    // zeros. The cells not in this material are skipped.
+    void
+    set_state(const int* const indices, int indices_size1, int indices_size2,
+	      const double* const state, int state_size1, int state_size2,
+	      const int* const sizes, int sizes_size)
+    {
+      if (sizes_size != state_arrays())
+	throw std::length_error("sizes_size should be state_arrays()");
+      if (state_size2 != std::accumulate(sizes, sizes + sizes_size, 0))
+	throw std::length_error("state_size2 should be the sum of sizes");
+
+      Index3 index;
+      index.fill(0);
+      const int width = std::min(indices_size2, static_cast<int>(index.size()));
+      const int num = std::min(indices_size1, state_size1);
+      for (int n = 0; n < num; ++n) {
+	std::copy(indices + n * indices_size2,
+		  indices + n * indices_size2 + width, index.begin());
+	const int p = position(index);
+	if (p >= 0)
+	  load_state(p, state + n * state_size2, sizes);
+      }
+    }
     
     IdxCnt::const_iterator
     find(const Index3& idx) const
     {
-      auto it = std::find(idx_list.begin(), idx_list.end(), idx);
-      return it;
+      const int pos = position(idx);
+      if (pos < 0)
+	return idx_list.end();
+      else
+	return idx_list.locate(pos);
     }
 
     virtual PwMaterial<T>*
@@ -72,18 +520,42 @@ namespace gmes
     int
     position(const Index3& idx) const
     {
-      auto it = find(idx);
-      
-      size_t pos = 0;
-      if (it == idx_list.end())
-	return pos - 1;
-      else {
-	pos = std::distance(idx_list.begin(), it);
-	return pos;
-      }
+      return idx_index.position(idx_list, idx);
+    }
+
+    // Save and load the state of the cell at the position p. The
+    // state is saved in the sizes of state_sizes() and loaded from
+    // the given sizes.
+    virtual void
+    state_sizes(int*) const
+    {
+    }
+
+    virtual void
+    save_state(std::size_t, double*) const
+    {
+    }
+
+    virtual void
+    load_state(std::size_t, const double*, const int*)
+    {
     }
     
     IdxCnt idx_list;
+
+  private:
+    void
+    update_part(RunPart part, double n)
+    {
+      idx_list.select(part);
+      update_bound(n);
+      idx_list.select(RUN_ALL);
+    }
+
+    CellIndex<Index3> idx_index;
+    FieldArray<T> bound0;
+    FieldArray<const T> bound1, bound2;
+    double bound_d1, bound_d2, bound_dt;
   }; // template PwMaterial
 
   template <typename T> 
@@ -91,13 +563,47 @@ namespace gmes
   {
   public:
     virtual double 
-    get_eps_inf(const int* const idx, int idx_size) const = 0;
+    get_eps_inf(const int* const idx, int idx_size) const
+    {
+      Index3 index;
+      std::copy(idx, idx + idx_size, index.begin());
+      const int i = position(index);
+      if (i < 0)
+	return 0;
+      else
+	return eps_inf_list[i];
+    }
+
+    // Look up eps_inf of every row of indices at once.
+    void
+    get_eps_inf_many(const int* const indices, int indices_size1, int indices_size2,
+		     double* const eps_inf, int eps_inf_size) const
+    {
+      Index3 index;
+      index.fill(0);
+      const int width = std::min(indices_size2, static_cast<int>(index.size()));
+      const int num = std::min(indices_size1, eps_inf_size);
+      for (int n = 0; n < num; ++n) {
+	std::copy(indices + n * indices_size2,
+		  indices + n * indices_size2 + width, index.begin());
+	const int i = position(index);
+	eps_inf[n] = i < 0 ? 0 : eps_inf_list[i];
+      }
+    }
+
+    void
+    reserve(std::size_t cell_num)
+    {
+      PwMaterial<T>::reserve(cell_num);
+      reserve_more(eps_inf_list, cell_num);
+    }
 
     using PwMaterial<T>::find;
 
   protected:
     using PwMaterial<T>::position;
     using PwMaterial<T>::idx_list;
+    CoeffCnt eps_inf_list;
   }; // template MaterialElectric
 
   template <typename T> 
@@ -105,13 +611,47 @@ namespace gmes
   {
   public:
     virtual double 
-    get_mu_inf(const int* const idx, int idx_size) const = 0;
+    get_mu_inf(const int* const idx, int idx_size) const
+    {
+      Index3 index;
+      std::copy(idx, idx + idx_size, index.begin());
+      const int i = position(index);
+      if (i < 0)
+	return 0;
+      else
+	return mu_inf_list[i];
+    }
+
+    // Look up mu_inf of every row of indices at once.
+    void
+    get_mu_inf_many(const int* const indices, int indices_size1, int indices_size2,
+		    double* const mu_inf, int mu_inf_size) const
+    {
+      Index3 index;
+      index.fill(0);
+      const int width = std::min(indices_size2, static_cast<int>(index.size()));
+      const int num = std::min(indices_size1, mu_inf_size);
+      for (int n = 0; n < num; ++n) {
+	std::copy(indices + n * indices_size2,
+		  indices + n * indices_size2 + width, index.begin());
+	const int i = position(index);
+	mu_inf[n] = i < 0 ? 0 : mu_inf_list[i];
+      }
+    }
+
+    void
+    reserve(std::size_t cell_num)
+    {
+      PwMaterial<T>::reserve(cell_num);
+      reserve_more(mu_inf_list, cell_num);
+    }
 
     using PwMaterial<T>::find;
 
   protected:
     using PwMaterial<T>::position;
     using PwMaterial<T>::idx_list;
+    CoeffCnt mu_inf_list;
   }; // template MaterialMagnetic
 } // namespace gmes
 
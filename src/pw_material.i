@@ -2,27 +2,35 @@
 
 %{
 #define SWIG_FILE_WITH_INIT
+#include "simd.hh"
 #include "pw_material.hh"
 #include "pw_dummy.hh"
 #include "pw_const.hh"
 #include "pw_dielectric.hh"
+#include "pw_dielectric_grid.hh"
 #include "pw_upml.hh"
 #include "pw_cpml.hh"
 #include "pw_drude.hh"
 #include "pw_lorentz.hh"
 #include "pw_dcp.hh"
 #include "pw_dm2.hh"
+#include "pw_halo.hh"
+#include "pw_stepper.hh"
 %}
 
+%include <exception.i>
 %include <std_string.i>
 %include <std_complex.i>
 %include "numpy.i"
 
 %numpy_typemaps(std::complex<double>, NPY_CDOUBLE, int)
+%numpy_typemaps(std::complex<float>, NPY_CFLOAT, int)
 %apply size_t { gmes::IdxCnt::size_type }; 
 
 %init %{
 import_array();
+// Choose the kernels for this CPU on import.
+gmes::simd_level();
 %}
 
 // Declare numpy typemaps.
@@ -59,35 +67,109 @@ import_array();
       {(TYPE* const hy, int hy_x_size, int hy_y_size, int hy_z_size)};
 %apply (TYPE* INPLACE_ARRAY3, int DIM1, int DIM2, int DIM3)
       {(TYPE* const hz, int hz_x_size, int hz_y_size, int hz_z_size)};
+
+%apply (TYPE* IN_ARRAY1, int DIM1)
+      {(const TYPE* const values, int values_size)};
+
+// The bound arrays are kept beyond the call, so they must not be
+// converted copies.
+%apply (TYPE* INPLACE_ARRAY3, int DIM1, int DIM2, int DIM3)
+      {(TYPE* const bound_field, int bound_dim1, int bound_dim2, int bound_dim3)};
+%apply (TYPE* INPLACE_ARRAY3, int DIM1, int DIM2, int DIM3)
+      {(const TYPE* const bound_field1, int bound1_dim1, int bound1_dim2, int bound1_dim3)};
+%apply (TYPE* INPLACE_ARRAY3, int DIM1, int DIM2, int DIM3)
+      {(const TYPE* const bound_field2, int bound2_dim1, int bound2_dim2, int bound2_dim3)};
+
+%apply (TYPE* INPLACE_ARRAY3, int DIM1, int DIM2, int DIM3)
+      {(const TYPE* const halo_field, int halo_x_size, int halo_y_size, int halo_z_size)};
+%apply (TYPE* INPLACE_ARRAY3, int DIM1, int DIM2, int DIM3)
+      {(TYPE* const halo_field, int halo_x_size, int halo_y_size, int halo_z_size)};
+%apply (TYPE* INPLACE_ARRAY1, int DIM1)
+      {(const TYPE* const buf, int buf_size)};
+%apply (TYPE* INPLACE_ARRAY1, int DIM1)
+      {(TYPE* const buf, int buf_size)};
 %enddef    /* apply_numpy_typemaps() macro */
 
 %apply_numpy_typemaps(double)
 %apply_numpy_typemaps(std::complex<double>)
+%apply_numpy_typemaps(float)
+%apply_numpy_typemaps(std::complex<float>)
 
 %apply (int* IN_ARRAY1, int DIM1) {(const int* const idx, int idx_size)};
+%apply (int* IN_ARRAY1, int DIM1) {(const int* const lo, int lo_size)};
+%apply (int* IN_ARRAY1, int DIM1) {(const int* const hi, int hi_size)};
 %apply (double* IN_ARRAY2, int DIM1, int DIM2) {(const double* const a, int a_size1, int a_size2)};
 %apply (double* IN_ARRAY2, int DIM1, int DIM2) {(const double* const b, int b_size1, int b_size2)};
 %apply (std::complex<double>* IN_ARRAY2, int DIM1, int DIM2) {(const std::complex<double>* const b, int b_size1, int b_size2)};
 %apply (double* IN_ARRAY1, int DIM1) {(const double* const c, int c_size)};
+%apply (double* IN_ARRAY2, int DIM1, int DIM2) {(const double* const coeffs, int coeffs_size1, int coeffs_size2)};
 
 %apply (double* IN_ARRAY1, int DIM1) {(const double* const omega, int omega_size)};
 %apply (double* IN_ARRAY1, int DIM1) {(const double* const n, int n_size)};
 
+%apply (int* IN_ARRAY2, int DIM1, int DIM2) {(const int* const indices, int indices_size1, int indices_size2)};
+%apply (int* INPLACE_ARRAY2, int DIM1, int DIM2) {(int* const cell_indices, int cell_indices_size1, int cell_indices_size2)};
+%apply (double* INPLACE_ARRAY2, int DIM1, int DIM2) {(double* const state, int state_size1, int state_size2)};
+%apply (double* IN_ARRAY2, int DIM1, int DIM2) {(const double* const state, int state_size1, int state_size2)};
+%apply (int* IN_ARRAY1, int DIM1) {(const int* const sizes, int sizes_size)};
+%apply (int* ARGOUT_ARRAY1, int DIM1) {(int* const sizes, int sizes_size)};
+%apply (double* ARGOUT_ARRAY1, int DIM1) {(double* const eps_inf, int eps_inf_size)};
+%apply (double* ARGOUT_ARRAY1, int DIM1) {(double* const mu_inf, int mu_inf_size)};
+
 %apply (double* ARGOUT_ARRAY1, int DIM1) {(double* const u, int u_size)};
 %apply (double* ARGOUT_ARRAY1, int DIM1) {(double* const v, int v_size)};
 %apply (double* ARGOUT_ARRAY1, int DIM1) {(double* const w, int w_size)};
 
+// Release the GIL in the heavy entry points, which touch no Python
+// object once their arguments are converted. The other Python threads
+// run meanwhile, e.g. the updates of the other field components.
+%define %release_gil(name)
+%exception name {
+  Py_BEGIN_ALLOW_THREADS
+  $action
+  Py_END_ALLOW_THREADS
+}
+%enddef
+
+%release_gil(update_all)
+%release_gil(update_bound)
+%release_gil(update_interior)
+%release_gil(update_shell)
+%release_gil(step_until_n)
+%release_gil(step_while_zero)
+
+// Raise ValueError on the halo buffers and the state of a wrong size.
+%define %check_length(name)
+%exception name {
+  try {
+    $action
+  } catch (const std::length_error& e) {
+    SWIG_exception(SWIG_ValueError, e.what());
+  }
+}
+%enddef
+
+%check_length(pack)
+%check_length(unpack)
+%check_length(get_state_sizes)
+%check_length(get_state)
+%check_length(set_state)
+
 // Include the header file to be wrapped
+%include "simd.hh"
 %include "pw_material.hh"
 %include "pw_dummy.hh"
 %include "pw_const.hh"
 %include "pw_dielectric.hh"
+%include "pw_dielectric_grid.hh"
 %include "pw_upml.hh"
 %include "pw_cpml.hh"
 %include "pw_drude.hh"
 %include "pw_lorentz.hh"
 %include "pw_dcp.hh"
 %include "pw_dm2.hh"
+%include "pw_halo.hh"
+%include "pw_stepper.hh"
 
 // Instantiate template classes
 %define %linear_wrap(T, postfix)
@@ -131,6 +213,12 @@ import_array();
 %template(DielectricHx ## postfix) gmes::DielectricHx<T >;
 %template(DielectricHy ## postfix) gmes::DielectricHy<T >;
 %template(DielectricHz ## postfix) gmes::DielectricHz<T >;
+%template(DielectricGridEx ## postfix) gmes::DielectricGridEx<T >;
+%template(DielectricGridEy ## postfix) gmes::DielectricGridEy<T >;
+%template(DielectricGridEz ## postfix) gmes::DielectricGridEz<T >;
+%template(DielectricGridHx ## postfix) gmes::DielectricGridHx<T >;
+%template(DielectricGridHy ## postfix) gmes::DielectricGridHy<T >;
+%template(DielectricGridHz ## postfix) gmes::DielectricGridHz<T >;
 
 // UPML
 %template(UpmlElectricParam ## postfix) gmes::UpmlElectricParam<T >;
@@ -290,6 +378,10 @@ import_array();
   }
 };
 
+// Halo exchange and time-stepping loop
+%template(Halo ## postfix) gmes::Halo<T >;
+%template(Stepper ## postfix) gmes::Stepper<T >;
+
 %enddef    /* linear_wrap() macro */
 
 %define %nonlinear_wrap(T, postfix)
@@ -325,5 +417,8 @@ import_array();
 
 %linear_wrap(double, Real)
 %linear_wrap(std::complex<double>, Cmplx)
+%linear_wrap(float, RealSingle)
+%linear_wrap(std::complex<float>, CmplxSingle)
 
 %nonlinear_wrap(double, Real)
+%nonlinear_wrap(float, RealSingle)
@@ -0,0 +1,203 @@
+#ifndef PW_STEPPER_HH_
+#define PW_STEPPER_HH_
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "pw_halo.hh"
+#include "pw_material.hh"
+
+namespace gmes
+{
+  // Point source driving one cell with a value per time step. The
+  // value replaces the field, or is added as a current density if
+  // current is set.
+  template <typename T>
+  struct PointDrive
+  {
+    Index3 idx;
+    std::vector<T> values;
+    bool current;
+    double inf;
+  }; // template PointDrive
+
+  // Time-stepping loop of an FDTD over the pw materials of the six
+  // field components, which runs many time steps in one call. The
+  // components are numbered 0 to 5 for Ex, Ey, Ez, Hx, Hy, and Hz.
+  // The schedule follows FDTD.step() of the Python side: the halo
+  // planes of the periodic boundaries are copied before each half
+  // step, then the materials and the point sources of each component
+  // are updated.
+  template <typename T>
+  class Stepper
+  {
+  public:
+    Stepper():
+      dx(1), dy(1), dz(1), dt(1)
+    {
+      for (auto& a: field) {
+	a.f = 0;
+	a.x_size = a.y_size = a.z_size = 0;
+      }
+    }
+
+    void
+    set_fields(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
+	       T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
+	       T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
+	       T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+	       T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+	       T* const hz, int hz_x_size, int hz_y_size, int hz_z_size)
+    {
+      set_field(0, ex, ex_x_size, ex_y_size, ex_z_size);
+      set_field(1, ey, ey_x_size, ey_y_size, ey_z_size);
+      set_field(2, ez, ez_x_size, ez_y_size, ez_z_size);
+      set_field(3, hx, hx_x_size, hx_y_size, hx_z_size);
+      set_field(4, hy, hy_x_size, hy_y_size, hy_z_size);
+      set_field(5, hz, hz_x_size, hz_y_size, hz_z_size);
+    }
+
+    void
+    set_space(double dx, double dy, double dz, double dt)
+    {
+      this->dx = dx;
+      this->dy = dy;
+      this->dz = dz;
+      this->dt = dt;
+    }
+
+    void
+    attach_material(int comp, PwMaterial<T>* const pm)
+    {
+      material[comp].push_back(pm);
+    }
+
+    // Drive the cell idx of comp with values, one per time step from
+    // the first step of the next call. inf is the permittivity or the
+    // permeability of the cell for a current source.
+    void
+    attach_source(int comp, const int* const idx, int idx_size,
+		  const T* const values, int values_size,
+		  bool current, double inf)
+    {
+      PointDrive<T> drive;
+      std::copy(idx, idx + idx_size, drive.idx.begin());
+      drive.values.assign(values, values + values_size);
+      drive.current = current;
+      drive.inf = inf;
+      source[comp].push_back(drive);
+    }
+
+    // Copy the halo plane of comp from the other side of the periodic
+    // boundary before each of its half steps.
+    void
+    attach_halo(int comp, const Halo<T>& halo)
+    {
+      halo_list[comp].push_back(halo);
+    }
+
+    // Run the time steps from n until n_end, and return the new n.
+    double
+    step_until_n(double n, double n_end)
+    {
+      for (std::size_t s = 0; n < n_end; ++s)
+	step(n, s);
+
+      return n;
+    }
+
+    // Run the time steps from n while the field of comp at (i, j, k)
+    // is zero, but not beyond n_end, and return the new n.
+    double
+    step_while_zero(double n, double n_end, int comp, int i, int j, int k)
+    {
+      const T& probe = at(comp, i, j, k);
+      for (std::size_t s = 0; n < n_end; ++s) {
+	step(n, s);
+	if (probe != T(0))
+	  break;
+      }
+
+      return n;
+    }
+
+  private:
+    void
+    set_field(int comp, T* const f, int x_size, int y_size, int z_size)
+    {
+      field[comp].f = f;
+      field[comp].x_size = x_size;
+      field[comp].y_size = y_size;
+      field[comp].z_size = z_size;
+    }
+
+    T&
+    at(int comp, int i, int j, int k) const
+    {
+      const FieldArray<T>& a = field[comp];
+      return a.f[(i * a.y_size + j) * a.z_size + k];
+    }
+
+    // Run the s-th time step of the call from n.
+    void
+    step(double& n, std::size_t s)
+    {
+      n += 0.5;
+      for (int comp = 3; comp < 6; ++comp)
+	wrap(comp);
+      for (int comp = 0; comp < 3; ++comp)
+	update(comp, n, s);
+
+      n += 0.5;
+      for (int comp = 0; comp < 3; ++comp)
+	wrap(comp);
+      for (int comp = 3; comp < 6; ++comp)
+	update(comp, n, s);
+    }
+
+    void
+    wrap(int comp)
+    {
+      const FieldArray<T>& a = field[comp];
+      for (const auto& halo: halo_list[comp])
+	halo.wrap(a.f, a.x_size, a.y_size, a.z_size);
+    }
+
+    void
+    update(int comp, double n, std::size_t s)
+    {
+      // Fields and space differentials of the update equation of
+      // each component.
+      static const int in1[6] = {5, 3, 4, 2, 0, 1};
+      static const int in2[6] = {4, 5, 3, 1, 2, 0};
+      const double d1[6] = {dy, dz, dx, dy, dz, dx};
+      const double d2[6] = {dz, dx, dy, dz, dx, dy};
+
+      const FieldArray<T>& f0 = field[comp];
+      const FieldArray<T>& f1 = field[in1[comp]];
+      const FieldArray<T>& f2 = field[in2[comp]];
+      for (auto pm: material[comp])
+	pm->update_all(f0.f, f0.x_size, f0.y_size, f0.z_size,
+		       f1.f, f1.x_size, f1.y_size, f1.z_size,
+		       f2.f, f2.x_size, f2.y_size, f2.z_size,
+		       d1[comp], d2[comp], dt, n);
+
+      for (const auto& drive: source[comp]) {
+	T& f = at(comp, drive.idx[0], drive.idx[1], drive.idx[2]);
+	const T& value = drive.values[s];
+	if (drive.current)
+	  f -= dt * value / drive.inf;
+	else
+	  f = value;
+      }
+    }
+
+    std::array<FieldArray<T>, 6> field;
+    std::array<std::vector<PwMaterial<T>*>, 6> material;
+    std::array<std::vector<PointDrive<T> >, 6> source;
+    std::array<std::vector<Halo<T> >, 6> halo_list;
+    double dx, dy, dz, dt;
+  }; // template Stepper
+} // namespace gmes
+
+#endif // PW_STEPPER_HH_
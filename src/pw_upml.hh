@@ -10,13 +10,6 @@
 
 #include "pw_material.hh"
 
-#define ex(i,j,k) ex[ex_y_size==1?0:((i)*ex_y_size+(j))*ex_z_size+(k)]
-#define ey(i,j,k) ey[ey_z_size==1?0:((i)*ey_y_size+(j))*ey_z_size+(k)]
-#define ez(i,j,k) ez[ez_x_size==1?0:((i)*ez_y_size+(j))*ez_z_size+(k)]
-#define hx(i,j,k) hx[hx_y_size==1?0:((i)*hx_y_size+(j))*hx_z_size+(k)]
-#define hy(i,j,k) hy[hy_z_size==1?0:((i)*hy_y_size+(j))*hy_z_size+(k)]
-#define hz(i,j,k) hz[hz_x_size==1?0:((i)*hz_y_size+(j))*hz_z_size+(k)]
-
 namespace gmes
 {
   template <typename T> 
@@ -43,18 +36,6 @@ namespace gmes
       return UpmlElectric<T>::tag;
     }
 
-    double
-    get_eps_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].eps_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size, 
 	   const PwMaterialParam* const pm_param_ptr)
@@ -65,24 +46,106 @@ namespace gmes
       const auto& upml_param = *static_cast<const UpmlElectricParam<T>*>(pm_param_ptr);
 
       idx_list.push_back(index);
-      param_list.push_back(upml_param);
+      eps_inf_list.push_back(upml_param.eps_inf);
+      c1_list.push_back(upml_param.c1);
+      c2_list.push_back(upml_param.c2);
+      c3_list.push_back(upml_param.c3);
+      c4_list.push_back(upml_param.c4);
+      c5_list.push_back(upml_param.c5);
+      c6_list.push_back(upml_param.c6);
+      d_list.push_back(upml_param.d);
 
       return this;
     }
 
+    using MaterialElectric<T>::attach_many;
+
+    // Attach every row of indices with its own row of coeffs,
+    // (c1, c2, c3, c4, c5, c6). The remaining fields come from
+    // the shared parameter.
+    PwMaterial<T>*
+    attach_many(const int* const indices, int indices_size1, int indices_size2,
+		const PwMaterialParam* const pm_param_ptr,
+		const double* const coeffs, int coeffs_size1, int coeffs_size2)
+    {
+      auto upml_param = *static_cast<const UpmlElectricParam<T>*>(pm_param_ptr);
+
+      const int num = std::min(indices_size1, coeffs_size1);
+      reserve(num);
+      for (int n = 0; n < num; ++n) {
+	const double* const row = coeffs + n * coeffs_size2;
+	upml_param.c1 = row[0];
+	upml_param.c2 = row[1];
+	upml_param.c3 = row[2];
+	upml_param.c4 = row[3];
+	upml_param.c5 = row[4];
+	upml_param.c6 = row[5];
+	attach(indices + n * indices_size2, indices_size2, &upml_param);
+      }
+
+      return this;
+    }
+
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialElectric<T>::reserve(cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(c3_list, cell_num);
+      reserve_more(c4_list, cell_num);
+      reserve_more(c5_list, cell_num);
+      reserve_more(c6_list, cell_num);
+      reserve_more(d_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto upml_ptr = static_cast<const UpmlElectric<T>*>(pm_ptr);
       std::copy(upml_ptr->idx_list.begin(), upml_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(upml_ptr->param_list.begin(), upml_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(upml_ptr->eps_inf_list.begin(), upml_ptr->eps_inf_list.end(), std::back_inserter(eps_inf_list));
+      std::copy(upml_ptr->c1_list.begin(), upml_ptr->c1_list.end(), std::back_inserter(c1_list));
+      std::copy(upml_ptr->c2_list.begin(), upml_ptr->c2_list.end(), std::back_inserter(c2_list));
+      std::copy(upml_ptr->c3_list.begin(), upml_ptr->c3_list.end(), std::back_inserter(c3_list));
+      std::copy(upml_ptr->c4_list.begin(), upml_ptr->c4_list.end(), std::back_inserter(c4_list));
+      std::copy(upml_ptr->c5_list.begin(), upml_ptr->c5_list.end(), std::back_inserter(c5_list));
+      std::copy(upml_ptr->c6_list.begin(), upml_ptr->c6_list.end(), std::back_inserter(c6_list));
+      std::copy(upml_ptr->d_list.begin(), upml_ptr->d_list.end(), std::back_inserter(d_list));
       return this;
     }
 
+    int
+    state_arrays() const
+    {
+      return 1;
+    }
+
   protected:
     using MaterialElectric<T>::position;
     using MaterialElectric<T>::idx_list;
-    std::vector<UpmlElectricParam<T> > param_list;
+    using MaterialElectric<T>::eps_inf_list;
+    Reciprocal inv_eps_inf_list;
+    CoeffCnt c1_list, c2_list, c3_list, c4_list, c5_list, c6_list;
+    std::vector<T, AlignedAllocator<T> > d_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(d_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(d_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(d_list, p, in, sizes[0]);
+    }
 
   private:
     static const std::string tag; // "UpmlElectric"
@@ -101,34 +164,87 @@ namespace gmes
 	       const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
 	       double dy, double dz, double dt, double n)
     {
-       for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ex, ex_x_size, ex_y_size, ex_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Ex, class Hz, class Hy>
+    void
+    update_cells(const Ex& ex, const Hz& hz, const Hy& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ex, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ex, hz, hy, dy, dz, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ex, const Field<const T>& hz,
+		 const Field<const T>& hy,
+		 double dy, double dz, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      update_runs(*this, idx_list, ex, hz, hy, dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ex, const Field<const T>& hz,
+	       const Field<const T>& hy,
+	       double dy, double dz, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      T* const ex_00 = &ex(i,j,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_p0 = &hz(i+1,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+	const double c1 = c1_list[p];
+	const double c2 = c2_list[p];
+	const double c3 = c3_list[p];
+	const double c4 = c4_list[p];
+	const double c5 = c5_list[p];
+	const double c6 = c6_list[p];
+	T& d = d_list[p];
+
+	const T dstore(d);
+
+	d = c1 * d + c2 * ((hz_pp[l] - hz_p0[l]) * inv_dy -
+			   (hy_p0[l + 1] - hy_p0[l]) * inv_dz);
+	ex_00[l] = c3 * ex_00[l] + c4 * (c5 * d - c6 * dstore) * inv_eps_inf;
       }
     }
 
   private:
-    void 
-    update(T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
+    template <class Ex, class Hz, class Hy>
+    void
+    update(const Ex& ex, const Hz& hz, const Hy& hy,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx,
-	   UpmlElectricParam<T>& upml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
      
-      const double eps_inf = upml_param.eps_inf;
-      const double c1 = upml_param.c1;
-      const double c2 = upml_param.c2;
-      const double c3 = upml_param.c3;
-      const double c4 = upml_param.c4;
-      const double c5 = upml_param.c5;
-      const double c6 = upml_param.c6;
-      T& d = upml_param.d;
+      const double eps_inf = eps_inf_list[p];
+      const double c1 = c1_list[p];
+      const double c2 = c2_list[p];
+      const double c3 = c3_list[p];
+      const double c4 = c4_list[p];
+      const double c5 = c5_list[p];
+      const double c6 = c6_list[p];
+      T& d = d_list[p];
       
       const T dstore(d);
       
@@ -139,46 +255,108 @@ namespace gmes
     
   protected:
     using UpmlElectric<T>::idx_list;
-    using UpmlElectric<T>::param_list;
+    using UpmlElectric<T>::eps_inf_list;
+    using UpmlElectric<T>::inv_eps_inf_list;
+    using UpmlElectric<T>::c1_list;
+    using UpmlElectric<T>::c2_list;
+    using UpmlElectric<T>::c3_list;
+    using UpmlElectric<T>::c4_list;
+    using UpmlElectric<T>::c5_list;
+    using UpmlElectric<T>::c6_list;
+    using UpmlElectric<T>::d_list;
   }; // template UpmlEx
 
   template <typename T> 
   class UpmlEy: public UpmlElectric<T>
   {
+  public:
     virtual void
     update_all(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ey, ey_x_size, ey_y_size, ey_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       hz, hz_x_size, hz_y_size, hz_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Ey, class Hx, class Hz>
+    void
+    update_cells(const Ey& ey, const Hx& hx, const Hz& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ey, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ey, hx, hz, dz, dx, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ey, const Field<const T>& hx,
+		 const Field<const T>& hz,
+		 double dz, double dx, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      update_runs(*this, idx_list, ey, hx, hz, dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ey, const Field<const T>& hx,
+	       const Field<const T>& hz,
+	       double dz, double dx, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      T* const ey_00 = &ey(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hz_pp = &hz(i+1,j+1,k);
+      const T* const hz_0p = &hz(i,j+1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+	const double c1 = c1_list[p];
+	const double c2 = c2_list[p];
+	const double c3 = c3_list[p];
+	const double c4 = c4_list[p];
+	const double c5 = c5_list[p];
+	const double c6 = c6_list[p];
+	T& d = d_list[p];
+
+	const T dstore(d);
+
+	d = c1 * d + c2 * ((hx_0p[l + 1] - hx_0p[l]) * inv_dz -
+			   (hz_pp[l] - hz_0p[l]) * inv_dx);
+	ey_00[l] = c3 * ey_00[l] + c4 * (c5 * d - c6 * dstore) * inv_eps_inf;
       }
     }
 
   private:
-    void 
-    update(T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
+    template <class Ey, class Hx, class Hz>
+    void
+    update(const Ey& ey, const Hx& hx, const Hz& hz,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx,
-	   UpmlElectricParam<T>& upml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const double eps_inf = upml_param.eps_inf;
-      const double c1 = upml_param.c1;
-      const double c2 = upml_param.c2;
-      const double c3 = upml_param.c3;
-      const double c4 = upml_param.c4;
-      const double c5 = upml_param.c5;
-      const double c6 = upml_param.c6;
-      T& d = upml_param.d;
+      const double eps_inf = eps_inf_list[p];
+      const double c1 = c1_list[p];
+      const double c2 = c2_list[p];
+      const double c3 = c3_list[p];
+      const double c4 = c4_list[p];
+      const double c5 = c5_list[p];
+      const double c6 = c6_list[p];
+      T& d = d_list[p];
       
       const T dstore(d);
 
@@ -189,7 +367,15 @@ namespace gmes
 
   protected:
     using UpmlElectric<T>::idx_list;
-    using UpmlElectric<T>::param_list;
+    using UpmlElectric<T>::eps_inf_list;
+    using UpmlElectric<T>::inv_eps_inf_list;
+    using UpmlElectric<T>::c1_list;
+    using UpmlElectric<T>::c2_list;
+    using UpmlElectric<T>::c3_list;
+    using UpmlElectric<T>::c4_list;
+    using UpmlElectric<T>::c5_list;
+    using UpmlElectric<T>::c6_list;
+    using UpmlElectric<T>::d_list;
   }; // template UpmlEy
 
   template <typename T> 
@@ -202,34 +388,88 @@ namespace gmes
 	       const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(ez, ez_x_size, ez_y_size, ez_z_size,
-	       hy, hy_x_size, hy_y_size, hy_z_size,
-	       hx, hx_x_size, hx_y_size, hx_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Ez, class Hy, class Hx>
+    void
+    update_cells(const Ez& ez, const Hy& hy, const Hx& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(ez, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(ez, hy, hx, dx, dy, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& ez, const Field<const T>& hy,
+		 const Field<const T>& hx,
+		 double dx, double dy, double dt, double n)
+    {
+      inv_eps_inf_list.sync(eps_inf_list);
+      update_runs(*this, idx_list, ez, hy, hx, dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& ez, const Field<const T>& hy,
+	       const Field<const T>& hx,
+	       double dx, double dy, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      T* const ez_00 = &ez(i,j,k);
+      const T* const hy_p0 = &hy(i+1,j,k);
+      const T* const hy_00 = &hy(i,j,k);
+      const T* const hx_0p = &hx(i,j+1,k);
+      const T* const hx_00 = &hx(i,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_eps_inf = inv_eps_inf_list[p];
+	const double c1 = c1_list[p];
+	const double c2 = c2_list[p];
+	const double c3 = c3_list[p];
+	const double c4 = c4_list[p];
+	const double c5 = c5_list[p];
+	const double c6 = c6_list[p];
+	T& d = d_list[p];
+
+	const T dstore(d);
+
+	d = c1 * d + c2 * ((hy_p0[l + 1] - hy_00[l + 1]) * inv_dx -
+			   (hx_0p[l + 1] - hx_00[l + 1]) * inv_dy);
+	ez_00[l] = c3 * ez_00[l] + c4 * (c5 * d - c6 * dstore) * inv_eps_inf;
       }
     }
 
   private:
-    void 
-    update(T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
+    template <class Ez, class Hy, class Hx>
+    void
+    update(const Ez& ez, const Hy& hy, const Hx& hx,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx,
-	   UpmlElectricParam<T>& upml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const double eps_inf = upml_param.eps_inf;
-      const double c1 = upml_param.c1;
-      const double c2 = upml_param.c2;
-      const double c3 = upml_param.c3;
-      const double c4 = upml_param.c4;
-      const double c5 = upml_param.c5;
-      const double c6 = upml_param.c6;
-      T& d = upml_param.d;
+      const double eps_inf = eps_inf_list[p];
+      const double c1 = c1_list[p];
+      const double c2 = c2_list[p];
+      const double c3 = c3_list[p];
+      const double c4 = c4_list[p];
+      const double c5 = c5_list[p];
+      const double c6 = c6_list[p];
+      T& d = d_list[p];
       
       const T dstore(d);
 
@@ -240,7 +480,15 @@ namespace gmes
 
   protected:
     using UpmlElectric<T>::idx_list;
-    using UpmlElectric<T>::param_list;
+    using UpmlElectric<T>::eps_inf_list;
+    using UpmlElectric<T>::inv_eps_inf_list;
+    using UpmlElectric<T>::c1_list;
+    using UpmlElectric<T>::c2_list;
+    using UpmlElectric<T>::c3_list;
+    using UpmlElectric<T>::c4_list;
+    using UpmlElectric<T>::c5_list;
+    using UpmlElectric<T>::c6_list;
+    using UpmlElectric<T>::d_list;
   };
 
   template <typename T> 
@@ -253,18 +501,6 @@ namespace gmes
       return UpmlMagnetic<T>::tag;
     }
 
-    double
-    get_mu_inf(const int* const idx, int idx_size) const
-    {
-      Index3 index;
-      std::copy(idx, idx + idx_size, index.begin());
-      const int i = position(index);
-      if (i < 0)
-	return 0;
-      else
-	return param_list[i].mu_inf;
-    }
-
     PwMaterial<T>*
     attach(const int* const idx, int idx_size, 
 	   const PwMaterialParam* const pm_param_ptr)
@@ -275,24 +511,106 @@ namespace gmes
       const auto& upml_param = *static_cast<const UpmlMagneticParam<T>*>(pm_param_ptr);
       
       idx_list.push_back(index);
-      param_list.push_back(upml_param);
+      mu_inf_list.push_back(upml_param.mu_inf);
+      c1_list.push_back(upml_param.c1);
+      c2_list.push_back(upml_param.c2);
+      c3_list.push_back(upml_param.c3);
+      c4_list.push_back(upml_param.c4);
+      c5_list.push_back(upml_param.c5);
+      c6_list.push_back(upml_param.c6);
+      b_list.push_back(upml_param.b);
 
       return this;
     }
 
+    using MaterialMagnetic<T>::attach_many;
+
+    // Attach every row of indices with its own row of coeffs,
+    // (c1, c2, c3, c4, c5, c6). The remaining fields come from
+    // the shared parameter.
+    PwMaterial<T>*
+    attach_many(const int* const indices, int indices_size1, int indices_size2,
+		const PwMaterialParam* const pm_param_ptr,
+		const double* const coeffs, int coeffs_size1, int coeffs_size2)
+    {
+      auto upml_param = *static_cast<const UpmlMagneticParam<T>*>(pm_param_ptr);
+
+      const int num = std::min(indices_size1, coeffs_size1);
+      reserve(num);
+      for (int n = 0; n < num; ++n) {
+	const double* const row = coeffs + n * coeffs_size2;
+	upml_param.c1 = row[0];
+	upml_param.c2 = row[1];
+	upml_param.c3 = row[2];
+	upml_param.c4 = row[3];
+	upml_param.c5 = row[4];
+	upml_param.c6 = row[5];
+	attach(indices + n * indices_size2, indices_size2, &upml_param);
+      }
+
+      return this;
+    }
+
+    void
+    reserve(std::size_t cell_num)
+    {
+      MaterialMagnetic<T>::reserve(cell_num);
+      reserve_more(c1_list, cell_num);
+      reserve_more(c2_list, cell_num);
+      reserve_more(c3_list, cell_num);
+      reserve_more(c4_list, cell_num);
+      reserve_more(c5_list, cell_num);
+      reserve_more(c6_list, cell_num);
+      reserve_more(b_list, cell_num);
+    }
+
     PwMaterial<T>*
     merge(const PwMaterial<T>* const pm_ptr)
     {
       auto upml_ptr = static_cast<const UpmlMagnetic<T>*>(pm_ptr);
       std::copy(upml_ptr->idx_list.begin(), upml_ptr->idx_list.end(), std::back_inserter(idx_list));
-      std::copy(upml_ptr->param_list.begin(), upml_ptr->param_list.end(), std::back_inserter(param_list));
+      std::copy(upml_ptr->mu_inf_list.begin(), upml_ptr->mu_inf_list.end(), std::back_inserter(mu_inf_list));
+      std::copy(upml_ptr->c1_list.begin(), upml_ptr->c1_list.end(), std::back_inserter(c1_list));
+      std::copy(upml_ptr->c2_list.begin(), upml_ptr->c2_list.end(), std::back_inserter(c2_list));
+      std::copy(upml_ptr->c3_list.begin(), upml_ptr->c3_list.end(), std::back_inserter(c3_list));
+      std::copy(upml_ptr->c4_list.begin(), upml_ptr->c4_list.end(), std::back_inserter(c4_list));
+      std::copy(upml_ptr->c5_list.begin(), upml_ptr->c5_list.end(), std::back_inserter(c5_list));
+      std::copy(upml_ptr->c6_list.begin(), upml_ptr->c6_list.end(), std::back_inserter(c6_list));
+      std::copy(upml_ptr->b_list.begin(), upml_ptr->b_list.end(), std::back_inserter(b_list));
       return this;
     }
 
+    int
+    state_arrays() const
+    {
+      return 1;
+    }
+
   protected:
     using MaterialMagnetic<T>::position;
     using MaterialMagnetic<T>::idx_list;
-    std::vector<UpmlMagneticParam<T> > param_list;
+    using MaterialMagnetic<T>::mu_inf_list;
+    Reciprocal inv_mu_inf_list;
+    CoeffCnt c1_list, c2_list, c3_list, c4_list, c5_list, c6_list;
+    std::vector<T, AlignedAllocator<T> > b_list;
+
+    void
+    save_state(std::size_t p, double* out) const
+    {
+      save_cell(b_list, p, out);
+    }
+
+    void
+    state_sizes(int* sizes) const
+    {
+      sizes[0] = cell_state_size(b_list);
+    }
+
+    void
+    load_state(std::size_t p, const double* in, const int* sizes)
+    {
+      load_cell(b_list, p, in, sizes[0]);
+    }
 
   private:
     static const std::string tag; // "UpmlMagnetic"
@@ -304,40 +622,94 @@ namespace gmes
   template <typename T> 
   class UpmlHx: public UpmlMagnetic<T>
   {
+  public:
     virtual void
     update_all(T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
 	       const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
 	       const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
 	       double dy, double dz, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(hx, hx_x_size, hx_y_size, hx_z_size,
-	       ez, ez_x_size, ez_y_size, ez_z_size,
-	       ey, ey_x_size, ey_y_size, ey_z_size,
-	       dy, dz, dt, n, *idx, *param);
+      update_fields(*this, hx, hx_y_size == 1, hx_y_size, hx_z_size,
+		    ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    dy, dz, dt, n);
+    }
+
+    template <class Hx, class Ez, class Ey>
+    void
+    update_cells(const Hx& hx, const Ez& ez, const Ey& ey,
+		 double dy, double dz, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hx, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hx, ez, ey, dy, dz, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hx, const Field<const T>& ez,
+		 const Field<const T>& ey,
+		 double dy, double dz, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      update_runs(*this, idx_list, hx, ez, ey, dy, dz, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hx, const Field<const T>& ez,
+	       const Field<const T>& ey,
+	       double dy, double dz, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dy = 1 / dy, inv_dz = 1 / dz;
+      T* const hx_00 = &hx(i,j,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_0m = &ez(i,j-1,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+	const double c1 = c1_list[p];
+	const double c2 = c2_list[p];
+	const double c3 = c3_list[p];
+	const double c4 = c4_list[p];
+	const double c5 = c5_list[p];
+	const double c6 = c6_list[p];
+	T& b = b_list[p];
+
+	const T bstore(b);
+
+	b = c1 * b - c2 * ((ez_00[l - 1] - ez_0m[l - 1]) * inv_dy -
+			   (ey_0m[l] - ey_0m[l - 1]) * inv_dz);
+	hx_00[l] = c3 * hx_00[l] + c4 * (c5 * b - c6 * bstore) * inv_mu_inf;
       }
     }
 
   private:
-    void 
-    update(T* const hx, int hx_x_size, int hx_y_size, int hx_z_size,
-	   const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
-	   const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
+    template <class Hx, class Ez, class Ey>
+    void
+    update(const Hx& hx, const Ez& ez, const Ey& ey,
 	   double dy, double dz, double dt, double n,
-	   const Index3& idx, 
-	   UpmlMagneticParam<T> upml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const double mu_inf = upml_param.mu_inf;
-      const double c1 = upml_param.c1;
-      const double c2 = upml_param.c2;
-      const double c3 = upml_param.c3;
-      const double c4 = upml_param.c4;
-      const double c5 = upml_param.c5;
-      const double c6 = upml_param.c6;
-      T& b = upml_param.b;
+      const double mu_inf = mu_inf_list[p];
+      const double c1 = c1_list[p];
+      const double c2 = c2_list[p];
+      const double c3 = c3_list[p];
+      const double c4 = c4_list[p];
+      const double c5 = c5_list[p];
+      const double c6 = c6_list[p];
+      T& b = b_list[p];
       
       const T bstore(b);
 
@@ -348,7 +720,15 @@ namespace gmes
 
   protected:
     using UpmlMagnetic<T>::idx_list;
-    using UpmlMagnetic<T>::param_list;
+    using UpmlMagnetic<T>::mu_inf_list;
+    using UpmlMagnetic<T>::inv_mu_inf_list;
+    using UpmlMagnetic<T>::c1_list;
+    using UpmlMagnetic<T>::c2_list;
+    using UpmlMagnetic<T>::c3_list;
+    using UpmlMagnetic<T>::c4_list;
+    using UpmlMagnetic<T>::c5_list;
+    using UpmlMagnetic<T>::c6_list;
+    using UpmlMagnetic<T>::b_list;
   }; // template UpmlHx
 
   template <typename T> 
@@ -361,34 +741,87 @@ namespace gmes
 	       const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
 	       double dz, double dx, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-      	update(hy, hy_x_size, hy_y_size, hy_z_size,
-	       ex, ex_x_size, ex_y_size, ex_z_size,
-	       ez, ez_x_size, ez_y_size, ez_z_size,
-	       dz, dx, dt, n, *idx, *param);
+      update_fields(*this, hy, hy_z_size == 1, hy_y_size, hy_z_size,
+		    ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    ez, ez_x_size == 1, ez_y_size, ez_z_size,
+		    dz, dx, dt, n);
+    }
+
+    template <class Hy, class Ex, class Ez>
+    void
+    update_cells(const Hy& hy, const Ex& ex, const Ez& ez,
+		 double dz, double dx, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hy, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hy, ex, ez, dz, dx, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hy, const Field<const T>& ex,
+		 const Field<const T>& ez,
+		 double dz, double dx, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      update_runs(*this, idx_list, hy, ex, ez, dz, dx, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hy, const Field<const T>& ex,
+	       const Field<const T>& ez,
+	       double dz, double dx, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dz = 1 / dz, inv_dx = 1 / dx;
+      T* const hy_00 = &hy(i,j,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+      const T* const ez_00 = &ez(i,j,k);
+      const T* const ez_m0 = &ez(i-1,j,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+	const double c1 = c1_list[p];
+	const double c2 = c2_list[p];
+	const double c3 = c3_list[p];
+	const double c4 = c4_list[p];
+	const double c5 = c5_list[p];
+	const double c6 = c6_list[p];
+	T& b = b_list[p];
+
+	const T bstore(b);
+
+	b = c1 * b - c2 * ((ex_m0[l] - ex_m0[l - 1]) * inv_dz -
+			   (ez_00[l - 1] - ez_m0[l - 1]) * inv_dx);
+	hy_00[l] = c3 * hy_00[l] + c4 * (c5 * b - c6 * bstore) * inv_mu_inf;
       }
     }
 
   private:
-    void 
-    update(T* const hy, int hy_x_size, int hy_y_size, int hy_z_size,
-	   const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
-	   const T* const ez, int ez_x_size, int ez_y_size, int ez_z_size,
+    template <class Hy, class Ex, class Ez>
+    void
+    update(const Hy& hy, const Ex& ex, const Ez& ez,
 	   double dz, double dx, double dt, double n,
-	   const Index3& idx, 
-	   UpmlMagneticParam<T>& upml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const double mu_inf = upml_param.mu_inf;
-      const double c1 = upml_param.c1;
-      const double c2 = upml_param.c2;
-      const double c3 = upml_param.c3;
-      const double c4 = upml_param.c4;
-      const double c5 = upml_param.c5;
-      const double c6 = upml_param.c6;
-      T& b = upml_param.b;
+      const double mu_inf = mu_inf_list[p];
+      const double c1 = c1_list[p];
+      const double c2 = c2_list[p];
+      const double c3 = c3_list[p];
+      const double c4 = c4_list[p];
+      const double c5 = c5_list[p];
+      const double c6 = c6_list[p];
+      T& b = b_list[p];
       
       const T bstore(b);
 
@@ -399,7 +832,15 @@ namespace gmes
 
   protected:
     using UpmlMagnetic<T>::idx_list;
-    using UpmlMagnetic<T>::param_list;
+    using UpmlMagnetic<T>::mu_inf_list;
+    using UpmlMagnetic<T>::inv_mu_inf_list;
+    using UpmlMagnetic<T>::c1_list;
+    using UpmlMagnetic<T>::c2_list;
+    using UpmlMagnetic<T>::c3_list;
+    using UpmlMagnetic<T>::c4_list;
+    using UpmlMagnetic<T>::c5_list;
+    using UpmlMagnetic<T>::c6_list;
+    using UpmlMagnetic<T>::b_list;
   }; // template UpmlHy
 
   template <typename T> 
@@ -412,34 +853,88 @@ namespace gmes
 	       const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
 	       double dx, double dy, double dt, double n)
     {
-      for (auto idx = idx_list.begin(), param = param_list.begin();
-	   idx != idx_list.end(); ++idx, ++param) {
-    	update(hz, hz_x_size, hz_y_size, hz_z_size,
-	       ey, ey_x_size, ey_y_size, ey_z_size,
-	       ex, ex_x_size, ex_y_size, ex_z_size,
-	       dx, dy, dt, n, *idx, *param);
+      update_fields(*this, hz, hz_x_size == 1, hz_y_size, hz_z_size,
+		    ey, ey_z_size == 1, ey_y_size, ey_z_size,
+		    ex, ex_y_size == 1, ex_y_size, ex_z_size,
+		    dx, dy, dt, n);
+    }
+
+    template <class Hz, class Ey, class Ex>
+    void
+    update_cells(const Hz& hz, const Ey& ey, const Ex& ex,
+		 double dx, double dy, double dt, double n)
+    {
+      const std::size_t run_num = idx_list.run_size();
+#pragma omp parallel for if (threaded(hz, idx_list.size()))
+      for (std::size_t r = 0; r < run_num; ++r) {
+	const Run& run = idx_list.run(r);
+	for (int l = 0; l < run.len; ++l) {
+	  const Index3 idx = {{run.i, run.j, run.k0 + l}};
+	  update(hz, ey, ex, dx, dy, dt, n, idx, run.p0 + l);
+	}
+      }
+    }
+
+    void
+    update_cells(const Field<T>& hz, const Field<const T>& ey,
+		 const Field<const T>& ex,
+		 double dx, double dy, double dt, double n)
+    {
+      inv_mu_inf_list.sync(mu_inf_list);
+      update_runs(*this, idx_list, hz, ey, ex, dx, dy, dt, n);
+    }
+
+    void
+    update_run(const Field<T>& hz, const Field<const T>& ey,
+	       const Field<const T>& ex,
+	       double dx, double dy, double dt, double n,
+	       const Run& run)
+    {
+      const int i = run.i, j = run.j, k = run.k0;
+      const double inv_dx = 1 / dx, inv_dy = 1 / dy;
+      T* const hz_00 = &hz(i,j,k);
+      const T* const ey_0m = &ey(i,j-1,k);
+      const T* const ey_mm = &ey(i-1,j-1,k);
+      const T* const ex_m0 = &ex(i-1,j,k);
+      const T* const ex_mm = &ex(i-1,j-1,k);
+
+#pragma omp simd
+      for (int l = 0; l < run.len; ++l) {
+	const std::size_t p = run.p0 + l;
+	const double inv_mu_inf = inv_mu_inf_list[p];
+	const double c1 = c1_list[p];
+	const double c2 = c2_list[p];
+	const double c3 = c3_list[p];
+	const double c4 = c4_list[p];
+	const double c5 = c5_list[p];
+	const double c6 = c6_list[p];
+	T& b = b_list[p];
+
+	const T bstore(b);
+
+	b = c1 * b - c2 * ((ey_0m[l] - ey_mm[l]) * inv_dx -
+			   (ex_m0[l] - ex_mm[l]) * inv_dy);
+	hz_00[l] = c3 * hz_00[l] + c4 * (c5 * b - c6 * bstore) * inv_mu_inf;
       }
     }
 
   private:
-    void 
-    update(T* const hz, int hz_x_size, int hz_y_size, int hz_z_size,
-	   const T* const ey, int ey_x_size, int ey_y_size, int ey_z_size,
-	   const T* const ex, int ex_x_size, int ex_y_size, int ex_z_size,
+    template <class Hz, class Ey, class Ex>
+    void
+    update(const Hz& hz, const Ey& ey, const Ex& ex,
 	   double dx, double dy, double dt, double n,
-	   const Index3& idx, 
-	   UpmlMagneticParam<T>& upml_param) const
+	   const Index3& idx, std::size_t p)
     {
       const int i = idx[0], j = idx[1], k = idx[2];
       
-      const double mu_inf = upml_param.mu_inf;
-      const double c1 = upml_param.c1;
-      const double c2 = upml_param.c2;
-      const double c3 = upml_param.c3;
-      const double c4 = upml_param.c4;
-      const double c5 = upml_param.c5;
-      const double c6 = upml_param.c6;
-      T& b = upml_param.b;
+      const double mu_inf = mu_inf_list[p];
+      const double c1 = c1_list[p];
+      const double c2 = c2_list[p];
+      const double c3 = c3_list[p];
+      const double c4 = c4_list[p];
+      const double c5 = c5_list[p];
+      const double c6 = c6_list[p];
+      T& b = b_list[p];
       
       const T bstore(b);
 
@@ -450,15 +945,16 @@ namespace gmes
 
   protected:
     using UpmlMagnetic<T>::idx_list;
-    using UpmlMagnetic<T>::param_list;
+    using UpmlMagnetic<T>::mu_inf_list;
+    using UpmlMagnetic<T>::inv_mu_inf_list;
+    using UpmlMagnetic<T>::c1_list;
+    using UpmlMagnetic<T>::c2_list;
+    using UpmlMagnetic<T>::c3_list;
+    using UpmlMagnetic<T>::c4_list;
+    using UpmlMagnetic<T>::c5_list;
+    using UpmlMagnetic<T>::c6_list;
+    using UpmlMagnetic<T>::b_list;
   };
 }
 
-#undef ex
-#undef ey
-#undef ez
-#undef hx
-#undef hy
-#undef hz
-
 #endif /*PW_UPML_HH_*/
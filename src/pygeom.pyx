@@ -11,6 +11,9 @@ from material import Compound, Pml
 cimport numpy as np
 np.import_array()
 cimport cython
+from cython.parallel cimport prange, parallel
+from libc.math cimport fabs, ceil, floor, INFINITY, sqrt as csqrt
+from libc.stdlib cimport malloc, free
 
 
 cdef double norm(object p):
@@ -46,73 +49,97 @@ cdef class Material(object):
         """
         raise NotImplementedError
 
-    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_ex(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         """Return an ElectricParam structure of the given point.
         
         Arguments:
-            idx -- (local) array index of the target point
-            coords -- (global) space coordinate of the target point
+            idx -- (local) array index of the target point, or an N x 3
+                array of them to attach in one batch
+            coords -- (global) space coordinate of the target point, or an
+                N x 3 array of them matching idx
             complex -- whether the EM field has complex value. Default is False.
+            single -- whether the EM field has single precision. Default is False.
             underneath -- underneath material object of the target point.
             
         """
         raise NotImplementedError
     
-    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_ey(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         """Return an ElectricParam structure of the given point.
         
         Arguments:
-            idx -- (local) array index of the target point
-            coords -- (global) space coordinate of the target point
+            idx -- (local) array index of the target point, or an N x 3
+                array of them to attach in one batch
+            coords -- (global) space coordinate of the target point, or an
+                N x 3 array of them matching idx
             complex -- whether the EM field has complex value. Default is False.
+            single -- whether the EM field has single precision. Default is False.
             underneath -- underneath material object of the target point.
             
         """
         raise NotImplementedError
     
-    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_ez(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         """Return an ElectricParam structure of the given point.
         
         Arguments:
-            idx -- (local) array index of the target point
-            coords -- (global) space coordinate of the target point
+            idx -- (local) array index of the target point, or an N x 3
+                array of them to attach in one batch
+            coords -- (global) space coordinate of the target point, or an
+                N x 3 array of them matching idx
             complex -- whether the EM field has complex value. Default is False.
+            single -- whether the EM field has single precision. Default is False.
             underneath -- underneath material object of the target point.
             
         """
         raise NotImplementedError
     
-    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_hx(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         """Return a MagneticParam structure of the given point.
         
         Arguments:
-            idx -- (local) array index of the target point
-            coords -- (global) space coordinate of the target point
+            idx -- (local) array index of the target point, or an N x 3
+                array of them to attach in one batch
+            coords -- (global) space coordinate of the target point, or an
+                N x 3 array of them matching idx
             complex -- whether the EM field has complex value. Default is False.
+            single -- whether the EM field has single precision. Default is False.
             underneath -- underneath material object of the target point.
             
         """
         raise NotImplementedError
     
-    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_hy(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         """Return a MagneticParam structure of the given point.
         
         Arguments:
-            idx -- (local) array index of the target point
-            coords -- (global) space coordinate of the target point
+            idx -- (local) array index of the target point, or an N x 3
+                array of them to attach in one batch
+            coords -- (global) space coordinate of the target point, or an
+                N x 3 array of them matching idx
             complex -- whether the EM field has complex value. Default is False.
+            single -- whether the EM field has single precision. Default is False.
             underneath -- underneath material object of the target point.
             
         """
         raise NotImplementedError
     
-    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False):
+    def get_pw_material_hz(self, idx, coords, underneath=None, cmplx=False,
+                           single=False):
         """Return a MagneticParam structure of the given point.
         
         Arguments:
-            idx -- (local) array index of the target point
-            coords -- (global) space coordinate of the target point
+            idx -- (local) array index of the target point, or an N x 3
+                array of them to attach in one batch
+            coords -- (global) space coordinate of the target point, or an
+                N x 3 array of them matching idx
             complex -- whether the EM field has complex value. Default is False.
+            single -- whether the EM field has single precision. Default is False.
             underneath -- underneath material object of the target point.
             
         """
@@ -153,6 +180,683 @@ cdef tuple find_object(tuple point, tuple geom_list):
     return geom_list[i], i
 
 
+# The inclusion tests of the geometric primitives on plain C data, so
+# that a batch of points is tested without the GIL. A Shape is filled 
+# by GeometricObject.compile_shape.
+
+cdef enum:
+    SHAPE_ALL
+    SHAPE_CONE
+    SHAPE_BLOCK
+    SHAPE_ELLIPSOID
+    SHAPE_SPHERE
+    SHAPE_SHELL
+    SHAPE_LATTICE
+
+cdef struct Shape:
+    int kind
+    double low[3]
+    double high[3]
+    double center[3]
+    double axes[9] # the axis of a cone or the projection matrix of a block
+    double size[3]
+    double inverse_semi_axes[3]
+    double radius, radius2, height
+    int box_num
+    double box_low[18]
+    double box_high[18]
+    # The sites of a lattice are at center + n[0] * axes[0:3] + ... for 
+    # the integer n of basis_num components, within the size about the
+    # center. dual gives the lattice coordinates of a point, and reach
+    # those of the motif box.
+    int basis_num
+    double dual[9]
+    double reach_low[3]
+    double reach_high[3]
+    Shape* motif
+    int* removed
+    int removed_num
+
+
+cdef inline bint in_bounds(double* low, double* high, double* p) nogil:
+    return (low[0] <= p[0] <= high[0] and 
+            low[1] <= p[1] <= high[1] and
+            low[2] <= p[2] <= high[2])
+
+
+cdef bint in_shape(Shape* s, double* p) nogil:
+    """The same test as in_object of the geometric object of s.
+
+    """
+    cdef double r[3]
+    cdef double proj[3]
+    cdef double t, radius, dist2
+    cdef int i
+
+    if s.kind == SHAPE_ALL:
+        return in_bounds(s.low, s.high, p)
+    elif s.kind == SHAPE_SHELL:
+        for i in range(s.box_num):
+            if in_bounds(s.box_low + 3 * i, s.box_high + 3 * i, p):
+                return True
+        return False
+
+    # The primitives lie within their bounding boxes.
+    if not in_bounds(s.low, s.high, p):
+        return False
+
+    for i in range(3):
+        r[i] = p[i] - s.center[i]
+
+    if s.kind == SHAPE_LATTICE:
+        return in_lattice(s, r)
+    elif s.kind == SHAPE_CONE:
+        t = s.axes[0] * r[0] + s.axes[1] * r[1] + s.axes[2] * r[2]
+        if not fabs(t) <= .5 * s.height:
+            return False
+        if s.radius2 == s.radius == INFINITY:
+            return True
+        radius = s.radius + (t / s.height + .5) * (s.radius2 - s.radius)
+        dist2 = 0
+        for i in range(3):
+            dist2 += (r[i] - t * s.axes[i]) * (r[i] - t * s.axes[i])
+        return csqrt(dist2) <= fabs(radius)
+    elif s.kind == SHAPE_SPHERE:
+        return csqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]) <= s.radius
+
+    for i in range(3):
+        proj[i] = (s.axes[3 * i] * r[0] + s.axes[3 * i + 1] * r[1] + 
+                   s.axes[3 * i + 2] * r[2])
+
+    if s.kind == SHAPE_BLOCK:
+        for i in range(3):
+            if not fabs(proj[i]) <= .5 * s.size[i]:
+                return False
+        return True
+    else: # SHAPE_ELLIPSOID
+        dist2 = 0
+        for i in range(3):
+            t = proj[i] * s.inverse_semi_axes[i]
+            dist2 += t * t
+        return dist2 <= 1
+
+
+cdef bint in_lattice(Shape* s, double* r) nogil:
+    """Return whether a motif of the lattice s includes r, the point
+    relative to the center.
+
+    Only the sites whose motif boxes can include r are tested, which
+    are found from the lattice coordinates of r.
+
+    """
+    cdef double f
+    cdef double site[3]
+    cdef double q[3]
+    cdef int lo[3]
+    cdef int hi[3]
+    cdef int n[3]
+    cdef int i, j, d = s.basis_num
+
+    for i in range(3):
+        lo[i] = 0
+        hi[i] = 0
+    for i in range(d):
+        f = s.dual[3 * i] * r[0] + s.dual[3 * i + 1] * r[1] + \
+            s.dual[3 * i + 2] * r[2]
+        if not fabs(f) < 1e9:
+            return False
+        lo[i] = <int>ceil(f - s.reach_high[i])
+        hi[i] = <int>floor(f - s.reach_low[i])
+        if lo[i] > hi[i]:
+            return False
+
+    for i in range(3):
+        n[i] = lo[i]
+    while True:
+        for j in range(3):
+            site[j] = (n[0] * s.axes[j] + n[1] * s.axes[3 + j] + 
+                       n[2] * s.axes[6 + j])
+            q[j] = r[j] - site[j]
+        if (fabs(site[0]) <= .5 * s.size[0] and 
+            fabs(site[1]) <= .5 * s.size[1] and
+            fabs(site[2]) <= .5 * s.size[2] and
+            in_shape(s.motif, q) and not is_removed(s, n)):
+            return True
+
+        # the next site in the odometer order
+        i = 0
+        while i < d and n[i] == hi[i]:
+            n[i] = lo[i]
+            i += 1
+        if i == d:
+            return False
+        n[i] += 1
+
+
+cdef bint is_removed(Shape* s, int* n) nogil:
+    cdef int i
+    for i in range(s.removed_num):
+        if (s.removed[3 * i] == n[0] and s.removed[3 * i + 1] == n[1] and 
+            s.removed[3 * i + 2] == n[2]):
+            return True
+    return False
+
+
+cdef int find_shape(Shape* shapes, int* objs, int num, double* p) nogil:
+    """Find the last shape including p among the shapes of the first 
+    num indices in objs.
+
+    find_shape returns the position in objs like find_object, i.e. 0 if
+    no shape includes p.
+
+    """
+    cdef int i = num - 1
+    while i > 0 and not in_shape(shapes + objs[i], p):
+        i -= 1
+
+    return i
+
+
+# A node of GeomBoxTree flattened into an array in the depth-first 
+# order. The children of a branch are t1 and t2, and a leaf holds the
+# indices of its objects at leaf_obj[start:start + num].
+
+cdef struct FlatNode:
+    double low[3]
+    double high[3]
+    int t1, t2
+    int start, num
+
+
+cdef int find_leaf(FlatNode* nodes, double* p) nogil:
+    """The same search as GeomBoxTree.tree_search on the flattened 
+    nodes. Return the index of the leaf including p, or -1.
+
+    """
+    cdef int n = 0
+
+    if not in_bounds(nodes[0].low, nodes[0].high, p):
+        return -1
+
+    while nodes[n].t1 >= 0:
+        if in_bounds(nodes[nodes[n].t1].low, nodes[nodes[n].t1].high, p):
+            n = nodes[n].t1
+        elif in_bounds(nodes[nodes[n].t2].low, nodes[nodes[n].t2].high, p):
+            n = nodes[n].t2
+        else:
+            return -1
+
+    return n
+
+
+cdef void search_tree(FlatNode* nodes, int* leaf_obj, Shape* shapes, 
+                      char* compound, double* p, int* obj, int* under) nogil:
+    """Set obj and under to the indices of the object including p and
+    of its underneath object like GeomBoxTree.object_of_point, or to -1.
+
+    """
+    cdef int leaf, i
+    cdef int* objs
+
+    obj[0] = under[0] = -1
+    leaf = find_leaf(nodes, p)
+    if leaf < 0 or nodes[leaf].num == 0:
+        return
+
+    objs = leaf_obj + nodes[leaf].start
+    i = find_shape(shapes, objs, nodes[leaf].num, p)
+    obj[0] = objs[i]
+    if compound[objs[i]] and i > 0:
+        under[0] = objs[find_shape(shapes, objs, i, p)]
+
+
+# The scanline rasterization of the shapes onto the rows of a grid 
+# along the z axis, see GeomBoxTree.rasterize. The line of a row meets 
+# a convex primitive in one span of z, which is found analytically and
+# then fixed at its ends by in_shape, so the covered points are the 
+# same as the point searches.
+
+cdef int bisect_left(double* a, int n, double x) nogil:
+    """Return the first k with x <= a[k] in the ascending a."""
+    cdef int lo = 0, hi = n, mid
+    while lo < hi:
+        mid = (lo + hi) >> 1
+        if a[mid] < x:
+            lo = mid + 1
+        else:
+            hi = mid
+    return lo
+
+
+cdef int bisect_right(double* a, int n, double x) nogil:
+    """Return the first k with x < a[k] in the ascending a."""
+    cdef int lo = 0, hi = n, mid
+    while lo < hi:
+        mid = (lo + hi) >> 1
+        if x < a[mid]:
+            hi = mid
+        else:
+            lo = mid + 1
+    return lo
+
+
+cdef bint narrow_linear(double m, double q, double h, 
+                        double* lo, double* hi) nogil:
+    """Narrow [lo, hi] to the t with |q + m t| <= h. Return False if it
+    becomes empty.
+
+    """
+    cdef double t1, t2
+    if q != q or m != m:
+        return lo[0] <= hi[0]
+    if m == 0:
+        return fabs(q) <= h and lo[0] <= hi[0]
+
+    t1 = (-h - q) / m
+    t2 = (h - q) / m
+    if t1 > t2:
+        t1, t2 = t2, t1
+    if t1 > lo[0]:
+        lo[0] = t1
+    if t2 < hi[0]:
+        hi[0] = t2
+    return lo[0] <= hi[0]
+
+
+cdef bint narrow_quadratic(double a, double b, double c, 
+                           double* lo, double* hi) nogil:
+    """Narrow [lo, hi] to the hull of the t with a t^2 + b t + c <= 0.
+    Return False if it becomes empty. The coefficients which are not 
+    numbers leave [lo, hi] as it is.
+
+    """
+    cdef double d, r1, r2
+    cdef bint left, right
+    if a != a or b != b or c != c:
+        return lo[0] <= hi[0]
+    if a == 0:
+        if b == 0:
+            return c <= 0 and lo[0] <= hi[0]
+        r1 = -c / b
+        if b > 0 and r1 < hi[0]:
+            hi[0] = r1
+        elif b < 0 and r1 > lo[0]:
+            lo[0] = r1
+        return lo[0] <= hi[0]
+
+    d = b * b - 4 * a * c
+    if d < 0:
+        return a < 0 and lo[0] <= hi[0]
+
+    d = csqrt(d)
+    r1 = (-b - d) / (2 * a)
+    r2 = (-b + d) / (2 * a)
+    if r1 > r2:
+        r1, r2 = r2, r1
+    if a > 0:
+        if r1 > lo[0]:
+            lo[0] = r1
+        if r2 < hi[0]:
+            hi[0] = r2
+    else:
+        # Outside [r1, r2]. Only one side meets a convex primitive.
+        left = lo[0] <= r1
+        right = r2 <= hi[0]
+        if left and not right and r1 < hi[0]:
+            hi[0] = r1
+        elif right and not left and r2 > lo[0]:
+            lo[0] = r2
+        elif not (left or right):
+            return False
+    return lo[0] <= hi[0]
+
+
+cdef bint line_span(Shape* s, double x, double y, 
+                    double* lo, double* hi) nogil:
+    """Set [lo, hi] to the span of z in which the line (x, y, z) meets 
+    the convex primitive s. Return False if the line misses s.
+
+    """
+    cdef double r0[3]
+    cdef double q[3]
+    cdef double w0[3]
+    cdef double wz[3]
+    cdef double a, b, c, u, v, ax0, alpha, beta
+    cdef int i
+
+    if not (s.low[0] <= x <= s.high[0] and s.low[1] <= y <= s.high[1]):
+        return False
+    lo[0] = s.low[2]
+    hi[0] = s.high[2]
+
+    r0[0] = x - s.center[0]
+    r0[1] = y - s.center[1]
+    r0[2] = -s.center[2]
+
+    if s.kind == SHAPE_SPHERE:
+        return narrow_quadratic(1, 2 * r0[2], 
+                                r0[0] * r0[0] + r0[1] * r0[1] + 
+                                r0[2] * r0[2] - s.radius * s.radius, lo, hi)
+    elif s.kind == SHAPE_CONE:
+        ax0 = s.axes[0] * r0[0] + s.axes[1] * r0[1] + s.axes[2] * r0[2]
+        if not narrow_linear(s.axes[2], ax0, .5 * s.height, lo, hi):
+            return False
+        if s.radius2 == s.radius == INFINITY:
+            return True
+        for i in range(3):
+            w0[i] = r0[i] - ax0 * s.axes[i]
+            wz[i] = -s.axes[2] * s.axes[i]
+        wz[2] += 1
+        alpha = s.radius + (ax0 / s.height + .5) * (s.radius2 - s.radius)
+        beta = s.axes[2] / s.height * (s.radius2 - s.radius)
+        a = wz[0] * wz[0] + wz[1] * wz[1] + wz[2] * wz[2] - beta * beta
+        b = 2 * (w0[0] * wz[0] + w0[1] * wz[1] + w0[2] * wz[2] - alpha * beta)
+        c = w0[0] * w0[0] + w0[1] * w0[1] + w0[2] * w0[2] - alpha * alpha
+        return narrow_quadratic(a, b, c, lo, hi)
+
+    for i in range(3):
+        q[i] = (s.axes[3 * i] * r0[0] + s.axes[3 * i + 1] * r0[1] + 
+                s.axes[3 * i + 2] * r0[2])
+
+    if s.kind == SHAPE_BLOCK:
+        for i in range(3):
+            if not narrow_linear(s.axes[3 * i + 2], q[i], .5 * s.size[i], 
+                                 lo, hi):
+                return False
+        return True
+    else: # SHAPE_ELLIPSOID
+        a = b = 0
+        c = -1
+        for i in range(3):
+            u = s.inverse_semi_axes[i] * q[i]
+            v = s.inverse_semi_axes[i] * s.axes[3 * i + 2]
+            a += v * v
+            b += 2 * u * v
+            c += u * u
+        return narrow_quadratic(a, b, c, lo, hi)
+
+
+cdef void fix_span(Shape* s, double x, double y, double* zs, int nk,
+                   int* k0, int* k1) nogil:
+    """Fix the ends of the points zs[k0:k1] of the line (x, y, z) in s
+    by in_shape.
+
+    """
+    cdef double p[3]
+    p[0] = x
+    p[1] = y
+
+    # A span between two points may still touch one of them.
+    if k0[0] >= k1[0]:
+        k0[0] = k1[0] - 1 if k1[0] > 0 else 0
+        k1[0] = k0[0] + 2 if k0[0] + 2 < nk else nk
+
+    while k0[0] < k1[0]:
+        p[2] = zs[k0[0]]
+        if in_shape(s, p):
+            break
+        k0[0] += 1
+    while k1[0] > k0[0]:
+        p[2] = zs[k1[0] - 1]
+        if in_shape(s, p):
+            break
+        k1[0] -= 1
+    if k0[0] == k1[0]:
+        return
+
+    while k0[0] > 0:
+        p[2] = zs[k0[0] - 1]
+        if not in_shape(s, p):
+            break
+        k0[0] -= 1
+    while k1[0] < nk:
+        p[2] = zs[k1[0]]
+        if not in_shape(s, p):
+            break
+        k1[0] += 1
+
+
+# The work space of a thread rasterizing rows. A row is a list of 
+# segments (start, obj, under), each up to the start of the next.
+
+cdef struct RowWork:
+    int* stack
+    int* mark
+    int* objs
+    int* seg
+    int* tmp
+    int* span
+
+
+cdef RowWork* new_work(int node_num, int obj_num, int nk) nogil:
+    """Return a work space for the tree of node_num nodes and obj_num
+    objects over rows of nk points, or NULL if out of memory.
+
+    """
+    # The segments of a row are not empty.
+    cdef int cap = nk + 1, i
+    cdef RowWork* w = <RowWork*>malloc(sizeof(RowWork))
+    if w is NULL:
+        return NULL
+
+    w.stack = <int*>malloc(max(node_num, 1) * sizeof(int))
+    w.mark = <int*>malloc(max(obj_num, 1) * sizeof(int))
+    w.objs = <int*>malloc(max(obj_num, 1) * sizeof(int))
+    w.seg = <int*>malloc(3 * cap * sizeof(int))
+    w.tmp = <int*>malloc(3 * cap * sizeof(int))
+    w.span = <int*>malloc(12 * sizeof(int))
+    if (w.stack is NULL or w.mark is NULL or w.objs is NULL or 
+        w.seg is NULL or w.tmp is NULL or w.span is NULL):
+        free_work(w)
+        return NULL
+
+    for i in range(obj_num):
+        w.mark[i] = 0
+    return w
+
+
+cdef void free_work(RowWork* w) nogil:
+    if w is NULL:
+        return
+    free(w.stack)
+    free(w.mark)
+    free(w.objs)
+    free(w.seg)
+    free(w.tmp)
+    free(w.span)
+    free(w)
+
+
+cdef int row_objects(FlatNode* nodes, int* leaf_obj, double x, double y,
+                     double z0, double z1, RowWork* w, int stamp) nogil:
+    """Collect the objects of the leaves met by the row in w.objs in 
+    the ascending order, and return their number.
+
+    """
+    cdef FlatNode* node
+    cdef int top = 0, num = 0, n, i, o
+
+    w.stack[top] = 0
+    top += 1
+    while top > 0:
+        top -= 1
+        node = nodes + w.stack[top]
+        if not (node.low[0] <= x <= node.high[0] and 
+                node.low[1] <= y <= node.high[1] and
+                node.low[2] <= z1 and z0 <= node.high[2]):
+            continue
+        if node.t1 >= 0:
+            w.stack[top] = node.t2
+            w.stack[top + 1] = node.t1
+            top += 2
+            continue
+        for n in range(node.start, node.start + node.num):
+            o = leaf_obj[n]
+            if w.mark[o] != stamp:
+                w.mark[o] = stamp
+                # insertion into the ascending objs
+                i = num
+                while i > 0 and w.objs[i - 1] > o:
+                    w.objs[i] = w.objs[i - 1]
+                    i -= 1
+                w.objs[i] = o
+                num += 1
+    return num
+
+
+cdef inline int push_segment(int* seg, int m, int start, int o, int u) nogil:
+    if m > 0 and seg[3 * m - 2] == o and seg[3 * m - 1] == u:
+        return m
+    seg[3 * m] = start
+    seg[3 * m + 1] = o
+    seg[3 * m + 2] = u
+    return m + 1
+
+
+cdef int paint(RowWork* w, int num, int nk, int k0, int k1, 
+               int obj, bint compound) nogil:
+    """Paint [k0, k1) of the row of num segments in w.seg with obj, and
+    return the new number of segments. A compound obj takes the painted
+    objects as its underneath objects.
+
+    """
+    cdef int n, m = 0, a, b, lo, hi, o, u
+    cdef int* swap
+
+    for n in range(num):
+        a = w.seg[3 * n]
+        b = w.seg[3 * n + 3] if n + 1 < num else nk
+        o = w.seg[3 * n + 1]
+        u = w.seg[3 * n + 2]
+        lo = a if a > k0 else k0
+        hi = b if b < k1 else k1
+        if a < k0:
+            m = push_segment(w.tmp, m, a, o, u)
+        if lo < hi:
+            m = push_segment(w.tmp, m, lo, obj, o if compound else -1)
+        if b > k1:
+            m = push_segment(w.tmp, m, a if a > k1 else k1, o, u)
+
+    swap = w.seg
+    w.seg = w.tmp
+    w.tmp = swap
+    return m
+
+
+cdef int raster_row(FlatNode* nodes, int* leaf_obj, Shape* shapes, 
+                    char* compound, double x, double y, double* zs, int nk,
+                    RowWork* w, int stamp) nogil:
+    """Rasterize the row (x, y, zs) into the segments in w.seg, and 
+    return their number.
+
+    """
+    cdef Shape* s
+    cdef double lo, hi
+    cdef double p[3]
+    cdef double* lo_p
+    cdef double* hi_p
+    cdef int num, seg_num, n, o, b, span_num, k0, k1, i, k, start
+
+    num = row_objects(nodes, leaf_obj, x, y, zs[0], zs[nk - 1], w, stamp)
+    w.seg[0] = 0
+    w.seg[1] = 0
+    w.seg[2] = -1
+    seg_num = 1
+
+    for n in range(num):
+        o = w.objs[n]
+        if o == 0:
+            continue
+        s = shapes + o
+        span_num = 0
+        if s.kind == SHAPE_ALL or s.kind == SHAPE_SHELL:
+            for b in range(s.box_num if s.kind == SHAPE_SHELL else 1):
+                if s.kind == SHAPE_SHELL:
+                    lo_p = s.box_low + 3 * b
+                    hi_p = s.box_high + 3 * b
+                else:
+                    lo_p = s.low
+                    hi_p = s.high
+                if not (lo_p[0] <= x <= hi_p[0] and lo_p[1] <= y <= hi_p[1]):
+                    continue
+                k0 = bisect_left(zs, nk, lo_p[2])
+                k1 = bisect_right(zs, nk, hi_p[2])
+                if k0 < k1:
+                    # insertion into the spans ascending by start
+                    i = span_num
+                    while i > 0 and w.span[2 * i - 2] > k0:
+                        w.span[2 * i] = w.span[2 * i - 2]
+                        w.span[2 * i + 1] = w.span[2 * i - 1]
+                        i -= 1
+                    w.span[2 * i] = k0
+                    w.span[2 * i + 1] = k1
+                    span_num += 1
+        elif s.kind == SHAPE_LATTICE:
+            # The motifs cut the row into many spans, which are found by
+            # the point tests within the bounding box.
+            if not (s.low[0] <= x <= s.high[0] and s.low[1] <= y <= s.high[1]):
+                continue
+            k0 = bisect_left(zs, nk, s.low[2])
+            k1 = bisect_right(zs, nk, s.high[2])
+            p[0] = x
+            p[1] = y
+            start = -1
+            for k in range(k0, k1):
+                p[2] = zs[k]
+                if in_shape(s, p):
+                    if start < 0:
+                        start = k
+                elif start >= 0:
+                    seg_num = paint(w, seg_num, nk, start, k, o, compound[o])
+                    start = -1
+            if start >= 0:
+                seg_num = paint(w, seg_num, nk, start, k1, o, compound[o])
+            continue
+        elif line_span(s, x, y, &lo, &hi):
+            k0 = bisect_left(zs, nk, lo)
+            k1 = bisect_right(zs, nk, hi)
+            fix_span(s, x, y, zs, nk, &k0, &k1)
+            if k0 < k1:
+                w.span[0] = k0
+                w.span[1] = k1
+                span_num = 1
+
+        # Merge the overlapping spans, so that a compound object does 
+        # not paint over itself.
+        k0 = k1 = -1
+        for i in range(span_num):
+            if k1 >= w.span[2 * i]:
+                if w.span[2 * i + 1] > k1:
+                    k1 = w.span[2 * i + 1]
+                continue
+            if k0 < k1:
+                seg_num = paint(w, seg_num, nk, k0, k1, o, compound[o])
+            k0 = w.span[2 * i]
+            k1 = w.span[2 * i + 1]
+        if k0 < k1:
+            seg_num = paint(w, seg_num, nk, k0, k1, o, compound[o])
+
+    return seg_num
+
+
+cdef void copy_vector(object v, double* out, int size=3):
+    cdef int i
+    for i in range(size):
+        out[i] = v[i]
+
+
+cdef bint has_shape(GeometricObject geom_obj, Shape* s):
+    """Fill s for geom_obj, and return whether the Shape tests the 
+    same as in_object of geom_obj, i.e. in_object is not overridden.
+
+    """
+    native_test = (DefaultMedium.in_object, Cone.in_object, 
+                   Block.in_object, Ellipsoid.in_object, 
+                   Sphere.in_object, Shell.in_object, Lattice.in_object)
+    return (type(geom_obj).in_object in native_test and 
+            geom_obj.compile_shape(s))
+
+
 cdef class GeomBox(object):
     """A bounding box of a geometric object.
     
@@ -306,6 +1010,34 @@ cdef class GeomBoxTree(object):
     """
     cdef public GeomBoxNode root
 
+    # The shapes of root.geom_list and the flattened tree, see compile.
+    cdef Shape* shapes
+    cdef char* compound
+    cdef FlatNode* nodes
+    cdef int* leaf_obj
+    cdef int node_num
+    cdef bint compiled, native
+
+    def __cinit__(self):
+        self.shapes = NULL
+        self.compound = NULL
+        self.nodes = NULL
+        self.leaf_obj = NULL
+        self.compiled = False
+
+    def __dealloc__(self):
+        self.release()
+
+    cdef release(self):
+        free(self.shapes)
+        free(self.compound)
+        free(self.nodes)
+        free(self.leaf_obj)
+        self.shapes = NULL
+        self.compound = NULL
+        self.nodes = NULL
+        self.leaf_obj = NULL
+
     def __init__(self, geom_list):
         box = GeomBox((-np.inf, -np.inf, -np.inf), (np.inf, np.inf, np.inf))
         self.root = GeomBoxNode(box, geom_list, 0)
@@ -423,6 +1155,22 @@ cdef class GeomBoxTree(object):
         cdef GeomBoxNode leaf
         cdef GeometricObject geom_obj
         cdef int idx
+        cdef double p[3]
+        cdef int obj, under
+
+        if not self.compiled:
+            self.compile()
+
+        # Walk the flattened tree if the objects have their shapes.
+        if self.native:
+            copy_vector(point, p)
+            search_tree(self.nodes, self.leaf_obj, self.shapes, 
+                        self.compound, p, &obj, &under)
+            geom_list = self.root.geom_list
+            if obj >= 0 and under < 0:
+                return geom_list[obj], None
+            elif obj >= 0:
+                return geom_list[obj], geom_list[under]
         
         leaf = self.tree_search(self.root, point)
         geom_obj, idx = find_object(point, leaf.geom_list)
@@ -449,6 +1197,273 @@ cdef class GeomBoxTree(object):
             underneath_material = None
             
         return geom_obj.material, underneath_material
+
+    cdef compile(self):
+        """Compile the objects of root.geom_list into the shapes, and 
+        flatten the tree into the nodes.
+
+        The flattened tree keeps the search of the tree, but walks 
+        contiguous C arrays instead of the GeomBoxNode objects. The 
+        shapes are tested if every object has the inclusion test of its
+        primitive, i.e. does not override in_object. The tree is 
+        compiled at the first search, so call this again if the tree 
+        changes after it.
+
+        """
+        cdef GeometricObject geom_obj
+        cdef GeomBoxNode node
+        cdef FlatNode* flat
+        cdef int i, n, obj_num, node_num, leaf_obj_num
+
+        self.release()
+
+        geom_list = self.root.geom_list
+        obj_num = len(geom_list)
+        index = {}
+        for i in range(obj_num):
+            index[id(geom_list[i])] = i
+
+        # The nodes in the depth-first order, and the leaves' objects.
+        order = []
+        leaf_obj_num = 0
+        stack = [self.root]
+        while stack:
+            node = stack.pop()
+            order.append(node)
+            if node.t1 is not None and node.t2 is not None:
+                stack.append(node.t2)
+                stack.append(node.t1)
+            else:
+                leaf_obj_num += len(node.geom_list)
+        node_num = len(order)
+        self.node_num = node_num
+
+        self.shapes = <Shape*>malloc(max(obj_num, 1) * sizeof(Shape))
+        self.compound = <char*>malloc(max(obj_num, 1) * sizeof(char))
+        self.nodes = <FlatNode*>malloc(node_num * sizeof(FlatNode))
+        self.leaf_obj = <int*>malloc(max(leaf_obj_num, 1) * sizeof(int))
+        if (self.shapes is NULL or self.compound is NULL or 
+            self.nodes is NULL or self.leaf_obj is NULL):
+            self.release()
+            raise MemoryError()
+
+        self.native = True
+        for i in range(obj_num):
+            geom_obj = geom_list[i]
+            self.compound[i] = isinstance(geom_obj.material, Compound)
+            if not has_shape(geom_obj, self.shapes + i):
+                self.native = False
+
+        position = {}
+        for n in range(node_num):
+            position[id(order[n])] = n
+
+        leaf_obj_num = 0
+        for n in range(node_num):
+            node = order[n]
+            flat = self.nodes + n
+            copy_vector(node.box.low, flat.low)
+            copy_vector(node.box.high, flat.high)
+            if node.t1 is not None and node.t2 is not None:
+                flat.t1 = position[id(node.t1)]
+                flat.t2 = position[id(node.t2)]
+                flat.start = 0
+                flat.num = 0
+            else:
+                flat.t1 = -1
+                flat.t2 = -1
+                flat.start = leaf_obj_num
+                flat.num = len(node.geom_list)
+                for geom_obj in node.geom_list:
+                    self.leaf_obj[leaf_obj_num] = index[id(geom_obj)]
+                    leaf_obj_num += 1
+
+        self.compiled = True
+
+    def materials_of_points(self, coords):
+        """Find the objects including the given points.
+
+        Return the indices in root.geom_list of the objects including 
+        coords, an N x 3 array of space coordinates, and of their 
+        underneath objects, as a pair of int arrays. The underneath 
+        index is -1 if the object has no underneath object, i.e. its 
+        material is not a Compound. 
+
+        The points walk the flattened tree and are tested on the shapes
+        of the objects without the GIL, on threads. If some object 
+        overrides in_object, this falls back to object_of_point for each
+        point.
+
+        """
+        cdef double[:, ::1] c
+        cdef int[::1] obj, under
+        cdef FlatNode* nodes
+        cdef int* leaf_obj
+        cdef Shape* shapes
+        cdef char* compound
+        cdef int num, n
+
+        c = np.ascontiguousarray(coords, np.double).reshape(-1, 3)
+        num = c.shape[0]
+        obj_idx = np.empty(num, np.intc)
+        under_idx = np.empty(num, np.intc)
+        obj, under = obj_idx, under_idx
+
+        if not self.compiled:
+            self.compile()
+
+        if not self.native:
+            geom_list = self.root.geom_list
+            index = dict((id(geom_list[k]), k) for k in range(len(geom_list)))
+            for n in range(num):
+                geom_obj, underneath_obj = \
+                    self.object_of_point((c[n, 0], c[n, 1], c[n, 2]))
+                obj[n] = index[id(geom_obj)]
+                if underneath_obj is None:
+                    under[n] = -1
+                else:
+                    under[n] = index[id(underneath_obj)]
+            return obj_idx, under_idx
+
+        nodes, leaf_obj = self.nodes, self.leaf_obj
+        shapes, compound = self.shapes, self.compound
+        with nogil:
+            for n in prange(num, schedule='static'):
+                search_tree(nodes, leaf_obj, shapes, compound, &c[n, 0], 
+                            &obj[n], &under[n])
+
+        return obj_idx, under_idx
+
+    @cython.cdivision(True)
+    def rasterize(self, xs, ys, zs):
+        """Find the objects at the points of a grid by rows.
+
+        The grid points are (xs[i], ys[j], zs[k]) for the ascending 
+        coordinates xs, ys, and zs. Return the runs of the points of 
+        each (i, j) row in the same object, as an R x 6 int array of 
+        rows (i, j, k_start, k_end, obj, under) in the ascending order 
+        of (i, j, k). obj and under are the indices like those of 
+        materials_of_points.
+
+        The objects met by a row are painted onto it in the order of 
+        root.geom_list over the first object, so the last object 
+        including a point wins like find_object, and a Compound object
+        takes what it covers as its underneath objects. A primitive 
+        covers one span of a row, which is found analytically and fixed
+        at its ends by the point test, while a Lattice is tested point 
+        by point within its bounding box. The setup cost is thus per row, 
+        and the rows run on threads. If some object overrides 
+        in_object, this falls back to materials_of_points for each row.
+
+        """
+        cdef double[::1] x, y, z
+        cdef int[:, ::1] runs
+        cdef int[::1] counts
+        cdef np.intp_t[::1] offsets
+        cdef FlatNode* nodes
+        cdef int* leaf_obj
+        cdef Shape* shapes
+        cdef char* compound
+        cdef RowWork* w
+        cdef int ni, nj, nk, row_num, node_num, obj_num, r, n, m
+        cdef int failed[1]
+
+        x = np.ascontiguousarray(xs, np.double)
+        y = np.ascontiguousarray(ys, np.double)
+        z = np.ascontiguousarray(zs, np.double)
+        ni, nj, nk = x.shape[0], y.shape[0], z.shape[0]
+        if ni == 0 or nj == 0 or nk == 0:
+            return np.empty((0, 6), np.intc)
+
+        if not self.compiled:
+            self.compile()
+
+        if not self.native:
+            return self.rasterize_by_points(xs, ys, zs)
+
+        nodes, leaf_obj = self.nodes, self.leaf_obj
+        shapes, compound = self.shapes, self.compound
+        obj_num = len(self.root.geom_list)
+        node_num = self.node_num
+        row_num = ni * nj
+        counts_array = np.empty(row_num, np.intc)
+        counts = counts_array
+
+        # The first pass counts the runs of each row, and the second 
+        # pass writes them.
+        failed[0] = 0
+        with nogil, parallel():
+            w = new_work(node_num, obj_num, nk)
+            if w is NULL:
+                failed[0] = 1
+            for r in prange(row_num, schedule='guided'):
+                if w is not NULL:
+                    counts[r] = raster_row(nodes, leaf_obj, shapes, compound,
+                                           x[r // nj], y[r % nj], &z[0], nk,
+                                           w, r + 1)
+            free_work(w)
+        if failed[0]:
+            raise MemoryError()
+
+        offsets_array = np.concatenate(([0], np.cumsum(counts_array)))
+        offsets_array = offsets_array.astype(np.intp)
+        offsets = offsets_array
+        runs_array = np.empty((offsets_array[-1], 6), np.intc)
+        runs = runs_array
+
+        with nogil, parallel():
+            w = new_work(node_num, obj_num, nk)
+            if w is NULL:
+                failed[0] = 1
+            for r in prange(row_num, schedule='guided'):
+                if w is NULL:
+                    continue
+                m = raster_row(nodes, leaf_obj, shapes, compound,
+                               x[r // nj], y[r % nj], &z[0], nk, w, r + 1)
+                for n in range(m):
+                    runs[offsets[r] + n, 0] = r // nj
+                    runs[offsets[r] + n, 1] = r % nj
+                    runs[offsets[r] + n, 2] = w.seg[3 * n]
+                    runs[offsets[r] + n, 3] = \
+                        w.seg[3 * n + 3] if n + 1 < m else nk
+                    runs[offsets[r] + n, 4] = w.seg[3 * n + 1]
+                    runs[offsets[r] + n, 5] = w.seg[3 * n + 2]
+            free_work(w)
+        if failed[0]:
+            raise MemoryError()
+
+        return runs_array
+
+    def rasterize_by_points(self, xs, ys, zs):
+        """The same as rasterize, but by the point searches of 
+        materials_of_points.
+
+        """
+        xs, ys, zs = np.asarray(xs), np.asarray(ys), np.asarray(zs)
+        nk = len(zs)
+        coords = np.empty((nk, 3), np.double)
+        coords[:, 2] = zs
+
+        runs = [np.empty((0, 6), np.intc)]
+        for i in range(len(xs)):
+            for j in range(len(ys)):
+                coords[:, 0] = xs[i]
+                coords[:, 1] = ys[j]
+                obj, under = self.materials_of_points(coords)
+                start = np.flatnonzero((obj[1:] != obj[:-1]) | 
+                                       (under[1:] != under[:-1])) + 1
+                start = np.concatenate(([0], start))
+                end = np.concatenate((start[1:], [nk]))
+                row = np.empty((len(start), 6), np.intc)
+                row[:, 0] = i
+                row[:, 1] = j
+                row[:, 2] = start
+                row[:, 3] = end
+                row[:, 4] = obj[start]
+                row[:, 5] = under[start]
+                runs.append(row)
+
+        return np.concatenate(runs)
         
     def display_info(self, node=None, indent=0):
         if not node: node = self.root
@@ -535,6 +1550,15 @@ cdef class GeometricObject(object):
         
         """ 
         raise NotImplementedError
+
+    cdef bint compile_shape(self, Shape* s):
+        """Fill s for the inclusion test without the GIL.
+
+        Return whether the object has a Shape. The derived classes 
+        of the primitives override this method.
+
+        """
+        return False
     
     def display_info(self, indent=0):
         """Display some information about this geometric object.
@@ -561,6 +1585,12 @@ cdef class DefaultMedium(GeometricObject):
         
         return self.box.in_box(point)
 
+    cdef bint compile_shape(self, Shape* s):
+        s.kind = SHAPE_ALL
+        copy_vector(self.box.low, s.low)
+        copy_vector(self.box.high, s.high)
+        return True
+
     def geom_box(self):
         """
         Override GeometriObject.geom_box.
@@ -658,6 +1688,17 @@ cdef class Cone(GeometricObject):
 
         return truth
 
+    cdef bint compile_shape(self, Shape* s):
+        s.kind = SHAPE_CONE
+        copy_vector(self.box.low, s.low)
+        copy_vector(self.box.high, s.high)
+        copy_vector(self.center, s.center)
+        copy_vector(self.axis, s.axes)
+        s.radius = self.radius
+        s.radius2 = self.radius2
+        s.height = self.height
+        return True
+
     def display_info(self, indent=0):
         """
         Override GeometricObject.display_info.
@@ -796,6 +1837,18 @@ cdef class Block(GeometricObject):
         truth = (np.abs(proj) <= .5 * self.size).all()
 
         return truth
+
+    cdef bint compile_shape(self, Shape* s):
+        cdef int i
+
+        s.kind = SHAPE_BLOCK
+        copy_vector(self.box.low, s.low)
+        copy_vector(self.box.high, s.high)
+        copy_vector(self.center, s.center)
+        for i in range(3):
+            copy_vector(self.projection_matrix[i], s.axes + 3 * i)
+        copy_vector(self.size, s.size)
+        return True
         
     def geom_box(self):
         """Return a GeomBox for this block.
@@ -873,6 +1926,12 @@ cdef class Ellipsoid(Block):
 
         return truth
 
+    cdef bint compile_shape(self, Shape* s):
+        Block.compile_shape(self, s)
+        s.kind = SHAPE_ELLIPSOID
+        copy_vector(self.inverse_semi_axes, s.inverse_semi_axes)
+        return True
+
     def display_info(self, indent=0):
         """Display information of this ellipsoid.
 
@@ -952,6 +2011,14 @@ cdef class Sphere(GeometricObject):
 
         return truth
 
+    cdef bint compile_shape(self, Shape* s):
+        s.kind = SHAPE_SPHERE
+        copy_vector(self.box.low, s.low)
+        copy_vector(self.box.high, s.high)
+        copy_vector(self.center, s.center)
+        s.radius = self.radius
+        return True
+
     def display_info(self, indent=0):
         """Display information of the sphere.
 
@@ -1126,6 +2193,21 @@ cdef class Shell(GeometricObject):
             if box.in_box(point):
                 return True
         return False
+
+    cdef bint compile_shape(self, Shape* s):
+        cdef GeomBox box
+        cdef int i
+
+        if len(self.box_list) > 6:
+            return False
+
+        s.kind = SHAPE_SHELL
+        s.box_num = len(self.box_list)
+        for i in range(s.box_num):
+            box = self.box_list[i]
+            copy_vector(box.low, s.box_low + 3 * i)
+            copy_vector(box.high, s.box_high + 3 * i)
+        return True
         
     def geom_box(self):
         return GeomBox(-self.half_size, self.half_size)
@@ -1140,3 +2222,211 @@ cdef class Shell(GeometricObject):
         print '+z:', self.plus_z, '-z:', self.minus_z
         if self.material:
             self.material.display_info(indent + 5)
+
+
+cdef class Lattice(GeometricObject):
+    """Form a periodic lattice of a motif.
+
+    The copies of the motif are placed at the sites center + n[0] * 
+    basis[0] + n[1] * basis[1] + ... for the integer vectors n, which
+    lie within size about the center and are not removed. A point is 
+    tested only against the motifs of the sites near it, so the test 
+    costs the same for any number of sites.
+
+    Attributes:
+    motif -- geometric object in the unit cell about the origin
+    basis -- lattice vectors
+    center -- coordinates of the site of n = 0
+    size -- lengths of the region of the sites
+    removed -- the integer vectors n of the removed sites
+
+    """
+    cdef public GeometricObject motif
+    cdef public np.ndarray basis, center, size
+    cdef public tuple removed
+    cdef Shape shape
+    cdef Shape motif_shape
+    cdef int* removed_sites
+    cdef bint compiled
+
+    def __cinit__(self, *args, **kwargs):
+        self.removed_sites = NULL
+        self.compiled = False
+
+    def __dealloc__(self):
+        free(self.removed_sites)
+
+    def __init__(self, motif, basis=((1,0,0), (0,1,0), (0,0,1)), 
+                 center=(0,0,0), size=(np.inf, np.inf, np.inf), 
+                 removed=()):
+        """
+
+        Keyword arguments:
+        motif -- The geometric object repeated over the lattice, 
+            which is placed about the origin. The lattice is made of 
+            its material. No default.
+        basis -- One to three linearly independent lattice vectors. 
+            Default is the unit vectors along the axes.
+        center -- Center point of the lattice, where the site of
+            n = 0 is. Default is (0,0,0).
+        size -- Lengths of the box about the center, which includes the
+            sites of the lattice. Default is (inf, inf, inf).
+        removed -- Sequence of the integer vectors n of the removed 
+            sites, e.g. for a waveguide or a defect. Default is ().
+
+        """
+        GeometricObject.__init__(self, motif.material if motif else None)
+
+        self.motif = motif
+        self.basis = np.array(basis, np.double).reshape(-1, 3)
+        if not 1 <= len(self.basis) <= 3:
+            msg = "basis must have one to three vectors."
+            raise ValueError(msg)
+
+        self.center = np.array(center, np.double)
+        self.size = np.array(size, np.double)
+        if np.any(self.size < 0):
+            msg = "size must be non-negative."
+            raise ValueError(msg)
+
+        self.set_removed(removed)
+
+    def __getstate__(self):
+        d = GeometricObject.__getstate__(self)
+        d['motif'] = self.motif
+        d['basis'] = self.basis
+        d['center'] = self.center
+        d['size'] = self.size
+        d['removed'] = self.removed
+        return d
+
+    def __setstate__(self, d):
+        GeometricObject.__setstate__(self, d)
+        self.motif = deepcopy(d['motif'])
+        self.material = self.motif.material
+        self.basis = np.array(d['basis'], np.double)
+        self.center = np.array(d['center'], np.double)
+        self.size = np.array(d['size'], np.double)
+        self.set_removed(d['removed'])
+        if self.box is not None:
+            self.compile()
+
+    def set_removed(self, removed):
+        cdef int i, j
+        
+        self.removed = tuple(tuple(int(c) for c in n) for n in removed)
+        for n in self.removed:
+            if len(n) != len(self.basis):
+                msg = "removed sites must have as many components as basis."
+                raise ValueError(msg)
+
+        free(self.removed_sites)
+        self.removed_sites = <int*>malloc(max(len(self.removed), 1) * 
+                                          3 * sizeof(int))
+        if self.removed_sites is NULL:
+            raise MemoryError()
+        for i in range(len(self.removed)):
+            for j in range(3):
+                self.removed_sites[3 * i + j] = \
+                    self.removed[i][j] if j < len(self.basis) else 0
+        self.shape.removed = self.removed_sites
+        self.shape.removed_num = len(self.removed)
+
+    def init(self, space):
+        self.motif.init(space)
+        self.material = self.motif.material
+        self.box = self.geom_box()
+        self.compile()
+
+    def geom_box(self):
+        """Return GeomBox for the lattice.
+
+        """
+        box = GeomBox(low=self.center - .5 * self.size, 
+                      high=self.center + .5 * self.size)
+
+        box.low += self.motif.box.low
+        box.high += self.motif.box.high
+
+        return box
+
+    cdef compile(self):
+        """Fill the Shape of the lattice, which in_object tests.
+
+        """
+        cdef Shape* s = &self.shape
+        cdef int i, k
+
+        if not has_shape(self.motif, &self.motif_shape):
+            msg = "motif must be a geometric primitive."
+            raise ValueError(msg)
+
+        try:
+            dual = np.linalg.solve(np.dot(self.basis, self.basis.T), 
+                                   self.basis)
+        except np.linalg.LinAlgError:
+            msg = "basis must be linearly independent."
+            raise ValueError(msg)
+
+        s.kind = SHAPE_LATTICE
+        copy_vector(self.box.low, s.low)
+        copy_vector(self.box.high, s.high)
+        copy_vector(self.center, s.center)
+        copy_vector(self.size, s.size)
+        s.basis_num = len(self.basis)
+        for i in range(9):
+            s.axes[i] = 0
+            s.dual[i] = 0
+        for i in range(s.basis_num):
+            copy_vector(self.basis[i], s.axes + 3 * i)
+            copy_vector(dual[i], s.dual + 3 * i)
+
+        # the extent of the motif box in the lattice coordinates
+        low, high = self.motif.box.low, self.motif.box.high
+        for i in range(s.basis_num):
+            s.reach_low[i] = s.reach_high[i] = 0
+            for k in range(3):
+                if dual[i, k] != 0:
+                    s.reach_low[i] += min(dual[i, k] * low[k], 
+                                          dual[i, k] * high[k])
+                    s.reach_high[i] += max(dual[i, k] * low[k], 
+                                           dual[i, k] * high[k])
+            if not -np.inf < s.reach_low[i] <= s.reach_high[i] < np.inf:
+                msg = "motif must be bounded along the basis."
+                raise ValueError(msg)
+
+        s.motif = &self.motif_shape
+        s.removed = self.removed_sites
+        s.removed_num = len(self.removed)
+        self.compiled = True
+
+    cpdef bint in_object(self, tuple point):
+        """Check whether the given point is in a motif of the lattice.
+
+        """
+        cdef double p[3]
+
+        if not self.compiled:
+            self.compile()
+
+        copy_vector(point, p)
+        return in_shape(&self.shape, p)
+
+    cdef bint compile_shape(self, Shape* s):
+        if not self.compiled:
+            self.compile()
+        s[0] = self.shape
+        return True
+
+    def display_info(self, indent=0):
+        """Display information of the lattice.
+
+        """
+        print ' ' * indent, 'lattice'
+        print ' ' * indent,
+        print 'center:', self.center,
+        print 'size:', self.size
+        print ' ' * indent, 'basis:', self.basis.tolist()
+        if self.removed:
+            print ' ' * indent, 'removed sites:', self.removed
+        self.motif.display_info(indent + 5)
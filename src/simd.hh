@@ -0,0 +1,57 @@
+/* Choice of the instruction set of the run kernels. The kernels are
+ * compiled for AVX-512, for AVX2 with FMA and for the baseline of the
+ * build, and the widest set the CPU supports is detected once. The
+ * pw_material module detects it on import, so one build runs on any
+ * x86-64 machine.
+ */
+
+#ifndef SIMD_HH_
+#define SIMD_HH_
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(SWIG)
+#define GMES_SIMD_X86
+#define GMES_TARGET_AVX512 __attribute__((target("avx512f")))
+#define GMES_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define GMES_TARGET_AVX512
+#define GMES_TARGET_AVX2
+#endif
+
+namespace gmes
+{
+  enum SimdLevel
+    {
+      SIMD_GENERIC, SIMD_AVX2, SIMD_AVX512
+    };
+
+  inline SimdLevel
+  simd_level()
+  {
+#ifdef GMES_SIMD_X86
+    static const SimdLevel level =
+      __builtin_cpu_supports("avx512f") ? SIMD_AVX512 :
+      __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? SIMD_AVX2 :
+      SIMD_GENERIC;
+    return level;
+#else
+    return SIMD_GENERIC;
+#endif
+  }
+
+  // Name of the kernels chosen for this CPU.
+  inline const char*
+  simd_path()
+  {
+    switch (simd_level())
+      {
+      case SIMD_AVX512:
+	return "avx512";
+      case SIMD_AVX2:
+	return "avx2";
+      default:
+	return "generic";
+      }
+  }
+} // namespace gmes
+
+#endif // SIMD_HH_
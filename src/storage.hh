@@ -0,0 +1,885 @@
+/* Contiguous storage for the per-cell coefficients and auxiliary
+ * fields of the piecewise materials.
+ *
+ * Every coefficient and state variable of a pw material lives in an
+ * array of its own (structure of arrays) so that the update loops
+ * only stream the data they actually read.
+ */
+
+#ifndef STORAGE_HH_
+#define STORAGE_HH_
+
+#include <algorithm>
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <vector>
+
+namespace gmes
+{
+  // Allocator returning storage aligned to a cache line, so that
+  // every coefficient array starts on a vector register boundary.
+  template <typename V, std::size_t Alignment = 64>
+  class AlignedAllocator
+  {
+  public:
+    typedef V value_type;
+    typedef V* pointer;
+    typedef const V* const_pointer;
+    typedef V& reference;
+    typedef const V& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+      typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() {}
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    pointer
+    address(reference v) const
+    {
+      return &v;
+    }
+
+    const_pointer
+    address(const_reference v) const
+    {
+      return &v;
+    }
+
+    pointer
+    allocate(size_type n, const void* = 0)
+    {
+      if (n == 0)
+	return 0;
+
+      void* ptr = 0;
+      if (posix_memalign(&ptr, Alignment, n * sizeof(V)) != 0)
+	throw std::bad_alloc();
+
+      return static_cast<pointer>(ptr);
+    }
+
+    void
+    deallocate(pointer ptr, size_type)
+    {
+      std::free(ptr);
+    }
+
+    size_type
+    max_size() const
+    {
+      return static_cast<size_type>(-1) / sizeof(V);
+    }
+
+    void
+    construct(pointer ptr, const V& v)
+    {
+      new(static_cast<void*>(ptr)) V(v);
+    }
+
+    void
+    destroy(pointer ptr)
+    {
+      ptr->~V();
+    }
+  }; // template AlignedAllocator
+
+  template <typename V, typename U, std::size_t Alignment>
+  bool
+  operator==(const AlignedAllocator<V, Alignment>&,
+	     const AlignedAllocator<U, Alignment>&)
+  {
+    return true;
+  }
+
+  template <typename V, typename U, std::size_t Alignment>
+  bool
+  operator!=(const AlignedAllocator<V, Alignment>&,
+	     const AlignedAllocator<U, Alignment>&)
+  {
+    return false;
+  }
+
+  // One double coefficient per cell.
+  typedef std::vector<double, AlignedAllocator<double> > CoeffCnt;
+
+  // A fixed number of values per cell, e.g. one value per pole of a
+  // dispersive material, stored cell after cell in one aligned
+  // array. Cells attached with fewer values are padded with zeros,
+  // so that a missing pole never contributes to an update.
+  template <typename V>
+  class CellArray
+  {
+  public:
+    CellArray():
+      cell_width(0), cell_num(0)
+    {
+    }
+
+    std::size_t
+    width() const
+    {
+      return cell_width;
+    }
+
+    std::size_t
+    size() const
+    {
+      return cell_num;
+    }
+
+    V*
+    operator[](std::size_t cell)
+    {
+      return data.empty() ? 0 : &data[cell * cell_width];
+    }
+
+    const V*
+    operator[](std::size_t cell) const
+    {
+      return data.empty() ? 0 : &data[cell * cell_width];
+    }
+
+    std::size_t
+    capacity() const
+    {
+      return cell_width == 0 ? 0 : data.capacity() / cell_width;
+    }
+
+    void
+    reserve(std::size_t cells)
+    {
+      data.reserve(cells * cell_width);
+    }
+
+    void
+    push_back(const std::vector<V>& values)
+    {
+      if (values.size() > cell_width)
+	widen(values.size());
+
+      std::copy(values.begin(), values.end(), std::back_inserter(data));
+      data.resize((cell_num + 1) * cell_width, static_cast<V>(0));
+      ++cell_num;
+    }
+
+    void
+    append(const CellArray<V>& other)
+    {
+      if (other.cell_width > cell_width)
+	widen(other.cell_width);
+
+      data.reserve((cell_num + other.cell_num) * cell_width);
+      for (std::size_t cell = 0; cell < other.cell_num; ++cell) {
+	const V* const first = other[cell];
+	std::copy(first, first + other.cell_width, std::back_inserter(data));
+	data.resize((cell_num + cell + 1) * cell_width, static_cast<V>(0));
+      }
+      cell_num += other.cell_num;
+    }
+
+  private:
+    void
+    widen(std::size_t new_width)
+    {
+      std::vector<V, AlignedAllocator<V> > wide(cell_num * new_width,
+						static_cast<V>(0));
+      for (std::size_t cell = 0; cell < cell_num; ++cell) {
+	std::copy(data.begin() + cell * cell_width,
+		  data.begin() + (cell + 1) * cell_width,
+		  wide.begin() + cell * new_width);
+      }
+      data.swap(wide);
+      cell_width = new_width;
+    }
+
+    std::size_t cell_width, cell_num;
+    std::vector<V, AlignedAllocator<V> > data;
+  }; // template CellArray
+
+  // Make room for n more elements. A container that has to grow
+  // still at least doubles, so that attaching many small batches
+  // keeps the amortized cost of push_back.
+  template <typename Cnt>
+  void
+  reserve_more(Cnt& cnt, std::size_t n)
+  {
+    if (cnt.size() + n > cnt.capacity())
+      cnt.reserve(std::max(cnt.size() + n, 2 * cnt.capacity()));
+  }
+
+  // Per-cell state of a pw material flattened to doubles, so that a
+  // cell moves between nodes with its auxiliary fields. A complex
+  // value takes two doubles.
+  template <typename V>
+  struct StateWidth
+  {
+    static const std::size_t value = 1;
+  }; // template StateWidth
+
+  template <typename V>
+  struct StateWidth<std::complex<V> >
+  {
+    static const std::size_t value = 2;
+  }; // template StateWidth
+
+  template <typename V>
+  inline void
+  save_value(const V& v, double*& out)
+  {
+    *out++ = v;
+  }
+
+  template <typename V>
+  inline void
+  save_value(const std::complex<V>& v, double*& out)
+  {
+    *out++ = v.real();
+    *out++ = v.imag();
+  }
+
+  template <typename V>
+  inline void
+  load_value(V& v, const double*& in)
+  {
+    v = static_cast<V>(*in++);
+  }
+
+  template <typename V>
+  inline void
+  load_value(std::complex<V>& v, const double*& in)
+  {
+    v = std::complex<V>(in[0], in[1]);
+    in += 2;
+  }
+
+  // Number of doubles, and the save and the load of the state of the
+  // cell p, of a container with one value per cell.
+  template <typename V, class A>
+  std::size_t
+  cell_state_size(const std::vector<V, A>&)
+  {
+    return StateWidth<V>::value;
+  }
+
+  template <typename V, class A>
+  void
+  save_cell(const std::vector<V, A>& cnt, std::size_t p, double*& out)
+  {
+    save_value(cnt[p], out);
+  }
+
+  // The load takes the size in doubles of the saved cell, which may
+  // differ from that of cnt. The values beyond the saved ones are
+  // zeroed.
+  template <typename V, class A>
+  void
+  load_cell(std::vector<V, A>& cnt, std::size_t p, const double*& in,
+	    std::size_t size)
+  {
+    const double* const end = in + size;
+    if (size >= StateWidth<V>::value)
+      load_value(cnt[p], in);
+    else
+      cnt[p] = V();
+    in = end;
+  }
+
+  // The same for a CellArray, with width() values per cell.
+  template <typename V>
+  std::size_t
+  cell_state_size(const CellArray<V>& cnt)
+  {
+    return cnt.width() * StateWidth<V>::value;
+  }
+
+  template <typename V>
+  void
+  save_cell(const CellArray<V>& cnt, std::size_t p, double*& out)
+  {
+    const V* const values = cnt[p];
+    for (std::size_t i = 0; i < cnt.width(); ++i)
+      save_value(values[i], out);
+  }
+
+  template <typename V>
+  void
+  load_cell(CellArray<V>& cnt, std::size_t p, const double*& in,
+	    std::size_t size)
+  {
+    const double* const end = in + size;
+    V* const values = cnt[p];
+    const std::size_t width = std::min(cnt.width(), 
+				       size / StateWidth<V>::value);
+    for (std::size_t i = 0; i < width; ++i)
+      load_value(values[i], in);
+    std::fill(values + width, values + cnt.width(), V());
+    in = end;
+  }
+
+  // A run of cells contiguous along the last axis, (i, j, k0),
+  // (i, j, k0 + 1), ..., (i, j, k0 + len - 1). The cells take the
+  // positions p0, ..., p0 + len - 1 of the per-cell arrays.
+  struct Run
+  {
+    int i, j, k0, len;
+    std::size_t p0;
+  }; // struct Run
+
+  // Parts of the cells of a pw material, see RunList::split().
+  enum RunPart
+    {
+      RUN_ALL,
+      RUN_INTERIOR,
+      RUN_SHELL
+    };
+
+  // Cell indices of a pw material in attach order, stored as runs. A
+  // cell next to the last one along k extends the last run, so a
+  // block of cells costs one run per (i, j) row instead of one index
+  // per cell.
+  class RunList
+  {
+  public:
+    typedef std::array<int, 3> value_type;
+    typedef const value_type& const_reference;
+    typedef std::size_t size_type;
+
+    // Walk the cells in attach order.
+    class const_iterator
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef RunList::value_type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const value_type* pointer;
+      typedef const value_type& reference;
+
+      const_iterator(const std::vector<Run>& runs, std::size_t r, int l = 0):
+	runs(&runs), r(r), l(l)
+      {
+	load();
+      }
+
+      reference
+      operator*() const
+      {
+	return idx;
+      }
+
+      pointer
+      operator->() const
+      {
+	return &idx;
+      }
+
+      const_iterator&
+      operator++()
+      {
+	if (++l == (*runs)[r].len) {
+	  ++r;
+	  l = 0;
+	}
+	load();
+	return *this;
+      }
+
+      const_iterator
+      operator++(int)
+      {
+	const_iterator old(*this);
+	++*this;
+	return old;
+      }
+
+      bool
+      operator==(const const_iterator& other) const
+      {
+	return r == other.r && l == other.l;
+      }
+
+      bool
+      operator!=(const const_iterator& other) const
+      {
+	return !(*this == other);
+      }
+
+    private:
+      void
+      load()
+      {
+	if (r < runs->size()) {
+	  const Run& run = (*runs)[r];
+	  idx[0] = run.i;
+	  idx[1] = run.j;
+	  idx[2] = run.k0 + l;
+	}
+      }
+
+      const std::vector<Run>* runs;
+      std::size_t r;
+      int l;
+      value_type idx;
+    }; // class const_iterator
+
+    RunList():
+      cell_num(0), part(RUN_ALL), parted(false)
+    {
+    }
+
+    size_type
+    size() const
+    {
+      return cell_num;
+    }
+
+    bool
+    empty() const
+    {
+      return cell_num == 0;
+    }
+
+    // The runs of the selected part. The kernels walk the cells with
+    // these two, so they update only the selected part.
+    std::size_t
+    run_size() const
+    {
+      return part == RUN_ALL ? runs.size() : parts[part - 1].size();
+    }
+
+    const Run&
+    run(std::size_t r) const
+    {
+      return part == RUN_ALL ? runs[r] : parts[part - 1][r];
+    }
+
+    // Split the runs into the interior, the cells in the box [lo, hi),
+    // and the shell, the other cells. A run crossing the box along k
+    // is cut into up to three runs; the cut runs keep the positions of
+    // their cells.
+    void
+    split(const value_type& lo, const value_type& hi)
+    {
+      parts[0].clear();
+      parts[1].clear();
+      for (const auto& run: runs) {
+	if (run.i < lo[0] || run.i >= hi[0] || 
+	    run.j < lo[1] || run.j >= hi[1]) {
+	  parts[1].push_back(run);
+	  continue;
+	}
+
+	const int k_end = run.k0 + run.len;
+	const int cut[4] = 
+	  {run.k0, 
+	   std::min(std::max(lo[2], run.k0), k_end),
+	   std::min(std::max(hi[2], run.k0), k_end), 
+	   k_end};
+	for (int c = 0; c < 3; ++c) {
+	  if (cut[c] == cut[c + 1])
+	    continue;
+	  const Run piece = {run.i, run.j, cut[c], cut[c + 1] - cut[c],
+			     run.p0 + (cut[c] - run.k0)};
+	  parts[c == 1 ? 0 : 1].push_back(piece);
+	}
+      }
+      parted = true;
+    }
+
+    // Select the part of the cells to walk. Without a split, the
+    // interior is every cell and the shell is empty.
+    void
+    select(RunPart p)
+    {
+      if (parted || p == RUN_ALL)
+	part = p;
+      else if (p == RUN_INTERIOR)
+	part = RUN_ALL;
+      else {
+	parts[1].clear();
+	part = RUN_SHELL;
+      }
+    }
+
+    // Whether only a part of the cells is selected.
+    bool
+    partial() const
+    {
+      return part != RUN_ALL;
+    }
+
+    // Return the cell at position p. This takes a binary search over
+    // the runs; walk the list with an iterator where possible.
+    value_type
+    operator[](size_type p) const
+    {
+      return *locate(p);
+    }
+
+    // Return an iterator pointing at the cell at position p.
+    const_iterator
+    locate(size_type p) const
+    {
+      if (p >= cell_num)
+	return end();
+
+      std::size_t lo = 0, hi = runs.size();
+      while (hi - lo > 1) {
+	const std::size_t mid = (lo + hi) / 2;
+	if (runs[mid].p0 <= p)
+	  lo = mid;
+	else
+	  hi = mid;
+      }
+
+      return const_iterator(runs, lo, static_cast<int>(p - runs[lo].p0));
+    }
+
+    const_iterator
+    begin() const
+    {
+      return const_iterator(runs, 0);
+    }
+
+    const_iterator
+    end() const
+    {
+      return const_iterator(runs, runs.size());
+    }
+
+    void
+    push_back(const value_type& idx)
+    {
+      // A new cell outdates the split.
+      parted = false;
+      if (!runs.empty()) {
+	Run& last = runs.back();
+	if (last.i == idx[0] && last.j == idx[1] && 
+	    last.k0 + last.len == idx[2]) {
+	  ++last.len;
+	  ++cell_num;
+	  return;
+	}
+      }
+
+      const Run run = {idx[0], idx[1], idx[2], 1, cell_num};
+      runs.push_back(run);
+      ++cell_num;
+    }
+
+  private:
+    std::vector<Run> runs;
+    size_type cell_num;
+    std::array<std::vector<Run>, 2> parts;
+    RunPart part;
+    bool parted;
+  }; // class RunList
+
+  // Reciprocals of the per-cell coefficients of a pw material, so
+  // that the run kernels multiply instead of divide. Coefficient
+  // lists only grow, so sync() appends the reciprocals of the cells
+  // added since the last call.
+  class Reciprocal
+  {
+  public:
+    void
+    sync(const CoeffCnt& values)
+    {
+      for (std::size_t p = inv.size(); p < values.size(); ++p)
+	inv.push_back(1 / values[p]);
+    }
+
+    double
+    operator[](std::size_t p) const
+    {
+      return inv[p];
+    }
+
+  private:
+    CoeffCnt inv;
+  }; // class Reciprocal
+
+  // Per-cell coefficients of a pw material laid out on the bounding
+  // box of its cells. Each cell of the box holds a one byte id into a
+  // table of the distinct coefficient values; id 0 marks the cells
+  // the material does not own. The grid is only worth sweeping when
+  // the material fills most of its box and has few distinct values,
+  // so build() refuses sparse or too varied materials. The owned
+  // cells of each row are kept as runs, so that a sweep never touches
+  // the cells of the box outside the material.
+  class CoeffGrid
+  {
+  public:
+    CoeffGrid():
+      cell_num(0), usable(false), i0(0), j0(0), k0(0), ni(0), nj(0), nk(0)
+    {
+    }
+
+    // (Re)build the grid from the cells and coefficients of a
+    // material unless it is up to date. Return whether the grid
+    // can be used.
+    bool
+    sync(const RunList& idx_list, const CoeffCnt& values,
+	 double min_fill = 0.5)
+    {
+      if (idx_list.size() != cell_num)
+	build(idx_list, values, min_fill);
+
+      return usable;
+    }
+
+    const std::vector<double>&
+    table() const
+    {
+      return values;
+    }
+
+    std::size_t
+    size() const
+    {
+      return cell_num;
+    }
+
+    // Maximal runs of owned cells along k. The position p0 of a run
+    // is that of its first id in the box.
+    std::size_t
+    run_size() const
+    {
+      return runs.size();
+    }
+
+    const Run&
+    run(std::size_t r) const
+    {
+      return runs[r];
+    }
+
+    // Ids of the cells of a run.
+    const unsigned char*
+    row(const Run& run) const
+    {
+      return &ids[run.p0];
+    }
+
+  private:
+    void
+    build(const RunList& idx_list, const CoeffCnt& coeffs, double min_fill)
+    {
+      cell_num = idx_list.size();
+      usable = false;
+      ids.clear();
+      runs.clear();
+      values.assign(1, 0);
+
+      if (idx_list.run_size() == 0)
+	return;
+
+      int i1 = i0 = idx_list.run(0).i;
+      int j1 = j0 = idx_list.run(0).j;
+      int k1 = k0 = idx_list.run(0).k0;
+      for (std::size_t r = 0; r < idx_list.run_size(); ++r) {
+	const Run& run = idx_list.run(r);
+	i0 = std::min(i0, run.i);
+	i1 = std::max(i1, run.i);
+	j0 = std::min(j0, run.j);
+	j1 = std::max(j1, run.j);
+	k0 = std::min(k0, run.k0);
+	k1 = std::max(k1, run.k0 + run.len - 1);
+      }
+      ni = i1 - i0 + 1;
+      nj = j1 - j0 + 1;
+      nk = k1 - k0 + 1;
+
+      const double box = static_cast<double>(ni) * nj * nk;
+      if (cell_num < min_fill * box)
+	return;
+
+      ids.assign(static_cast<std::size_t>(ni) * nj * nk, 0);
+      std::size_t pos = 0;
+      for (std::size_t r = 0; r < idx_list.run_size(); ++r) {
+	const Run& run = idx_list.run(r);
+	unsigned char* const id = &ids[(static_cast<std::size_t>(run.i - i0) * nj
+					+ (run.j - j0)) * nk + (run.k0 - k0)];
+	for (int l = 0; l < run.len; ++l) {
+	  const double value = coeffs[run.p0 + l];
+	  if (pos == 0 || values[pos] != value)
+	    pos = std::find(values.begin() + 1, values.end(), value)
+	      - values.begin();
+	  if (pos == values.size()) {
+	    if (values.size() > 255) {
+	      ids.clear();
+	      values.assign(1, 0);
+	      return;
+	    }
+	    values.push_back(value);
+	  }
+	  id[l] = static_cast<unsigned char>(pos);
+	}
+      }
+
+      for (int i = 0; i < ni; ++i) {
+	for (int j = 0; j < nj; ++j) {
+	  const std::size_t row0 = (static_cast<std::size_t>(i) * nj + j) * nk;
+	  int k = 0;
+	  while (k < nk) {
+	    if (ids[row0 + k] == 0) {
+	      ++k;
+	      continue;
+	    }
+
+	    Run run;
+	    run.i = i0 + i;
+	    run.j = j0 + j;
+	    run.k0 = k0 + k;
+	    run.p0 = row0 + k;
+	    while (k < nk && ids[row0 + k] != 0)
+	      ++k;
+	    run.len = k0 + k - run.k0;
+	    runs.push_back(run);
+	  }
+	}
+      }
+
+      usable = true;
+    }
+
+    std::size_t cell_num;
+    bool usable;
+    int i0, j0, k0, ni, nj, nk;
+    std::vector<unsigned char> ids;
+    std::vector<Run> runs;
+    std::vector<double> values;
+  }; // class CoeffGrid
+
+  // Open addressing hash table from a cell index to its position in
+  // the index list of a pw material. The index list only grows
+  // through attach and merge, so the table catches up with the cells
+  // appended since the last lookup and is rebuilt when the list
+  // shrinks.
+  template <typename Index>
+  class CellIndex
+  {
+  public:
+    CellIndex():
+      cell_num(0), bits(0)
+    {
+    }
+
+    // Return the position of idx in idx_list, or -1 if absent.
+    // Duplicated cells resolve to their first position.
+    template <typename IndexList>
+    int
+    position(const IndexList& idx_list, const Index& idx) const
+    {
+      sync(idx_list);
+
+      if (slots.empty())
+	return -1;
+
+      return slots[find(idx)].pos;
+    }
+
+  private:
+    struct Slot
+    {
+      Index key;
+      int pos;
+    }; // struct Slot
+
+    template <typename IndexList>
+    void
+    sync(const IndexList& idx_list) const
+    {
+      if (idx_list.size() < cell_num) {
+	slots.clear();
+	cell_num = 0;
+      }
+
+      if (idx_list.size() == cell_num)
+	return;
+
+      // Keep the load factor at or below one half.
+      if (2 * idx_list.size() > slots.size()) {
+	std::size_t new_bits = 4;
+	while ((static_cast<std::size_t>(1) << new_bits) < 2 * idx_list.size())
+	  ++new_bits;
+
+	std::vector<Slot> old_slots(static_cast<std::size_t>(1) << new_bits);
+	for (std::size_t h = 0; h < old_slots.size(); ++h) {
+	  old_slots[h].pos = -1;
+	}
+	old_slots.swap(slots);
+	bits = new_bits;
+
+	for (std::size_t h = 0; h < old_slots.size(); ++h) {
+	  if (old_slots[h].pos >= 0)
+	    slots[find(old_slots[h].key)] = old_slots[h];
+	}
+      }
+
+      for (; cell_num < idx_list.size(); ++cell_num) {
+	const Index idx = idx_list[cell_num];
+	Slot& slot = slots[find(idx)];
+	if (slot.pos < 0) {
+	  slot.key = idx;
+	  slot.pos = static_cast<int>(cell_num);
+	}
+      }
+    }
+
+    // Return the slot holding idx, or the empty slot where it goes.
+    std::size_t
+    find(const Index& idx) const
+    {
+      const std::size_t mask = slots.size() - 1;
+      std::size_t h = hash(idx);
+      while (slots[h].pos >= 0 && !(slots[h].key == idx))
+	h = (h + 1) & mask;
+
+      return h;
+    }
+
+    // Fibonacci hashing of the packed cell index.
+    std::size_t
+    hash(const Index& idx) const
+    {
+      unsigned long long key = 0;
+      for (std::size_t n = 0; n < idx.size(); ++n) {
+	key = (key << 21) ^ static_cast<unsigned int>(idx[n]);
+      }
+
+      return static_cast<std::size_t>((key * 11400714819323198485ULL)
+				      >> (64 - bits));
+    }
+
+    mutable std::vector<Slot> slots;
+    mutable std::size_t cell_num, bits;
+  }; // template CellIndex
+
+  // Return the m-th entry of every element of rows.
+  template <typename V, std::size_t N>
+  std::vector<V>
+  column(const std::vector<std::array<V, N> >& rows, std::size_t m)
+  {
+    std::vector<V> col;
+    col.reserve(rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      col.push_back(rows[i][m]);
+    }
+
+    return col;
+  }
+} // namespace gmes
+
+#endif // STORAGE_HH_
@@ -0,0 +1,160 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+import os, sys
+new_path = os.path.abspath('../')
+sys.path.append(new_path)
+
+import unittest
+import numpy as np
+from shutil import rmtree
+from tempfile import mkdtemp
+
+from gmes.fdtd import FDTD
+from gmes.constant import Ex
+from gmes.geometry import Cartesian, DefaultMedium, Sphere, Block
+from gmes.material import Dielectric, Drude, DrudePole
+
+
+class TestSequence(unittest.TestCase):
+    def setUp(self):
+        self.spc = Cartesian((1, 1, 1), resolution=8)
+
+    def geometry(self, radius=.3):
+        dp1 = DrudePole(omega=.5, gamma=.1)
+        dp2 = DrudePole(omega=.7, gamma=.2)
+        dp3 = DrudePole(omega=.3, gamma=.05)
+        metal1 = Drude(eps_inf=1, mu_inf=1, sigma=0, dps=(dp1,))
+        metal2 = Drude(eps_inf=2, mu_inf=1, sigma=.1, dps=(dp2, dp3))
+        return [DefaultMedium(Dielectric()),
+                Sphere(metal1, radius=radius),
+                Block(metal2, center=(.2, .2, .2), size=(.4, .4, .4))]
+
+    def fdtd(self, geom_list=None, material_cache=None):
+        if geom_list is None:
+            geom_list = self.geometry()
+        fdtd = FDTD(self.spc, geom_list, [], material_cache=material_cache,
+                    verbose=False)
+        fdtd.init()
+        return fdtd
+
+    def fill(self, *fdtds):
+        """Set the same random fields at the mesh points updated by the
+        node.
+
+        """
+        spc = self.spc
+        coords = spc.cart_comm.Get_coords(0)
+        a = fdtds[0]
+        for comp in a.e_field_compnt + a.h_field_compnt:
+            lo, hi = a._owned_box(comp, spc.bounds, coords)
+            box = tuple(slice(lo[i], hi[i]) for i in xrange(3))
+            values = np.random.random_sample(a.field[comp][box].shape)
+            for fdtd in fdtds:
+                fdtd.field[comp][box] = values
+
+    def states(self, fdtd):
+        states = {}
+        for comp, pw_material in fdtd.pw_material.iteritems():
+            for pw_type, pw_obj in pw_material.iteritems():
+                if pw_obj.state_size() == 0:
+                    continue
+                indices = np.empty((pw_obj.idx_size(), 3), np.intc)
+                pw_obj.get_indices(indices)
+                state = np.empty((len(indices), pw_obj.state_size()))
+                pw_obj.get_state(indices, state)
+                states[comp, pw_type.__name__] = indices, state
+        return states
+
+    def testMigrate(self):
+        a = self.fdtd()
+        b = self.fdtd()
+
+        # Only the mesh points updated by the node are set, since the
+        # migration moves only them.
+        self.fill(a, b)
+        spc = self.spc
+        coords = [tuple(spc.cart_comm.Get_coords(0))]
+
+        for n in xrange(3):
+            a.step()
+            b.step()
+
+        states = self.states(a)
+        self.assertTrue(states)
+        self.assertTrue(any(np.any(state != 0)
+                            for indices, state in states.itervalues()))
+
+        b._migrate(spc.bounds, coords)
+        for comp in a.e_field_compnt + a.h_field_compnt:
+            self.assertTrue(np.all(a.field[comp] == b.field[comp]))
+
+        migrated = self.states(b)
+        self.assertEqual(sorted(migrated), sorted(states))
+        for key, (indices, state) in states.iteritems():
+            self.assertTrue(np.all(migrated[key][0] == indices))
+            self.assertTrue(np.all(migrated[key][1] == state))
+
+        for n in xrange(3):
+            a.step()
+            b.step()
+        for comp in a.e_field_compnt + a.h_field_compnt:
+            self.assertTrue(np.all(a.field[comp] == b.field[comp]))
+
+    def testMaterialCache(self):
+        tmp = mkdtemp()
+        try:
+            cache = os.path.join(tmp, 'materials')
+            uncached = self.fdtd()
+            first = self.fdtd(material_cache=cache)
+            self.assertTrue(first._material_key is not None)
+
+            # the ids and the table of every component
+            compnt = first.e_field_compnt + first.h_field_compnt
+            files = sorted(os.listdir(cache))
+            self.assertEqual(len(files), 2 * len(compnt))
+            inodes = [os.stat(os.path.join(cache, f)).st_ino for f in files]
+
+            # The second run loads the memory-mapped ids.
+            second = self.fdtd(material_cache=cache)
+            self.assertEqual(second._material_key, first._material_key)
+            self.assertEqual(sorted(os.listdir(cache)), files)
+            self.assertEqual([os.stat(os.path.join(cache, f)).st_ino
+                              for f in files], inodes)
+            ids, table = second._cached_material_ids(second.ex.shape, Ex,
+                                                     None)
+            self.assertTrue(isinstance(ids, np.memmap))
+
+            for comp in compnt:
+                pw_material = uncached.pw_material[comp]
+                cached = second.pw_material[comp]
+                self.assertEqual(sorted(cached, key=str), 
+                                 sorted(pw_material, key=str))
+                for pw_type, pw_obj in pw_material.iteritems():
+                    self.assertEqual(cached[pw_type].idx_size(), 
+                                     pw_obj.idx_size())
+                    indices = np.empty((pw_obj.idx_size(), 3), np.intc)
+                    pw_obj.get_indices(indices)
+                    cached_indices = np.empty_like(indices)
+                    cached[pw_type].get_indices(cached_indices)
+                    self.assertEqual(sorted(map(tuple, indices)),
+                                     sorted(map(tuple, cached_indices)))
+
+            self.fill(uncached, second)
+            for n in xrange(3):
+                uncached.step()
+                second.step()
+            for comp in compnt:
+                self.assertTrue(np.all(uncached.field[comp] == 
+                                       second.field[comp]))
+
+            # A different geometry has a different key.
+            other = self.fdtd(self.geometry(radius=.35), cache)
+            self.assertNotEqual(other._material_key, first._material_key)
+            self.assertEqual(len(os.listdir(cache)), 4 * len(compnt))
+        finally:
+            rmtree(tmp)
+
+
+if __name__ == '__main__':
+    unittest.main(argv=('', '-v'))
@@ -0,0 +1,170 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+import os, sys
+new_path = os.path.abspath('../')
+sys.path.append(new_path)
+
+import unittest
+import numpy as np
+from shutil import rmtree
+from tempfile import mkdtemp
+
+from gmes.geometry import Cartesian, CellCost, AuxiCartComm
+from gmes.geometry import _read_calibration, _write_calibration
+
+try:
+    from mpi4py import MPI
+except ImportError:
+    MPI = None
+
+
+def cell_cost(cost):
+    """Return a CellCost with a run of one cell for every cell of cost.
+
+    """
+    idx = np.array(list(np.ndindex(cost.shape)), np.int)
+    runs = np.column_stack((idx, idx[:, 2] + 1))
+    return CellCost(cost.shape, runs, cost.ravel())
+
+
+class LoopComm(AuxiCartComm):
+    """A single node communicator which sends to itself.
+
+    """
+    size = 1
+
+    def Barrier(self):
+        pass
+
+
+class TestSequence(unittest.TestCase):
+    def setUp(self):
+        self.spc = Cartesian((4, 4, 4), resolution=2)
+        self.spc.dt = .1
+        self.size = tuple(self.spc.whole_field_size)
+
+        # a heavy plane at the bottom of the x- and the z-axis
+        self.skewed = np.ones(self.size)
+        self.skewed[0, :, :] = 100
+        self.skewed[:, :, 0] = 100
+
+    def testProfile(self):
+        cost = np.random.random_sample(self.size)
+        sample = cell_cost(cost)
+        for axis in xrange(3):
+            other = tuple(i for i in xrange(3) if i != axis)
+            self.assertTrue(np.allclose(sample.profile(axis),
+                                        cost.sum(axis=other)))
+
+        # the same cost in runs along the z-axis
+        cost = np.ones(self.size)
+        cost[2:4, 1, 3:6] = 5
+        runs = [(2, 1, 0, 3), (2, 1, 3, 6), (2, 1, 6, 8),
+                (3, 1, 0, 3), (3, 1, 3, 6), (3, 1, 6, 8)]
+        value = [1, 5, 1, 1, 5, 1]
+        for i, j in np.ndindex(self.size[:2]):
+            if j != 1 or i not in (2, 3):
+                runs.append((i, j, 0, self.size[2]))
+                value.append(1)
+        sample = CellCost(self.size, runs, value)
+        for axis in xrange(3):
+            other = tuple(i for i in xrange(3) if i != axis)
+            self.assertTrue(np.allclose(sample.profile(axis),
+                                        cost.sum(axis=other)))
+
+    def testBlockSums(self):
+        cost = np.random.random_sample(self.size)
+        sample = cell_cost(cost)
+        bounds = (np.array((0, 3, 8)), np.array((0, 8)),
+                  np.array((0, 1, 5, 8)))
+
+        block = cost
+        for i in xrange(3):
+            block = np.add.reduceat(block, bounds[i][:-1], i)
+        self.assertTrue(np.allclose(sample.block_sums(bounds), block))
+
+        factor = np.random.random_sample(block.shape)
+        sample.scale(bounds, factor)
+        self.assertTrue(np.allclose(sample.block_sums(bounds),
+                                    block * factor))
+
+    def testBalancedBounds(self):
+        uniform = cell_cost(np.ones(self.size))
+        bounds = self.spc.balanced_bounds((4, 2, 1), uniform)
+        self.assertEqual(list(bounds[0]), [0, 2, 4, 6, 8])
+        self.assertEqual(list(bounds[1]), [0, 4, 8])
+        self.assertEqual(list(bounds[2]), [0, 8])
+
+        # Every slab keeps at least one mesh point.
+        cost = np.ones(self.size)
+        cost[0] = 100
+        bounds = self.spc.balanced_bounds((4, 1, 1), cell_cost(cost))
+        self.assertEqual(list(bounds[0]), [0, 1, 2, 3, 8])
+
+        cost = np.ones(self.size)
+        cost[-1] = 100
+        bounds = self.spc.balanced_bounds((4, 1, 1), cell_cost(cost))
+        self.assertEqual(list(bounds[0]), [0, 5, 6, 7, 8])
+
+    def testLoadMetric(self):
+        uniform = cell_cost(np.ones(self.size))
+        for dims in (1, 1, 1), (2, 1, 1), (2, 2, 2), (1, 4, 2):
+            self.assertAlmostEqual(self.spc.load_metric(*dims),
+                                   self.spc.load_metric(cost=uniform,
+                                                        *dims))
+
+        skewed = cell_cost(self.skewed)
+        self.assertTrue(self.spc.load_metric(2, 1, 1, skewed) >
+                        self.spc.load_metric(1, 2, 1, skewed))
+
+    def testBestDeploy(self):
+        self.spc.numprocs = 2
+        self.assertEqual(self.spc.find_best_deploy(), (1, 1, 2))
+
+        # Only the split along the y-axis halves the heavy planes.
+        skewed = cell_cost(self.skewed)
+        self.assertEqual(self.spc.find_best_deploy(skewed), (1, 2, 1))
+
+    def testBalance(self):
+        bounds = self.spc.bounds
+        self.spc.balance(cell_cost(self.skewed))
+        for i in xrange(3):
+            self.assertEqual(list(self.spc.bounds[i]), list(bounds[i]))
+        self.assertEqual(list(self.spc.my_field_size), list(self.size))
+
+    def testCalibrationCache(self):
+        tmp = mkdtemp()
+        try:
+            cache = os.path.join(tmp, 'calibration')
+            self.assertEqual(_read_calibration(cache), {})
+
+            _write_calibration(cache, '2 node0,node1', 1234.5)
+            _write_calibration(cache, '1 node0', 1 / 3.)
+            _write_calibration(cache, '2 node0,node1', 987.25)
+            self.assertEqual(_read_calibration(cache),
+                             {'1 node0': 1 / 3., '2 node0,node1': 987.25})
+        finally:
+            rmtree(tmp)
+
+    @unittest.skipIf(MPI is None, 'mpi4py is not available')
+    def testCalibrate(self):
+        tmp = mkdtemp()
+        try:
+            cache = os.path.join(tmp, 'calibration')
+            comm = LoopComm()
+            ratio = self.spc.calibrate(comm, cache)
+            self.assertTrue(ratio > 0)
+
+            key = '1 %s' % MPI.Get_processor_name()
+            self.assertEqual(_read_calibration(cache), {key: ratio})
+
+            # The later runs take the cached ratio.
+            _write_calibration(cache, key, 42.)
+            self.assertEqual(self.spc.calibrate(comm, cache), 42.)
+        finally:
+            rmtree(tmp)
+
+
+if __name__ == '__main__':
+    unittest.main(argv=('', '-v'))
@@ -119,6 +119,26 @@ class TestSequence(unittest.TestCase):
         for idx in np.ndindex(3, 3, 3):
             self.assertEqual(hz[idx], 0)
 
+    def testManyReal(self):
+        indices = np.array(((1,1,1), (1,1,2)), np.intc)
+        coords = np.array(((0,0,0), (0,0,0.25)))
+        sample = self.cpml.get_pw_material_ex(indices, coords)
+        self.assertEqual(sample.idx_size(), 2)
+        
+        reference = self.cpml.get_pw_material_ex(indices[0], coords[0])
+        reference.merge(self.cpml.get_pw_material_ex(indices[1], coords[1]))
+
+        hz = np.random.random_sample((3,3,3))
+        hy = np.random.random_sample((3,3,3))
+        ex = np.zeros((3,3,3))
+        ex_ref = np.zeros((3,3,3))
+        dy = dz = dt = 1
+        for n in xrange(3):
+            sample.update_all(ex, hz, hy, dy, dz, dt, n)
+            reference.update_all(ex_ref, hz, hy, dy, dz, dt, n)
+        for idx in np.ndindex(3, 3, 3):
+            self.assertEqual(ex[idx], ex_ref[idx])
+
     def testExCmplx(self):
         sample = self.cpml.get_pw_material_ex(self.idx, (0,0,0), cmplx=True)
         
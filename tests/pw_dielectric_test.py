@@ -10,6 +10,7 @@ import numpy as np
 from random import random
 
 from gmes.material import Dielectric
+from gmes.pw_material import set_num_threads, get_num_threads, simd_path
 from gmes.geometry import Cartesian    
 
 
@@ -125,6 +126,201 @@ class TestSequence(unittest.TestCase):
         for idx in np.ndindex(3, 3, 3):
             self.assertEqual(hz[idx], 0)
 
+    def testRunReal(self):
+        indices = np.array(((1,1,0), (1,1,1)), np.intc)
+        sample = self.dielectric.get_pw_material_ex(indices, np.zeros((2,3)))
+
+        ex = np.zeros((3,3,3))
+        hz = np.random.random_sample((3,3,3))
+        hy = np.random.random_sample((3,3,3))
+        dy = dz = dt = 1
+        n = 0
+        sample.update_all(ex, hz, hy, dy, dz, dt, n)
+        for idx in np.ndindex(3, 3, 3):
+            i, j, k = idx
+            if (i, j) == (1, 1) and k < 2:
+                value = dt / self.dielectric.eps_inf * \
+                    ((hz[i+1,j+1,k] - hz[i+1,j,k]) / dy - 
+                     (hy[i+1,j,k+1] - hy[i+1,j,k]) / dz)
+                self.assertAlmostEqual(ex[idx], value)
+            else:
+                self.assertEqual(ex[idx], 0)
+
+    def testRunSingle(self):
+        indices = np.array(((1,1,0), (1,1,1)), np.intc)
+        sample = self.dielectric.get_pw_material_ex(indices, np.zeros((2,3)),
+                                                    single=True)
+
+        ex = np.zeros((3,3,3), np.float32)
+        hz = np.random.random_sample((3,3,3)).astype(np.float32)
+        hy = np.random.random_sample((3,3,3)).astype(np.float32)
+        dy = dz = dt = 1
+        n = 0
+        sample.update_all(ex, hz, hy, dy, dz, dt, n)
+        for idx in np.ndindex(3, 3, 3):
+            i, j, k = idx
+            if (i, j) == (1, 1) and k < 2:
+                value = dt / self.dielectric.eps_inf * \
+                    ((hz[i+1,j+1,k] - hz[i+1,j,k]) / dy - 
+                     (hy[i+1,j,k+1] - hy[i+1,j,k]) / dz)
+                self.assertTrue(abs(ex[idx] - value) <= 1e-6 * abs(value))
+            else:
+                self.assertEqual(ex[idx], 0)
+
+    def testSparseReal(self):
+        # The cells fill a quarter of their bounding box, so they are
+        # updated run by run instead of by the grid sweep.
+        cells = [(i, i, k) for i in xrange(1, 5) for k in (1, 2)]
+        indices = np.array(cells, np.intc)
+        sample = self.dielectric.get_pw_material_ex(indices, np.zeros((len(cells),3)))
+
+        ex = np.zeros((6,6,6))
+        hz = np.random.random_sample((6,6,6))
+        hy = np.random.random_sample((6,6,6))
+        dy, dz, dt = .5, .25, 1
+        n = 0
+        sample.update_all(ex, hz, hy, dy, dz, dt, n)
+        for idx in np.ndindex(6, 6, 6):
+            i, j, k = idx
+            if idx in cells:
+                value = dt / self.dielectric.eps_inf * \
+                    ((hz[i+1,j+1,k] - hz[i+1,j,k]) / dy - 
+                     (hy[i+1,j,k+1] - hy[i+1,j,k]) / dz)
+                self.assertAlmostEqual(ex[idx], value)
+            else:
+                self.assertEqual(ex[idx], 0)
+
+    def testSparseSingle(self):
+        cells = [(i, i, k) for i in xrange(1, 5) for k in (1, 2)]
+        indices = np.array(cells, np.intc)
+        sample = self.dielectric.get_pw_material_ex(indices, np.zeros((len(cells),3)),
+                                                    single=True)
+
+        ex = np.zeros((6,6,6), np.float32)
+        hz = np.random.random_sample((6,6,6)).astype(np.float32)
+        hy = np.random.random_sample((6,6,6)).astype(np.float32)
+        dy, dz, dt = .5, .25, 1
+        n = 0
+        sample.update_all(ex, hz, hy, dy, dz, dt, n)
+        for idx in np.ndindex(6, 6, 6):
+            i, j, k = idx
+            if idx in cells:
+                value = dt / self.dielectric.eps_inf * \
+                    ((hz[i+1,j+1,k] - hz[i+1,j,k]) / dy - 
+                     (hy[i+1,j,k+1] - hy[i+1,j,k]) / dz)
+                self.assertTrue(abs(ex[idx] - value) <= 1e-5 * abs(value))
+            else:
+                self.assertEqual(ex[idx], 0)
+
+    def testGridReal(self):
+        cells = [(i+1, j+1, k+1) for i, j, k in np.ndindex(3, 3, 3)]
+        cells.remove((3,3,3))
+        indices = np.array(cells, np.intc)
+        sample = self.dielectric.get_pw_material_hx(indices, np.zeros((len(cells),3)))
+
+        hx = np.zeros((4,4,4))
+        ez = np.random.random_sample((4,4,4))
+        ey = np.random.random_sample((4,4,4))
+        dy = dz = dt = 1
+        n = 0
+        sample.update_all(hx, ez, ey, dy, dz, dt, n)
+        for idx in np.ndindex(4, 4, 4):
+            i, j, k = idx
+            if idx in cells:
+                value = dt / self.dielectric.mu_inf * \
+                    ((ey[i,j-1,k] - ey[i,j-1,k-1]) / dz - 
+                     (ez[i,j,k-1] - ez[i,j-1,k-1]) / dy)
+                self.assertAlmostEqual(hx[idx], value)
+            else:
+                self.assertEqual(hx[idx], 0)
+
+    def testGridUnownedReal(self):
+        cells = [(i+1, j+1, k+1) for i, j, k in np.ndindex(3, 3, 3)]
+        cells.remove((3,3,3))
+        indices = np.array(cells, np.intc)
+        sample = self.dielectric.get_pw_material_hx(indices, np.zeros((len(cells),3)))
+
+        # Only the cell (3,3,3), which the material does not own,
+        # reads ey[3,2,3].
+        hx = np.zeros((4,4,4))
+        ez = np.random.random_sample((4,4,4))
+        ey = np.random.random_sample((4,4,4))
+        ey[3,2,3] = np.inf
+        dy = dz = dt = 1
+        n = 0
+        sample.update_all(hx, ez, ey, dy, dz, dt, n)
+        self.assertEqual(hx[3,3,3], 0)
+        self.assertTrue(np.all(np.isfinite(hx)))
+
+    def testThreadsReal(self):
+        indices = np.array(list(np.ndindex(16, 16, 16)), np.intc)
+        hz = np.random.random_sample((17,17,17))
+        hy = np.random.random_sample((17,17,17))
+        dy = dz = dt = 1
+        n = 0
+
+        num_threads = get_num_threads()
+        ex = []
+        for threads in (1, 4):
+            set_num_threads(threads)
+            sample = self.dielectric.get_pw_material_ex(indices, np.zeros((len(indices),3)))
+            ex.append(np.zeros((17,17,17)))
+            sample.update_all(ex[-1], hz, hy, dy, dz, dt, n)
+        set_num_threads(num_threads)
+
+        self.assertTrue(np.all(ex[0] == ex[1]))
+
+    def testBoundReal(self):
+        indices = np.array(list(np.ndindex(3, 3, 3)), np.intc)
+        sample = self.dielectric.get_pw_material_ex(indices, np.zeros((len(indices),3)))
+
+        ex = [np.zeros((4,4,4)), np.zeros((4,4,4))]
+        hz = np.random.random_sample((4,4,4))
+        hy = np.random.random_sample((4,4,4))
+        dy = dz = dt = 1
+        sample.bind(ex[1], hz, hy, dy, dz, dt)
+        for n in xrange(3):
+            sample.update_all(ex[0], hz, hy, dy, dz, dt, n)
+            sample.update_bound(n)
+            hz[1,1,1] += 1
+
+        self.assertTrue(np.all(ex[0] == ex[1]))
+
+    def testSplitReal(self):
+        indices = np.array(list(np.ndindex(3, 3, 3)), np.intc)
+        sample = self.dielectric.get_pw_material_ex(indices, np.zeros((len(indices),3)))
+
+        ex = [np.zeros((4,4,4)), np.zeros((4,4,4))]
+        hz = np.random.random_sample((4,4,4))
+        hy = np.random.random_sample((4,4,4))
+        dy = dz = dt = 1
+        n = 0
+        sample.update_all(ex[0], hz, hy, dy, dz, dt, n)
+
+        sample.bind(ex[1], hz, hy, dy, dz, dt)
+        sample.split(np.array((0,1,1), np.intc), np.array((3,2,2), np.intc))
+        sample.update_interior(n)
+        self.assertEqual(np.count_nonzero(ex[1]), 3)
+        sample.update_shell(n)
+        self.assertTrue(np.all(ex[0] == ex[1]))
+
+    def testSimdPath(self):
+        self.assertTrue(simd_path() in ('avx512', 'avx2', 'generic'))
+
+    def testManyReal(self):
+        sample = \
+            self.dielectric.get_pw_material_ex(self.idx, (0,0,0), cmplx=False)
+        indices = np.array(list(np.ndindex(3, 3, 3)), np.intc)
+        eps_inf = sample.get_eps_inf_many(indices, len(indices))
+        for idx, value in zip(indices, eps_inf):
+            self.assertEqual(value, sample.get_eps_inf(idx))
+
+        sample = \
+            self.dielectric.get_pw_material_hx(self.idx, (0,0,0), cmplx=False)
+        mu_inf = sample.get_mu_inf_many(indices, len(indices))
+        for idx, value in zip(indices, mu_inf):
+            self.assertEqual(value, sample.get_mu_inf(idx))
+
     def testExCmplx(self):
         sample = \
             self.dielectric.get_pw_material_ex(self.idx, (0,0,0), cmplx=True)
@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+import os, sys
+new_path = os.path.abspath('../')
+sys.path.append(new_path)
+
+import unittest
+import numpy as np
+
+from gmes.material import Dm2
+from gmes.geometry import Cartesian
+
+
+class TestSequence(unittest.TestCase):
+    def setUp(self):
+        self.spc = Cartesian((0, 0, 0))
+        self.spc.dt = .05
+
+        self.rtol = 1e-6
+        self.steps = 10
+        self.indices = np.array([(1, 1, k) for k in xrange(10)], np.intc)
+
+    def update(self, solver):
+        dm2 = Dm2(omega=(1, 1.1), n_atom=(.2, .25), rho30=-1, gamma=.3,
+                  t1=50, t2=20, rtol=self.rtol, solver=solver)
+        dm2.init(self.spc)
+        sample = dm2.get_pw_material_ex(self.indices,
+                                        np.zeros((len(self.indices),3)))
+
+        ex = np.cos(.3 * np.arange(3 * 3 * 10)).reshape(3, 3, 10)
+        hz = np.zeros((3,3,10))
+        hy = np.sin(.7 * np.arange(3 * 3 * 11)).reshape(3, 3, 11)
+        dy = dz = 1
+        dt = self.spc.dt
+        for n in xrange(self.steps):
+            sample.update_all(ex, hz, hy, dy, dz, dt, n)
+
+        return sample, ex
+
+    def testSolverReal(self):
+        fixed_point, ex_fixed_point = self.update('fixed-point')
+        newton, ex_newton = self.update('newton')
+        self.assertTrue(np.allclose(ex_fixed_point, ex_newton,
+                                    rtol=self.rtol, atol=self.rtol))
+
+        cell_num = self.steps * len(self.indices)
+        for sample in fixed_point, newton:
+            self.assertEqual(sample.solved_num(), cell_num)
+            self.assertTrue(sample.iteration_num() >= cell_num)
+            self.assertTrue(sample.max_iteration_num() >= 1)
+
+            sample.reset_stats()
+            self.assertEqual(sample.solved_num(), 0)
+            self.assertEqual(sample.iteration_num(), 0)
+            self.assertEqual(sample.max_iteration_num(), 0)
+
+    def testStatsReal(self):
+        sample, ex = self.update('newton')
+        hz = np.zeros((3,3,10))
+        hy = np.zeros((3,3,11))
+        solved_num = sample.solved_num()
+        iteration_num = sample.iteration_num()
+        sample.update_all(ex, hz, hy, 1, 1, self.spc.dt, self.steps)
+        self.assertEqual(sample.solved_num(), solved_num + len(self.indices))
+        self.assertTrue(sample.iteration_num() > iteration_num)
+
+    def reference(self, dm2, e, curl, steps):
+        """Return the field and the density matrix vectors of a cell
+        after steps by the predictor-corrector iteration of dm2.
+
+        """
+        dt = self.spc.dt
+        omega, n_atom = np.array(dm2.omega), np.array(dm2.n_atom)
+        gamma, t1, t2, hbar = dm2.gamma, dm2.t1, dm2.t2, dm2.hbar
+
+        u = np.zeros((len(omega), 3))
+        for n in xrange(steps):
+            t = (n + .5) * dt
+            a = n_atom * gamma / t2 * np.exp(-t / t2)
+            b = n_atom * gamma * omega * np.exp(-t / t2)
+            c_plus = 2 / hbar * gamma * np.exp(-t * (1 / t1 - 1 / t2))
+            c_minus = 2 / hbar * gamma * np.exp(-t * (1 / t2 - 1 / t1))
+            d = 2 / hbar * gamma * dm2.rho30 * np.exp(t / t2)
+
+            e_old, e_free = e, e - dt * curl
+            u_new = u.copy()
+            while True:
+                e_prev, u_prev = e, u_new.copy()
+                e = (e_free - .5 * dt * np.sum(a * (u_new[:,0] + u[:,0])) +
+                     .5 * dt * np.sum(b * (u_new[:,1] + u[:,1])))
+                s = e + e_old
+                u_new[:,0] = u[:,0] + .5 * dt * omega * (u_new[:,1] + u[:,1])
+                u_new[:,1] = (u[:,1] - 
+                              .5 * dt * omega * (u_new[:,0] + u[:,0]) +
+                              .25 * dt * c_plus * (u_new[:,2] + u[:,2]) * s +
+                              .5 * dt * d * s)
+                u_new[:,2] = (u[:,2] - 
+                              .25 * dt * c_minus * (u_new[:,1] + u[:,1]) * s)
+                change = np.append(e - e_prev, u_new - u_prev)
+                if np.linalg.norm(change) <= \
+                        dm2.rtol * np.linalg.norm(np.append(e, u_new)):
+                    break
+            u = u_new
+
+        return e, u
+
+    def testReferenceReal(self):
+        for solver in 'fixed-point', 'newton':
+            # two parameter sets in an object
+            dm2_a = Dm2(omega=(1, 1.1), n_atom=(.2, .25), rho30=-1, 
+                        gamma=.3, t1=50, t2=20, rtol=1e-12, solver=solver)
+            dm2_b = Dm2(omega=(.9, 1.2), n_atom=(.3, .1), rho30=-.8, 
+                        gamma=.4, t1=30, t2=10, rtol=1e-12, solver=solver)
+            dm2_a.init(self.spc)
+            dm2_b.init(self.spc)
+            dm2 = [dm2_a] * 5 + [dm2_b] * 5
+            sample = dm2_a.get_pw_material_ex(self.indices[:5], 
+                                              np.zeros((5, 3)))
+            sample.merge(dm2_b.get_pw_material_ex(self.indices[5:],
+                                                  np.zeros((5, 3))))
+
+            ex = np.cos(.3 * np.arange(3 * 3 * 10)).reshape(3, 3, 10)
+            hz = np.zeros((3,3,10))
+            hy = np.sin(.7 * np.arange(3 * 3 * 11)).reshape(3, 3, 11)
+            e_init = ex[1, 1].copy()
+            dy = dz = 1
+            dt = self.spc.dt
+            for n in xrange(self.steps):
+                sample.update_all(ex, hz, hy, dy, dz, dt, n)
+
+            t = self.steps * dt
+            for k, idx in enumerate(self.indices):
+                m = dm2[k]
+                curl = (hy[2, 1, k + 1] - hy[2, 1, k]) / dz
+                e, u = self.reference(m, e_init[k], curl, self.steps)
+                self.assertTrue(np.allclose(ex[tuple(idx)], e, 
+                                            rtol=1e-9, atol=1e-12))
+
+                idx = tuple(idx)
+                decay1, decay2 = np.exp(-t / m.t1), np.exp(-t / m.t2)
+                for got, want in ((sample.get_u(idx, t, 2), 
+                                   decay2 * u[:,0]),
+                                  (sample.get_v(idx, t, 2), 
+                                   decay2 * u[:,1]),
+                                  (sample.get_w(idx, t, 2), 
+                                   m.rho30 + decay1 * u[:,2])):
+                    self.assertTrue(np.allclose(got, want, 
+                                                rtol=1e-9, atol=1e-12))
+                for i in xrange(2):
+                    for rho_idx, want in enumerate(
+                        (decay2 * u[i,0], decay2 * u[i,1], 
+                         m.rho30 + decay1 * u[i,2])):
+                        self.assertAlmostEqual(
+                            sample.get_rho(idx, i, rho_idx, t), want, 9)
+
+    def testSolverName(self):
+        self.assertRaises(ValueError, Dm2, solver='bisection')
+
+
+if __name__ == '__main__':
+    unittest.main(argv=('', '-v'))
@@ -222,6 +222,134 @@ class TestSequence(unittest.TestCase):
         for idx in np.ndindex(3, 3, 3):
             self.assertEqual(hz[idx], 0j)
 
+    def testMergeReal(self):
+        dp1 = DrudePole(omega=.5, gamma=.1)
+        dp2 = DrudePole(omega=.7, gamma=.2)
+        dp3 = DrudePole(omega=.3, gamma=.05)
+        metal1 = Drude(eps_inf=1, mu_inf=1, sigma=0, dps=(dp1,))
+        metal1.init(self.spc)
+        metal2 = Drude(eps_inf=2, mu_inf=1, sigma=.1, dps=(dp2, dp3))
+        metal2.init(self.spc)
+
+        idx1, idx2 = (1, 1, 1), (1, 1, 2)
+        sample = metal1.get_pw_material_ex(idx1, (0,0,0))
+        sample.merge(metal2.get_pw_material_ex(idx2, (0,0,0)))
+
+        self.assertEqual(sample.idx_size(), 2)
+        for idx in np.ndindex(3, 3, 3):
+            if idx == idx1:
+                self.assertEqual(sample.get_eps_inf(idx), metal1.eps_inf)
+            elif idx == idx2:
+                self.assertEqual(sample.get_eps_inf(idx), metal2.eps_inf)
+            else:
+                self.assertEqual(sample.get_eps_inf(idx), 0)
+
+        # The 1-pole cell of the merged object has a zero padded pole,
+        # which must not change its update.
+        reference1 = metal1.get_pw_material_ex(idx1, (0,0,0))
+        reference2 = metal2.get_pw_material_ex(idx2, (0,0,0))
+
+        hz = np.random.random_sample((4,4,4))
+        hy = np.random.random_sample((4,4,4))
+        ex = np.zeros((4,4,4))
+        ex_ref = np.zeros((4,4,4))
+        dy = dz = dt = self.spc.dt
+        for n in xrange(3):
+            sample.update_all(ex, hz, hy, dy, dz, dt, n)
+            reference1.update_all(ex_ref, hz, hy, dy, dz, dt, n)
+            reference2.update_all(ex_ref, hz, hy, dy, dz, dt, n)
+            hz[2,2,1] += 1
+            hy[2,1,3] -= 1
+        self.assertNotEqual(ex[idx1], 0)
+        self.assertNotEqual(ex[idx2], 0)
+        for idx in np.ndindex(4, 4, 4):
+            self.assertEqual(ex[idx], ex_ref[idx])
+
+    def testStateCmplx(self):
+        src = self.gold.get_pw_material_ex(self.idx, (0,0,0), cmplx=True)
+        dest = self.gold.get_pw_material_ex(self.idx, (0,0,0), cmplx=True)
+        self.assertEqual(src.state_size(), 4)
+
+        hz = np.random.random_sample((3,3,3)) + 1j
+        hy = np.random.random_sample((3,3,3)) - 1j
+        ex = np.zeros((3,3,3), complex)
+        dy = dz = dt = 1
+        for n in xrange(3):
+            src.update_all(ex, hz, hy, dy, dz, dt, n)
+
+        indices = np.empty((src.idx_size(), 3), np.intc)
+        src.get_indices(indices)
+        self.assertTrue(np.all(indices == self.idx))
+
+        state = np.zeros((len(indices), src.state_size()))
+        src.get_state(indices, state)
+        self.assertTrue(np.any(state != 0))
+        dest.set_state(indices, state, 
+                       src.get_state_sizes(src.state_arrays()))
+
+        copied = np.zeros_like(state)
+        dest.get_state(indices, copied)
+        self.assertTrue(np.all(copied == state))
+
+        ex_dest = ex.copy()
+        src.update_all(ex, hz, hy, dy, dz, dt, 3)
+        dest.update_all(ex_dest, hz, hy, dy, dz, dt, 3)
+        self.assertTrue(np.all(ex == ex_dest))
+
+    def testStateMigrateReal(self):
+        dp1 = DrudePole(omega=.5, gamma=.1)
+        dp2 = DrudePole(omega=.7, gamma=.2)
+        dp3 = DrudePole(omega=.3, gamma=.05)
+        metal1 = Drude(eps_inf=1, mu_inf=1, sigma=0, dps=(dp1,))
+        metal1.init(self.spc)
+        metal2 = Drude(eps_inf=2, mu_inf=1, sigma=.1, dps=(dp2, dp3))
+        metal2.init(self.spc)
+
+        # The state moves from a mixed-pole object to a 1-pole one.
+        idx1, idx2 = (1, 1, 1), (1, 1, 2)
+        src = metal1.get_pw_material_ex(idx1, (0,0,0))
+        src.merge(metal2.get_pw_material_ex(idx2, (0,0,0)))
+        dest = metal1.get_pw_material_ex(idx1, (0,0,0))
+        reference = metal1.get_pw_material_ex(idx1, (0,0,0))
+
+        sizes = src.get_state_sizes(src.state_arrays())
+        self.assertEqual(list(sizes), [2, 2])
+        self.assertEqual(list(dest.get_state_sizes(dest.state_arrays())), 
+                         [1, 1])
+
+        hz = np.random.random_sample((4,4,4))
+        hy = np.random.random_sample((4,4,4))
+        ex = np.zeros((4,4,4))
+        ex_ref = np.zeros((4,4,4))
+        dy = dz = dt = self.spc.dt
+        for n in xrange(3):
+            src.update_all(ex, hz, hy, dy, dz, dt, n)
+            reference.update_all(ex_ref, hz, hy, dy, dz, dt, n)
+
+        indices = np.empty((src.idx_size(), 3), np.intc)
+        src.get_indices(indices)
+        state = np.zeros((len(indices), src.state_size()))
+        src.get_state(indices, state)
+        dest.set_state(indices, state, sizes)
+
+        copied = np.zeros((len(indices), dest.state_size()))
+        reference.get_state(indices, copied)
+        self.assertTrue(np.any(copied != 0))
+        migrated = np.zeros_like(copied)
+        dest.get_state(indices, migrated)
+        self.assertTrue(np.all(migrated[indices[:,2] == 1] == 
+                               copied[indices[:,2] == 1]))
+
+        ex_dest = ex.copy()
+        dest.update_all(ex_dest, hz, hy, dy, dz, dt, 3)
+        reference.update_all(ex_ref, hz, hy, dy, dz, dt, 3)
+        self.assertEqual(ex_dest[idx1], ex_ref[idx1])
+
+        # The state and the sizes must agree.
+        self.assertRaises(ValueError, dest.get_state, indices, state)
+        self.assertRaises(ValueError, dest.set_state, indices, state,
+                          dest.get_state_sizes(dest.state_arrays()))
+
 
 if __name__ == '__main__':
     unittest.main(argv=('', '-v'))
@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+import os, sys
+new_path = os.path.abspath('../')
+sys.path.append(new_path)
+
+import unittest
+import numpy as np
+
+from gmes.pw_material import HaloReal, HaloCmplx
+
+
+class TestSequence(unittest.TestCase):
+    def testPackReal(self):
+        field = np.random.random_sample((3,4,5))
+        buf = np.empty(3 * 5)
+        halo = HaloReal(1, 0, 3, 1)
+        halo.pack(field, buf)
+        self.assertTrue(np.all(buf == field[:, 0, :].ravel()))
+
+        plane = field[:, 0, :].copy()
+        halo.unpack(field, buf)
+        self.assertTrue(np.all(field[:, 3, :] == plane))
+
+    def testBufSizeReal(self):
+        field = np.random.random_sample((3,4,5))
+        halo = HaloReal(1, 0, 3, 1)
+        for size in (3 * 5 - 1, 3 * 5 + 1):
+            buf = np.zeros(size)
+            self.assertRaises(ValueError, halo.pack, field, buf)
+            self.assertRaises(ValueError, halo.unpack, field, buf)
+        self.assertTrue(np.all(field[:, 3, :] != 0))
+
+    def testWrapCmplx(self):
+        field = np.random.random_sample((3,4,5)) + 0j
+        ref = field.copy()
+        phase = np.exp(0.5j)
+        halo = HaloCmplx(2, 4, 0, phase)
+        halo.wrap(field)
+        ref[:, :, 0] = phase * ref[:, :, 4]
+        self.assertTrue(np.allclose(field, ref))
+
+        buf = np.empty(3 * 4, complex)
+        halo.pack(field, buf)
+        halo.unpack(field, buf)
+        ref[:, :, 0] = phase * ref[:, :, 4]
+        self.assertTrue(np.allclose(field, ref))
+
+
+if __name__ == '__main__':
+    unittest.main(argv=('', '-v'))
+
@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+import os, sys
+new_path = os.path.abspath('../')
+sys.path.append(new_path)
+
+import unittest
+import numpy as np
+from random import random
+
+from gmes.material import Dielectric
+from gmes.pw_material import StepperReal
+from gmes.geometry import Cartesian
+
+
+class TestSequence(unittest.TestCase):
+    def setUp(self):
+        self.spc = Cartesian((0, 0, 0))
+        self.spc.dt = 1
+
+        self.dielectric = Dielectric(eps_inf=random(), mu_inf=random())
+        self.dielectric.init(self.spc)
+
+    def testStepReal(self):
+        e_idx = np.array(list(np.ndindex(3, 3, 3)), np.intc)
+        h_idx = e_idx + 1
+        coords = np.zeros((len(e_idx),3))
+
+        pw_obj = [self.dielectric.get_pw_material_ex(e_idx, coords),
+                  self.dielectric.get_pw_material_ey(e_idx, coords),
+                  self.dielectric.get_pw_material_ez(e_idx, coords),
+                  self.dielectric.get_pw_material_hx(h_idx, coords),
+                  self.dielectric.get_pw_material_hy(h_idx, coords),
+                  self.dielectric.get_pw_material_hz(h_idx, coords)]
+
+        field = [np.random.random_sample((4,4,4)) for i in xrange(6)]
+        ex, ey, ez, hx, hy, hz = ref = [f.copy() for f in field]
+        dx = dy = dz = dt = 1
+        steps = 5
+
+        stepper = StepperReal()
+        stepper.set_fields(*field)
+        stepper.set_space(dx, dy, dz, dt)
+        for comp, o in enumerate(pw_obj):
+            stepper.attach_material(comp, o)
+        values = np.random.random_sample(steps)
+        stepper.attach_source(2, np.array((1,1,1), np.intc), values, 
+                              False, 1)
+        n = stepper.step_until_n(0, steps)
+        self.assertEqual(n, steps)
+
+        n = 0
+        for i in xrange(steps):
+            n += 0.5
+            pw_obj[0].update_all(ex, hz, hy, dy, dz, dt, n)
+            pw_obj[1].update_all(ey, hx, hz, dz, dx, dt, n)
+            pw_obj[2].update_all(ez, hy, hx, dx, dy, dt, n)
+            ez[1,1,1] = values[i]
+            n += 0.5
+            pw_obj[3].update_all(hx, ez, ey, dy, dz, dt, n)
+            pw_obj[4].update_all(hy, ex, ez, dz, dx, dt, n)
+            pw_obj[5].update_all(hz, ey, ex, dx, dy, dt, n)
+
+        for f, r in zip(field, ref):
+            self.assertTrue(np.all(f == r))
+
+
+if __name__ == '__main__':
+    unittest.main(argv=('', '-v'))
+
@@ -119,6 +119,39 @@ class TestSequence(unittest.TestCase):
         for idx in np.ndindex(3, 3, 3):
             self.assertEqual(hz[idx], 0)
 
+    def testHxStepsReal(self):
+        cells = ((1,1,1), (1,1,2), (2,2,1))
+        coords = ((.8,.7,.9), (.8,.7,.6), (-.9,.5,.75))
+        indices = np.array(cells, np.intc)
+        sample = self.upml.get_pw_material_hx(indices, coords)
+
+        coeffs = [(self.upml.c1(pt[1], 1), self.upml.c2(pt[1], 1),
+                   self.upml.c3(pt[2], 2), self.upml.c4(pt[2], 2),
+                   self.upml.c5(pt[0], 0), self.upml.c6(pt[0], 0))
+                  for pt in coords]
+
+        hx = np.zeros((4,4,4))
+        hx_ref = np.zeros((4,4,4))
+        b = np.zeros(len(cells))
+        dy, dz, dt = .5, .25, 1
+        for n in xrange(3):
+            ez = np.random.random_sample((4,4,4))
+            ey = np.random.random_sample((4,4,4))
+            sample.update_all(hx, ez, ey, dy, dz, dt, n)
+
+            # The auxiliary b of each cell carries over to the next step.
+            for p, (i, j, k) in enumerate(cells):
+                c1, c2, c3, c4, c5, c6 = coeffs[p]
+                curl = (ez[i,j,k-1] - ez[i,j-1,k-1]) / dy - \
+                    (ey[i,j-1,k] - ey[i,j-1,k-1]) / dz
+                b_new = c1 * b[p] - c2 * curl
+                hx_ref[i,j,k] = c3 * hx_ref[i,j,k] + \
+                    c4 * (c5 * b_new - c6 * b[p]) / self.upml.mu_inf
+                b[p] = b_new
+
+            for idx in np.ndindex(4, 4, 4):
+                self.assertAlmostEqual(hx[idx], hx_ref[idx])
+
     def testExCmplx(self):
         sample = \
             self.upml.get_pw_material_ex(self.idx, (0,0,0), cmplx=True)
@@ -0,0 +1,168 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+import os, sys
+new_path = os.path.abspath('../')
+sys.path.append(new_path)
+
+import unittest
+import numpy as np
+
+from gmes.geometry import Cartesian, GeomBoxTree, DefaultMedium
+from gmes.geometry import Cone, Cylinder, Block, Ellipsoid, Sphere, Shell
+from gmes.geometry import Lattice
+from gmes.material import Dielectric, Cpml, Compound
+
+
+class TestSequence(unittest.TestCase):
+    def setUp(self):
+        self.spc = Cartesian((2, 2, 2), resolution=10)
+        self.spc.dt = .05
+
+        # oblique and overlapping objects, and a Compound shell over them
+        self.geom_list = [DefaultMedium(Dielectric()),
+                          Block(Dielectric(2), center=(.1, .2, 0),
+                                e1=(1, 1, 0), e2=(-1, 1, .3),
+                                e3=(0, .2, 1), size=(.8, .5, .6)),
+                          Cone(Dielectric(3), center=(-.5, .1, .2),
+                               radius2=.1, axis=(1, 1, 1), radius=.4,
+                               height=.9),
+                          Ellipsoid(Dielectric(4), center=(.3, -.3, .1),
+                                    e1=(1, .5, 0), e2=(0, 1, 1),
+                                    e3=(1, 0, 1), size=(.9, .4, .5)),
+                          Sphere(Dielectric(5), center=(0, 0, 0),
+                                 radius=.3),
+                          Cylinder(Dielectric(6), center=(0, .6, 0),
+                                   axis=(0, .1, 1), radius=.2, height=3),
+                          Shell(Cpml(), thickness=.3)]
+        for geom_obj in self.geom_list:
+            geom_obj.init(self.spc)
+        self.tree = GeomBoxTree(self.geom_list)
+
+        # the cell centers and some points off the grid
+        size = self.spc.whole_field_size
+        self.axes = [(np.arange(size[i]) + .5) * self.spc.dr[i] -
+                     self.spc.half_size[i] for i in xrange(3)]
+        grid = np.array([(x, y, z) for x in self.axes[0]
+                         for y in self.axes[1] for z in self.axes[2]])
+        off = 2 * np.random.random_sample((500, 3)) - 1
+        self.points = np.concatenate((grid, off))
+
+    def find_object(self, point, geom_list):
+        """Return the index of the last object including point, like
+        find_object of pygeom, by the in_object of every object.
+
+        """
+        i = len(geom_list) - 1
+        while i > 0 and not geom_list[i].in_object(point):
+            i -= 1
+        return i
+
+    def testObjectOfPoint(self):
+        for p in self.points:
+            p = tuple(p)
+            geom_obj, underneath_obj = self.tree.object_of_point(p)
+
+            i = self.find_object(p, self.geom_list)
+            self.assertTrue(geom_obj is self.geom_list[i])
+            if isinstance(geom_obj.material, Compound):
+                j = self.find_object(p, self.geom_list[:i])
+                self.assertTrue(underneath_obj is self.geom_list[j])
+            else:
+                self.assertTrue(underneath_obj is None)
+
+    def testMaterialsOfPoints(self):
+        obj, under = self.tree.materials_of_points(self.points)
+        self.assertEqual(obj.shape, (len(self.points),))
+        self.assertEqual(under.shape, (len(self.points),))
+
+        index = dict((id(g), i) for i, g in enumerate(self.geom_list))
+        for n, p in enumerate(self.points):
+            geom_obj, underneath_obj = self.tree.object_of_point(tuple(p))
+            self.assertEqual(obj[n], index[id(geom_obj)])
+            if underneath_obj is None:
+                self.assertEqual(under[n], -1)
+            else:
+                self.assertEqual(under[n], index[id(underneath_obj)])
+
+        # Every object and the shell over some of them are met.
+        self.assertEqual(set(obj), set(xrange(len(self.geom_list))))
+        self.assertTrue(len(set(under[obj == len(self.geom_list) - 1])) > 1)
+
+    def testRasterize(self):
+        runs = self.tree.rasterize(*self.axes)
+        self.assertEqual(runs.dtype, np.intc)
+        self.assertTrue(np.array_equal(runs, 
+                                       self.tree.rasterize_by_points(*self.axes)))
+
+        # The runs cover the grid in order, and agree with the points.
+        size = tuple(len(a) for a in self.axes)
+        obj = np.repeat(runs[:, 4], runs[:, 3] - runs[:, 2])
+        under = np.repeat(runs[:, 5], runs[:, 3] - runs[:, 2])
+        self.assertEqual(obj.size, np.prod(size))
+        ref_obj, ref_under = \
+            self.tree.materials_of_points(self.points[:obj.size])
+        self.assertTrue(np.all(obj == ref_obj))
+        self.assertTrue(np.all(under == ref_under))
+
+        # The neighbouring runs of a row differ.
+        same_row = np.all(runs[1:, :2] == runs[:-1, :2], 1)
+        self.assertTrue(np.all(runs[1:, 2][same_row] ==
+                               runs[:-1, 3][same_row]))
+        self.assertTrue(np.all(np.any(runs[1:, 4:] != runs[:-1, 4:], 1)
+                               [same_row]))
+
+        # a part of the grid, and an empty one
+        xs, ys, zs = self.axes[0][3:7], self.axes[1][::3], self.axes[2][5:]
+        self.assertTrue(np.array_equal(self.tree.rasterize(xs, ys, zs),
+                                       self.tree.rasterize_by_points(xs, ys, zs)))
+        self.assertEqual(self.tree.rasterize(xs, [], zs).shape, (0, 6))
+
+    def testLattice(self):
+        basis = np.array(((.5, 0, 0), (.25, .4, 0)))
+        center = np.array((.05, -.02, 0))
+        size = np.array((2.1, 1.7, 1))
+        removed = ((0, 0), (1, -1))
+        motif = Cylinder(Dielectric(2), radius=.15, height=.8)
+        lattice = Lattice(motif, basis, center, size, removed)
+        lattice.init(self.spc)
+
+        # the same sites as an explicit list of cylinders
+        cylinders = []
+        for n in np.ndindex(21, 21):
+            n = (n[0] - 10, n[1] - 10)
+            site = n[0] * basis[0] + n[1] * basis[1]
+            if np.all(abs(site) <= .5 * size) and n not in removed:
+                cylinder = Cylinder(Dielectric(2), center=center + site,
+                                    radius=.15, height=.8)
+                cylinder.init(self.spc)
+                cylinders.append(cylinder)
+        self.assertEqual(len(cylinders), 21)
+
+        points = np.concatenate((self.points, 
+                                 (np.random.random_sample((2000, 3)) - .5) *
+                                 (2.6, 2.2, 1.2)))
+        inside = [lattice.in_object(tuple(p)) for p in points]
+        for p, is_in in zip(points, inside):
+            self.assertEqual(is_in, 
+                             any(c.in_object(tuple(p)) for c in cylinders))
+        self.assertTrue(any(inside))
+        self.assertFalse(all(inside))
+        self.assertFalse(lattice.in_object(tuple(center)))
+
+        # and on the grid, by the rows
+        medium = DefaultMedium(Dielectric())
+        medium.init(self.spc)
+        tree = GeomBoxTree([medium, lattice])
+        ref_tree = GeomBoxTree([medium] + cylinders)
+        runs = tree.rasterize(*self.axes)
+        self.assertTrue(np.array_equal(runs, 
+                                       tree.rasterize_by_points(*self.axes)))
+        obj = np.repeat(runs[:, 4], runs[:, 3] - runs[:, 2])
+        ref_obj, ref_under = \
+            ref_tree.materials_of_points(self.points[:obj.size])
+        self.assertTrue(np.all((obj > 0) == (ref_obj > 0)))
+
+
+if __name__ == '__main__':
+    unittest.main(argv=('', '-v'))